@@ -17,12 +17,17 @@
 #include <QMediaRecorder>
 #include <QMediaFormat>
 #include <QCoreApplication>
-#include <QHttpMultiPart>
-#include <QHttpPart>
+#include <QNetworkInformation>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <algorithm>
 #if QT_CONFIG(permissions)
 #include <QPermission>
 #endif
 #include "audiohandler.h"
+#include "audioresampler.h"
+#include "flacencoder.h"
+#include "networkmanager.h"
 
 // Since this is a singleton, we need to declare the static instance
 AudioHandler *AudioHandler::instance = nullptr;
@@ -30,14 +35,31 @@ AudioHandler *AudioHandler::instance = nullptr;
 /**
  * @name AudioHandler (Constructor)
  * @brief Initializes the AudioHandler instance
- * @details Sets up the network manager. The API keys are initialized by
- * Settings.
+ * @details Sets up the transcription backends on the shared network manager
+ * and the segment recorders. The API keys are initialized by Settings.
  * @see Settings
  * @author Andres Pedreros Castro
  */
 AudioHandler::AudioHandler() : QObject(nullptr)
 {
-    networkManager = new QNetworkAccessManager(this);
+    // Transcription engines, chosen per recording by chooseBackend()
+    whisperBackend = new WhisperBackend(NetworkManager::getInstance());
+    googleBackend = new GoogleSpeechBackend(NetworkManager::getInstance());
+    localBackend = new LocalWhisperBackend;
+    registerBackend(whisperBackend);
+    registerBackend(googleBackend);
+    registerBackend(localBackend);
+    QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Reachability);
+
+    // Transcribe each recording segment as soon as it has been written
+    segmentedRecorder = new SegmentedRecorder(this);
+    connect(segmentedRecorder, &SegmentedRecorder::segmentFinished, this, &AudioHandler::transcribeSegment);
+    connect(segmentedRecorder, &SegmentedRecorder::recordingFinished, this, &AudioHandler::finishSegmentedRecording);
+
+    // Alternative recorder that processes audio while it is captured
+    streamingCapture = new StreamingCapture(this);
+    connect(streamingCapture, &StreamingCapture::segmentFinished, this, &AudioHandler::transcribeSegment);
+    connect(streamingCapture, &StreamingCapture::recordingFinished, this, &AudioHandler::finishSegmentedRecording);
 }
 
 /**
@@ -63,360 +85,1018 @@ AudioHandler *AudioHandler::getInstance()
 
 /**
  * @name transcribe
- * @brief Transcribes the audio file using Google Speech-to-Text API
- * @details This function checks the duration and channel count of the audio file.
- * If the duration is longer than 60 seconds or if the audio is not stereo (2 channels),
- * it uses the Whisper API for transcription. Otherwise, it uses Google Speech-to-Text API.
- * It returns a Transcript object containing the transcribed text.
- * @note The function emits a signal when the transcription is completed.
- * @see getAudioDuration
+ * @brief Starts transcribing an audio file in the background
+ * @details The fastest registered backend that can process the recording
+ * is chosen from its limits and expected latency; see chooseBackend().
+ * A transcript of the same audio made earlier is returned from
+ * TranscriptCache without uploading anything. Otherwise long silences are
+ * removed and the audio is compressed losslessly to FLAC on a worker thread, then uploaded without waiting for the response; the returned job reports progress and
+ * emits the Transcript once the response arrives. Recordings longer than the
+ * chunk length are split at pauses and the chunks are transcribed in
+ * parallel. Any number of jobs may run at the same time.
+ * @see TranscriptionJob
  * @param[in] filename: Path to the audio file
- * @return Transcript object containing the transcribed text
+ * @return Handle to the transcription job. The job deletes itself after it ends.
  * @author Andres Pedreros Castro
  * @author Callum Thompson
  */
-Transcript AudioHandler::transcribe(const QString &filename)
+TranscriptionJob *AudioHandler::transcribe(const QString &filename)
 {
-    // Determine audio properties
-    double durationSecs = getAudioDuration(filename);
-    int channelCount = getAudioChannelCount(filename);
+    TranscriptionJob *job = new TranscriptionJob(++lastJobId, filename, this);
+
+    // Any backend's transcript of the same audio, prepared the same way, can be reused
+    QList<QPair<QString, QString>> identities;
+    for (TranscriptionBackend *backend : backends)
+    {
+        identities.append({backend->name(), backend->configuration()});
+    }
+    QString settings = QString("trim=%1;chunk=%2").arg(trimSilence ? "on" : "off").arg(chunkLengthSecs);
+    bool useCache = cacheTranscripts;
+
+    // Check the cache, trim silence and compress to FLAC on a worker thread, then upload from this thread
+    QPointer<TranscriptionJob> guardedJob(job); // The job may be cancelled and deleted while encoding
+    bool trim = trimSilence;
+    int chunkSecs = chunkLengthSecs;
+    AudioMetadataCache::getInstance(); // Create the shared caches on this thread
+    TranscriptCache::getInstance();
+    QThreadPool::globalInstance()->start([this, guardedJob, filename, trim, chunkSecs, identities, settings, useCache]()
+    {
+        QString audioKey = useCache ? TranscriptCache::audioKey(filename, settings) : QString();
+        if (!audioKey.isEmpty())
+        {
+            QString cached;
+            for (const QPair<QString, QString> &identity : identities)
+            {
+                if (TranscriptCache::getInstance()->lookup(TranscriptCache::entryKey(audioKey, identity.first, identity.second), cached))
+                {
+                    QMetaObject::invokeMethod(this, [this, guardedJob, filename, cached]()
+                    {
+                        if (guardedJob && !guardedJob->isDone())
+                        {
+                            qInfo() << "Using cached transcript of" << filename;
+                            completeJob(guardedJob, nullptr, cached);
+                        }
+                    }, Qt::QueuedConnection);
+                    return;
+                }
+            }
+        }
 
-    QString response;
+        QList<UploadChunk> chunks = encodeForUpload(filename, trim, chunkSecs);
+        QMetaObject::invokeMethod(this, [this, guardedJob, filename, chunks, audioKey]()
+        {
+            if (guardedJob)
+            {
+                guardedJob->cacheKey = audioKey;
+            }
+            uploadForTranscription(guardedJob, filename, chunks);
+        }, Qt::QueuedConnection);
+    });
+    return job;
+}
 
-    // Use Whisper if longer than 60s or not stereo (2 channels)
-    if (durationSecs > 60.0 || channelCount != 2)
+/**
+ * @name completeJob
+ * @brief Completes a transcription job and caches its transcript
+ * @param[in] job: Job to complete
+ * @param[in] backend: Backend that transcribed the audio, or nullptr if
+ * the transcript came from the cache
+ * @param[in] text: Transcript of the recording
+ * @author Callum Thompson
+ */
+void AudioHandler::completeJob(TranscriptionJob *job, TranscriptionBackend *backend, const QString &text)
+{
+    if (backend && !job->cacheKey.isEmpty())
     {
-        qInfo() << "Using Whisper (OpenAI)";
-        response = sendToWhisperAPI(filename);
+        TranscriptCache::getInstance()->store(TranscriptCache::entryKey(job->cacheKey, backend->name(), backend->configuration()), text);
     }
-    else
+    job->complete(Transcript(getCurrentTime(), text));
+}
+
+/**
+ * @name encodeForUpload
+ * @brief Prepares a recording for upload
+ * @details Long silences are found with VoiceActivityDetector and left out,
+ * and the remaining spans are encoded straight from the mapped WAV file to
+ * FLAC. Audio longer than `chunkSecs` is split at pauses into chunks that
+ * are each encoded as a separate FLAC stream, keeping every chunk below the
+ * Whisper upload limit. Runs on a worker thread.
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] trimSilence: True to remove long silences
+ * @param[in] chunkSecs: Preferred length of each chunk in seconds
+ * @return Encoded chunks in recording order, or an empty list if the file
+ * could not be encoded
+ * @author Callum Thompson
+ */
+QList<UploadChunk> AudioHandler::encodeForUpload(const QString &audioPath, bool trimSilence, int chunkSecs)
+{
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+    if (!metadata.isPcm16() || metadata.channels > 8 || metadata.frameCount == 0)
     {
-        qInfo() << "Using Google Speech-to-Text";
-        response = sendToGoogleSpeechAPI(filename);
+        return {};
     }
 
-    // Handle failure to get a valid response
-    if (response.isEmpty())
+    QFile file(audioPath);
+    const uchar *data = file.open(QIODevice::ReadOnly) ? file.map(metadata.dataOffset, metadata.frameCount * metadata.blockAlign) : nullptr;
+    if (!data)
     {
-        emit transcriptionCompleted("Transcription failed");
-        return Transcript(getCurrentTime(), "");
+        qWarning() << "Could not map audio file for encoding:" << audioPath;
+        return {};
     }
+    const qint16 *samples = reinterpret_cast<const qint16 *>(data);
 
-     // Parse the JSON response
-    QString result;
-    QJsonDocument doc = QJsonDocument::fromJson(response.toUtf8());
-    if (!doc.isObject())
+    // Keep everything if trimming is off or no speech was detected
+    VoiceActivityDetector detector(metadata.sampleRate, metadata.channels);
+    QList<VoiceActivityDetector::Span> spans;
+    if (trimSilence)
+    {
+        spans = detector.detectSpeech(samples, metadata.frameCount);
+    }
+    if (spans.isEmpty())
     {
-        emit transcriptionCompleted("Invalid response format");
-        return Transcript(getCurrentTime(), "");
+        spans.append({0, metadata.frameCount});
     }
 
-    // Extract transcribed text depending on which service was used
-    if (durationSecs > 60.0 || channelCount != 2)
+    // Chunks may grow 25% past the target, so the target leaves room for that
+    // below the upload limit even if FLAC does not compress the audio at all
+    qint64 keptFrames = 0;
+    for (const VoiceActivityDetector::Span &span : spans)
     {
-        // Whisper returns a flat "text" field
-        result = doc.object().value("text").toString();
+        keptFrames += span.end - span.start;
+    }
+    qint64 targetFrames = qMin<qint64>(qint64(chunkSecs) * metadata.sampleRate, WHISPER_UPLOAD_LIMIT / metadata.blockAlign) * 4 / 5;
+    QList<QList<VoiceActivityDetector::Span>> chunkSpans;
+    if (targetFrames > 0 && keptFrames > targetFrames * 5 / 4)
+    {
+        chunkSpans = detector.splitIntoChunks(spans, samples, targetFrames);
     }
     else
     {
-         // Google Speech returns a nested array of results and alternatives
-        QJsonArray results = doc.object().value("results").toArray();
-        for (const QJsonValue &val : results)
+        chunkSpans.append(spans);
+    }
+
+    QList<UploadChunk> chunks;
+    for (const QList<VoiceActivityDetector::Span> &group : chunkSpans)
+    {
+        UploadChunk chunk;
+        FlacEncoder encoder(metadata.sampleRate, metadata.channels);
+        QByteArray frames;
+        chunk.timeMap.setSampleRate(metadata.sampleRate);
+        for (const VoiceActivityDetector::Span &span : group)
         {
-            QJsonArray alternatives = val.toObject().value("alternatives").toArray();
-            if (!alternatives.isEmpty())
-            {
-                result += alternatives[0].toObject().value("transcript").toString();
-            }
+            encoder.encode(samples + span.start * metadata.channels, span.end - span.start, frames);
+            chunk.timeMap.appendSpan(span.start, span.end - span.start);
         }
+        encoder.finish(frames);
+        chunk.flac = encoder.streamHeader() + frames;
+        chunks.append(chunk);
     }
+    file.unmap(const_cast<uchar *>(data));
 
-    // Emit signal and return the transcript with timestamp
-    emit transcriptionCompleted(result);
-    return Transcript(getCurrentTime(), result);
+    return chunks;
 }
 
 /**
- * @name getAudioChannelCount
- * @brief Retrieves the number of audio channels in a WAV file
- * @details This function reads the WAV file header to determine the number of channels.
- * It assumes the file is in WAV format and uses a specific byte offset to read the channel count.
- * @note This function is specific to WAV files and may not work for other audio formats.
- * @see getAudioDuration
- * @param[in] audioPath: Path to the audio file
- * @return Number of audio channels
+ * @name uploadForTranscription
+ * @brief Sends an encoded recording to the chosen transcription backend
+ * @details Falls back to sending the WAV file itself if it could not be
+ * encoded. The backend is chosen from the length of the audio actually sent.
+ * A recording split into several chunks is sent with ChunkedTranscription.
+ * @param[in] job: Job the upload is for, or nullptr if it no longer exists
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] chunks: FLAC chunks of the file, or empty to send the WAV file
  * @author Andres Pedreros Castro
+ * @author Callum Thompson
  */
-int AudioHandler::getAudioChannelCount(const QString &audioPath) const
+void AudioHandler::uploadForTranscription(TranscriptionJob *job, const QString &audioPath, const QList<UploadChunk> &chunks)
 {
-    QFile file(audioPath);
+    // The job was cancelled while the audio was being encoded
+    if (!job || job->isDone())
+    {
+        return;
+    }
+
+    TrimmedAudioMap timeMap;
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+    timeMap.setSampleRate(metadata.sampleRate);
+    timeMap.setOriginalFrames(metadata.frameCount);
+    for (const UploadChunk &chunk : chunks)
+    {
+        timeMap.appendMap(chunk.timeMap);
+    }
+    job->timeMap = chunks.isEmpty() ? TrimmedAudioMap() : timeMap;
+    if (job->timeMap.removedSecs() > 0.0)
+    {
+        qInfo() << "Removed" << timeMap.removedSecs() << "s of silence from" << audioPath;
+        emit silenceRemoved(job->getId(), timeMap.removedSecs(), timeMap.removedSecs() + timeMap.keptSecs());
+    }
 
-    // Try to open the audio file in read-only mode
-    if (!file.open(QIODevice::ReadOnly))
-        return -1;
+    if (chunks.size() > 1)
+    {
+        uploadChunks(job, audioPath, chunks);
+        return;
+    }
 
-    file.seek(22); // Byte offset for number of channels in a WAV file header
-    char buffer[2];
-    file.read(buffer, 2);
-    file.close();
+    QByteArray flac = chunks.isEmpty() ? QByteArray() : chunks.first().flac;
+    double uploadSecs = uploadDuration(job, audioPath);
+    qint64 uploadBytes = chunks.isEmpty() ? QFileInfo(audioPath).size() : flac.size();
+    bool offline = isOffline();
+    TranscriptionBackend *backend = chooseBackend(metadata, uploadSecs, uploadBytes, !flac.isEmpty(), offline, false);
+    if (!backend)
+    {
+        qWarning() << "No transcription backend can process" << audioPath;
+        job->fail("No transcription service is available");
+        return;
+    }
 
-    // Combine the two bytes into a single 16-bit integer (little-endian)
-    int channels = static_cast<unsigned char>(buffer[0]) |
-                   (static_cast<unsigned char>(buffer[1]) << 8);
-    return channels;
+    // Race a second backend against a slow answer for short clips
+    if (hedging && uploadSecs <= hedgeMaxSecs)
+    {
+        TranscriptionBackend *secondary = chooseBackend(metadata, uploadSecs, uploadBytes, !flac.isEmpty(), offline, false, backend);
+        if (secondary)
+        {
+            startHedgedRequest(job, backend, secondary, audioPath, flac);
+            return;
+        }
+    }
+    startRequest(job, backend, audioPath, flac);
 }
 
 /**
- * @name sendToWhisperAPI
- * @brief Sends the audio file to Google Speech-to-Text API for transcription
- * @details This function prepares the audio file and sends it to the Whisper API for transcription.
- * It sets the necessary headers and handles the response.
- * It uses QNetworkAccessManager to send the request and receive the response.
- * @note The function emits a signal when the transcription is completed.
- * @param[in] audioPath: Path to the audio file
- * @return Response from the API as a string
+ * @name startHedgedRequest
+ * @brief Sends a short recording to a primary backend, hedged by a second one
+ * @details The secondary backend is only sent the audio if the primary has
+ * not answered within its usual latency for audio of this length.
+ * @see HedgedTranscription
+ * @param[in] job: Job the request is for
+ * @param[in] primary: Backend tried first
+ * @param[in] secondary: Backend raced against a slow primary
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] flac: FLAC encoding of the file, or empty to send the WAV file
  * @author Callum Thompson
  */
-QString AudioHandler::sendToWhisperAPI(const QString &audioPath)
+void AudioHandler::startHedgedRequest(TranscriptionJob *job, TranscriptionBackend *primary, TranscriptionBackend *secondary,
+                                      const QString &audioPath, const QByteArray &flac)
 {
-    // Abort if OpenAI API key is missing
-    if (openAIApiKey.isEmpty())
+    double uploadSecs = uploadDuration(job, audioPath);
+    int delayMs = hedgeDelayMs(primary, uploadSecs);
+    qInfo() << "Using" << primary->name() << "hedged by" << secondary->name() << "after" << delayMs << "ms";
+
+    // Owned by the job so cancelling the job aborts both requests
+    HedgedTranscription *transcription = new HedgedTranscription(primary, secondary, audioPath, flac, delayMs, job);
+    QPointer<TranscriptionJob> guardedJob(job);
+    connect(transcription, &HedgedTranscription::requestStarted, job, &TranscriptionJob::attachRequest);
+    // An aborted request only shows a latency when it had already run longer than usual
+    connect(transcription, &HedgedTranscription::latencyMeasured, this, [this, uploadSecs](TranscriptionBackend *backend, double secs, bool lowerBound)
     {
-        qWarning() << "OpenAI API Key is empty!";
-        return "";
-    }
+        double expectedSecs = backend->expectedLatencySecs(uploadSecs);
+        if (lowerBound)
+        {
+            latencyHistory[backend].recordLowerBound(secs, expectedSecs, HEDGE_PERCENTILE);
+        }
+        else
+        {
+            latencyHistory[backend].record(secs, expectedSecs);
+        }
+    });
+    connect(transcription, &HedgedTranscription::finished, this, [this, guardedJob, transcription](const QString &text, TranscriptionBackend *winner)
+    {
+        transcription->deleteLater();
+        if (!guardedJob || guardedJob->isDone())
+        {
+            return;
+        }
+        qInfo() << winner->name() << "answered first";
+        completeJob(guardedJob, winner, text);
+    });
+    connect(transcription, &HedgedTranscription::failed, this, [this, guardedJob, transcription](const QString &errorMessage, QNetworkReply *reply)
+    {
+        transcription->deleteLater();
+        if (!guardedJob || guardedJob->isDone())
+        {
+            return;
+        }
+        if (reply)
+        {
+            emit badRequest(reply); // Signal UI or logger about the failed request
+        }
+        guardedJob->fail(errorMessage);
+    });
+    transcription->start();
+}
 
-    // Set up the OpenAI Whisper endpoint and request
-    QUrl url("https://api.openai.com/v1/audio/transcriptions");
-    QNetworkRequest request(url);
+/**
+ * @name hedgeDelayMs
+ * @brief Returns how long to wait for a backend before hedging
+ * @details Uses the 90th percentile of the backend's recent latencies,
+ * relative to its own estimate, so only the slowest tenth of requests are
+ * sent twice. Until enough requests have been seen, the estimate is
+ * padded by half.
+ * @param[in] backend: Primary backend
+ * @param[in] uploadSecs: Length of the audio sent
+ * @return Hedge delay in milliseconds
+ * @author Callum Thompson
+ */
+int AudioHandler::hedgeDelayMs(TranscriptionBackend *backend, double uploadSecs) const
+{
+    LatencyHistory history = latencyHistory.value(backend);
+    double ratio = history.sampleCount() >= 5 ? history.percentileRatio(HEDGE_PERCENTILE) : 1.5;
+    return qRound(ratio * backend->expectedLatencySecs(uploadSecs) * 1000.0);
+}
 
-    // Add authorization header using bearer token
-    QString bearerToken = "Bearer " + openAIApiKey;
-    request.setRawHeader("Authorization", bearerToken.toUtf8());
+/**
+ * @name uploadDuration
+ * @brief Returns the length of the audio sent for a job
+ * @param[in] job: Job being uploaded
+ * @param[in] audioPath: Path to the WAV file
+ * @return Seconds kept after silence removal, or the file's length
+ * @author Callum Thompson
+ */
+double AudioHandler::uploadDuration(const TranscriptionJob *job, const QString &audioPath) const
+{
+    if (job->timeMap.keptSecs() > 0.0)
+    {
+        return job->timeMap.keptSecs();
+    }
+    return AudioMetadataCache::getInstance()->lookup(audioPath).durationSecs();
+}
 
-    // Create multipart form data for the POST request
-    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+/**
+ * @name startRequest
+ * @brief Sends a whole recording to one backend
+ * @param[in] job: Job the request is for
+ * @param[in] backend: Backend to transcribe with
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] flac: FLAC encoding of the file, or empty to send the WAV file
+ * @author Callum Thompson
+ */
+void AudioHandler::startRequest(TranscriptionJob *job, TranscriptionBackend *backend, const QString &audioPath, const QByteArray &flac)
+{
+    qInfo() << "Using" << backend->name();
+    TranscriptionRequest *request = backend->start(audioPath, flac);
 
-    // Prepare the audio file for upload
-    QFile *file = new QFile(audioPath);
-    if (!file->open(QIODevice::ReadOnly))
+    // Handle failure to send the request
+    if (!request)
     {
-        qWarning() << "Failed to open file for Whisper API:" << audioPath;
-        delete file;
-        return "";
+        job->fail("Transcription failed");
+        return;
     }
 
-    // Add the audio file to the multipart body
-    QHttpPart filePart;
-    filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
-                       QVariant("form-data; name=\"file\"; filename=\"" + QFileInfo(audioPath).fileName() + "\""));
-    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/wav"));
-    filePart.setBodyDevice(file);
-    file->setParent(multiPart); // Ensure file is cleaned up with multipart
-    multiPart->append(filePart);
+    job->attachRequest(request);
+    QPointer<TranscriptionJob> guardedJob(job); // The job may be cancelled and deleted before the request finishes
+    double expectedSecs = backend->expectedLatencySecs(uploadDuration(job, audioPath));
+    QElapsedTimer clock;
+    clock.start();
+    connect(request, &TranscriptionRequest::finished, this, [this, guardedJob, request, backend, audioPath, flac, expectedSecs, clock]()
+    {
+        if (request->isSuccessful())
+        {
+            latencyHistory[backend].record(clock.elapsed() / 1000.0, expectedSecs);
+        }
+        handleTranscriptionResult(guardedJob, request, backend, audioPath, flac);
+    });
+}
 
-    // Specify the model name ("whisper-1")
-    QHttpPart modelPart;
-    modelPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"model\""));
-    modelPart.setBody("whisper-1");
-    multiPart->append(modelPart);
+/**
+ * @name uploadChunks
+ * @brief Transcribes the chunks of a long recording in parallel
+ * @details The chunks go to the fastest backend that reports timestamps
+ * and accepts the largest chunk. At most `maxParallelUploads` chunks are
+ * in flight at once, fewer if the backend cannot run that many. The merged
+ * transcript completes the job; the first failed chunk fails it.
+ * @param[in] job: Job the upload is for
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] chunks: FLAC chunks of the file in recording order
+ * @author Callum Thompson
+ */
+void AudioHandler::uploadChunks(TranscriptionJob *job, const QString &audioPath, const QList<UploadChunk> &chunks)
+{
+    qint64 totalBytes = 0;
+    qint64 largestChunk = 0;
+    double longestChunkSecs = 0.0;
+    for (const UploadChunk &chunk : chunks)
+    {
+        totalBytes += chunk.flac.size();
+        largestChunk = qMax<qint64>(largestChunk, chunk.flac.size());
+        longestChunkSecs = qMax(longestChunkSecs, chunk.timeMap.keptSecs());
+    }
 
-    // Send the POST request
-    QNetworkReply *reply = networkManager->post(request, multiPart);
-    multiPart->setParent(reply); // Cleanup when reply is finished
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+    TranscriptionBackend *backend = chooseBackend(metadata, longestChunkSecs, largestChunk, true, isOffline(), true);
+    if (!backend)
+    {
+        qWarning() << "No transcription backend can process the chunks of" << audioPath;
+        job->fail("No transcription service is available");
+        return;
+    }
+    int concurrency = backend->capabilities().maxConcurrentRequests;
+    int parallel = concurrency > 0 ? qMin(maxParallelUploads, concurrency) : maxParallelUploads;
+    qInfo() << "Using" << backend->name() << "with" << chunks.size() << "chunks," << parallel << "at a time";
+    job->setExpectedUploadSize(totalBytes);
 
-    // Block execution until the request is done (synchronous wait)
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+    // Owned by the job so cancelling the job abandons the remaining chunks
+    ChunkedTranscription *transcription = new ChunkedTranscription(chunks, parallel,
+        [backend, audioPath](const UploadChunk &chunk) { return backend->start(audioPath, chunk.flac); }, job);
+    QPointer<TranscriptionJob> guardedJob(job);
+    connect(transcription, &ChunkedTranscription::requestStarted, job, &TranscriptionJob::attachRequest);
+    connect(transcription, &ChunkedTranscription::finished, this, [this, guardedJob, transcription, backend](const QString &text)
+    {
+        transcription->deleteLater();
+        if (!guardedJob || guardedJob->isDone())
+        {
+            return;
+        }
+        completeJob(guardedJob, backend, text);
+    });
+    connect(transcription, &ChunkedTranscription::failed, this, [this, guardedJob, transcription](const QString &errorMessage)
+    {
+        transcription->deleteLater();
+        if (!guardedJob || guardedJob->isDone())
+        {
+            return;
+        }
+        qWarning() << "Chunked transcription failed:" << errorMessage;
+        guardedJob->fail(errorMessage);
+    });
+    transcription->start();
+}
+
+/**
+ * @name handleTranscriptionResult
+ * @brief Completes a transcription job once its request has finished
+ * @details Results of cancelled jobs are discarded. If a network backend
+ * could not be reached, the recording is sent to a backend that works
+ * offline, if one is available.
+ * @param[in] job: Job the request was sent for, or nullptr if it no longer exists
+ * @param[in] request: Finished request
+ * @param[in] backend: Backend the request was sent to
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] flac: Audio that was sent, for a retry
+ * @author Andres Pedreros Castro
+ * @author Callum Thompson
+ */
+void AudioHandler::handleTranscriptionResult(TranscriptionJob *job, TranscriptionRequest *request, TranscriptionBackend *backend,
+                                             const QString &audioPath, const QByteArray &flac)
+{
+    request->deleteLater();
 
-    // Handle the response
-    QString response;
-    if (reply->error() == QNetworkReply::NoError)
+    // The job was cancelled and has already reported it
+    if (!job || job->isDone())
     {
-        response = reply->readAll();
+        return;
     }
-    else
+
+    // Handle failure to get a valid response
+    if (!request->isSuccessful())
     {
-        emit badRequest(reply); // Signal UI or logger about the failed request
-        qWarning() << "Whisper request failed:" << reply->errorString();
+        qWarning() << backend->name() << "request failed:" << request->errorString();
+
+        // Retry without the network if the service was unreachable
+        if (request->isNetworkFailure() && backend->capabilities().requiresNetwork)
+        {
+            AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+            double uploadSecs = uploadDuration(job, audioPath);
+            qint64 uploadBytes = flac.isEmpty() ? QFileInfo(audioPath).size() : flac.size();
+            TranscriptionBackend *fallback = chooseBackend(metadata, uploadSecs, uploadBytes, !flac.isEmpty(), true, false);
+            if (fallback)
+            {
+                startRequest(job, fallback, audioPath, flac);
+                return;
+            }
+        }
+
+        if (request->networkReply())
+        {
+            emit badRequest(request->networkReply()); // Signal UI or logger about the failed request
+        }
+        job->fail(request->errorString());
+        return;
     }
 
-    reply->deleteLater();
-    return response;
+    // Emit signal and complete the job with the timestamped transcript
+    completeJob(job, backend, request->text());
 }
 
+/**
+ * @name chooseBackend
+ * @brief Picks the backend expected to return a transcript soonest
+ * @details Backends that are not configured, cannot read the audio, or
+ * whose duration or size limits it exceeds are skipped. When offline, only
+ * backends that work without the network are considered.
+ * @param[in] metadata: Format of the recording
+ * @param[in] uploadSecs: Length of the audio to send
+ * @param[in] uploadBytes: Size of the audio to send
+ * @param[in] isFlac: True if the FLAC encoding is sent rather than the WAV file
+ * @param[in] offline: True to consider only backends that work offline
+ * @param[in] needTimestamps: True if segment timestamps are required
+ * @param[in] exclude: Backend not to choose, or nullptr
+ * @return Chosen backend, or nullptr if none can process the audio
+ * @author Callum Thompson
+ */
+TranscriptionBackend *AudioHandler::chooseBackend(const AudioMetadata &metadata, double uploadSecs, qint64 uploadBytes,
+                                                  bool isFlac, bool offline, bool needTimestamps,
+                                                  const TranscriptionBackend *exclude) const
+{
+    TranscriptionBackend *best = nullptr;
+    double bestLatency = 0.0;
+    for (TranscriptionBackend *backend : backends)
+    {
+        BackendCapabilities caps = backend->capabilities();
+        if (backend == exclude
+            || !backend->isAvailable()
+            || (offline && caps.requiresNetwork)
+            || (needTimestamps && !caps.providesTimestamps)
+            || (isFlac && !caps.acceptsFlac)
+            || (!isFlac && caps.requiresPcm16 && !metadata.isPcm16())
+            || (caps.maxDurationSecs > 0.0 && uploadSecs > caps.maxDurationSecs)
+            || (caps.maxUploadBytes > 0 && uploadBytes > caps.maxUploadBytes))
+        {
+            continue;
+        }
+
+        double latency = backend->expectedLatencySecs(uploadSecs);
+        if (!best || latency < bestLatency)
+        {
+            best = backend;
+            bestLatency = latency;
+        }
+    }
+    return best;
+}
 
 /**
- * @name sendToGoogleSpeechAPI
- * @brief Sends the audio file to Google Speech-to-Text API for transcription
- * @details This function prepares the audio file and sends it to the Google Speech-to-Text API for transcription.
- * It sets the necessary headers and handles the response.
- * It uses QNetworkAccessManager to send the request and receive the response.
- * @note The function emits a signal when the transcription is completed.
+ * @name getAudioChannelCount
+ * @brief Retrieves the number of audio channels in a WAV file
+ * @details Reads the channel count from the file's parsed "fmt " chunk.
+ * @see AudioMetadataCache
  * @param[in] audioPath: Path to the audio file
- * @return Response from the API as a string
+ * @return Number of audio channels, or -1 if the file is not a valid WAV file
  * @author Andres Pedreros Castro
  */
-QString AudioHandler::sendToGoogleSpeechAPI(const QString &audioPath)
+int AudioHandler::getAudioChannelCount(const QString &audioPath) const
 {
-    // Construct the Google Speech-to-Text API URL with your API key
-    QUrl url("https://speech.googleapis.com/v1/speech:recognize?key=" + googleSpeechApiKey);
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+    return metadata.valid ? metadata.channels : -1;
+}
 
-    // Load the audio file
-    QFile file(audioPath);
-    if (!file.open(QIODevice::ReadOnly))
+/**
+ * @name isOffline
+ * @brief Returns whether the computer is known to have no network connection
+ * @return True if the operating system reports no connectivity
+ * @author Callum Thompson
+ */
+bool AudioHandler::isOffline() const
+{
+    QNetworkInformation *info = QNetworkInformation::instance();
+    return info && info->reachability() == QNetworkInformation::Reachability::Disconnected;
+}
+
+/**
+ * @name registerBackend
+ * @brief Adds a transcription backend to choose from
+ * @param[in] backend: Backend to add; must outlive the AudioHandler
+ * @author Callum Thompson
+ */
+void AudioHandler::registerBackend(TranscriptionBackend *backend)
+{
+    backends.append(backend);
+}
+
+/**
+ * @name setTranscriptCacheSize
+ * @brief Sets how much disk space cached transcripts may use
+ * @param[in] bytes: Size limit of TranscriptCache; 0 disables the cache
+ * @author Callum Thompson
+ */
+void AudioHandler::setTranscriptCacheSize(qint64 bytes)
+{
+    cacheTranscripts = bytes > 0;
+    TranscriptCache::getInstance()->setMaximumSize(bytes);
+}
+
+/**
+ * @name setHedging
+ * @brief Enables racing a second backend against slow answers
+ * @details When enabled, recordings up to `maxClipSecs` long are also sent
+ * to the next fastest backend if the first has not answered within the
+ * latency it usually achieves. The first transcript wins and the other
+ * request is aborted.
+ * @param[in] enabled: True to hedge short recordings
+ * @param[in] maxClipSecs: Longest recording that is hedged
+ * @author Callum Thompson
+ */
+void AudioHandler::setHedging(bool enabled, double maxClipSecs)
+{
+    hedging = enabled;
+    hedgeMaxSecs = maxClipSecs;
+}
+
+/**
+ * @name setLocalTranscription
+ * @brief Configures transcription on this computer with whisper.cpp
+ * @details Once configured, short recordings are transcribed locally when
+ * that is expected to be faster than a cloud service, and every recording
+ * is transcribed locally when the network is down.
+ * @param[in] executablePath: Path of whisper-cli, or empty to search PATH
+ * @param[in] modelPath: Path of a quantized GGML model; empty disables local transcription
+ * @author Callum Thompson
+ */
+void AudioHandler::setLocalTranscription(const QString &executablePath, const QString &modelPath)
+{
+    localBackend->setModel(executablePath, modelPath);
+}
+
+/**
+ * @name startSegmentedRecording
+ * @brief Starts audio recording with live transcription of rolling segments
+ * @details The recording is split into short overlapping segments. Each
+ * segment is sent for transcription as soon as it is finalized, while capture
+ * continues, so only the last segment is outstanding when recording stops.
+ * Earlier recordings may still be transcribing; each is reported under its
+ * own identifier. A new recording can only start once the previous one has
+ * emitted segmentedRecordingStopped().
+ * @see stopSegmentedRecording
+ * @param[in] outputFile: Base name of the segment files; relative paths are
+ * resolved against the application directory
+ * @return Identifier of the recording, or 0 if a recording is still
+ * capturing, there is no microphone or recording could not start
+ * @author Callum Thompson
+ */
+int AudioHandler::startSegmentedRecording(const QString &outputFile)
+{
+    if (recordingSessionId != 0)
     {
-        qWarning() << "Could not open audio file: " << audioPath;
-        return "";
+        qWarning() << "Cannot start a recording before the previous one has stopped";
+        return 0;
     }
 
-    // Read and encode audio file as base64
-    QByteArray audioData = file.readAll();
-    file.close();
-    QString base64Audio = audioData.toBase64();
+    requestMicrophonePermission();
 
-    // Configure audio settings for Google's STT API
-    QJsonObject config;
-    config["encoding"] = "LINEAR16";            // WAV file format
-    config["sampleRateHertz"] = 48000;          // Sample rate used by your mic or recorder
-    config["languageCode"] = "en-CA";           // Canadian English
-    config["audioChannelCount"] = 2;            // Stereo audio
+    QAudioDevice defaultMic = selectMicrophone();
+    if (defaultMic.isNull())
+    {
+        return 0;
+    }
 
-    // Insert the encoded audio into the request
-    QJsonObject audio;
-    audio["content"] = base64Audio;
+    NetworkManager::getInstance()->prewarm(); // Connections are ready for the first segment
+    QTime start = getCurrentTime();
 
-    // Combine configuration and audio into final JSON body
-    QJsonObject root;
-    root["config"] = config;
-    root["audio"] = audio;
+    // A recorder that fails to start may close its files at once; without a
+    // session they are discarded
+    QString projectDir = QDir(QCoreApplication::applicationDirPath()).absolutePath();
+    bool started = false;
+    if (useStreamingCapture)
+    {
+        streamingCapture->setAudioFormat(captureProfile.sampleRate, captureProfile.channels);
+        started = streamingCapture->start(defaultMic, QDir(projectDir).filePath(outputFile));
+    }
+    else
+    {
+        segmentedRecorder->setAudioFormat(captureProfile.sampleRate, captureProfile.channels);
+        started = segmentedRecorder->start(defaultMic, QDir(projectDir).filePath(outputFile));
+    }
+
+    if (!started)
+    {
+        qWarning() << "Could not start recording to" << outputFile;
+        return 0;
+    }
 
-    // Serialize the JSON payload
-    QJsonDocument doc(root);
-    QByteArray jsonData = doc.toJson();
+    recordingSessionId = ++lastSessionId;
+    segmentedSessions[recordingSessionId].start = start;
+    segmentedSessions[recordingSessionId].stitcher.setOverlap(segmentOverlapSecs);
+    return recordingSessionId;
+}
 
-    // Send the POST request
-    QNetworkReply *reply = networkManager->post(request, jsonData);
+/**
+ * @name stopSegmentedRecording
+ * @brief Stops segmented recording
+ * @details segmentedRecordingStopped() is emitted once the last segment file
+ * has been finalized, and segmentedTranscriptionCompleted() once every
+ * segment has been transcribed, or segmentedTranscriptionFailed() if any
+ * segment could not be.
+ * @author Callum Thompson
+ */
+void AudioHandler::stopSegmentedRecording()
+{
+    if (streamingCapture->isRecording())
+    {
+        streamingCapture->stop();
+        return;
+    }
+    if (segmentedRecorder->isRecording())
+    {
+        segmentedRecorder->stop();
+        return;
+    }
 
-    // Wait synchronously for the reply to complete
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+    // The recorder has already stopped; complete the recording if it has not been
+    finishSegmentedRecording();
+}
 
-    // Read and return the API response
-    QString response;
-    if (reply->error() == QNetworkReply::NoError)
+/**
+ * @name finishSegmentedRecording
+ * @brief Handles the recorder finalizing its last segment
+ * @details Frees the microphone for the next recording. The stopped
+ * recording completes once its remaining segments have been transcribed.
+ * @author Callum Thompson
+ */
+void AudioHandler::finishSegmentedRecording()
+{
+    int sessionId = recordingSessionId;
+    if (sessionId == 0)
     {
-        response = reply->readAll();
+        return;
     }
-    else
+
+    recordingSessionId = 0;
+    segmentedSessions[sessionId].recordingFinished = true;
+    emit segmentedRecordingStopped(sessionId);
+    completeSegmentedTranscription(sessionId);
+}
+
+/**
+ * @name setSegmentLength
+ * @brief Configures the segment length used by segmented recording
+ * @param[in] segmentSecs: Seconds recorded before the next segment starts
+ * @param[in] overlapSecs: Seconds shared by consecutive segments
+ * @author Callum Thompson
+ */
+void AudioHandler::setSegmentLength(int segmentSecs, int overlapSecs)
+{
+    segmentedRecorder->setSegmentLength(segmentSecs, overlapSecs);
+    streamingCapture->setSegmentLength(segmentSecs, overlapSecs);
+    segmentOverlapSecs = qBound(0, overlapSecs, qMax(0, segmentSecs - 1)); // As clamped by the recorders
+}
+
+/**
+ * @name transcribeSegment
+ * @brief Starts transcribing a finalized segment
+ * @details The segment is first converted to the capture profile if the
+ * recorder did not honour it. The result is stored in the stitcher when the
+ * job completes. The segment file is removed once its job has ended, unless
+ * the job failed; the segment is then recorded as failed and its file kept
+ * so it can be transcribed again.
+ * @param[in] index: Segment index
+ * @param[in] filePath: Path to the segment file
+ * @author Callum Thompson
+ */
+void AudioHandler::transcribeSegment(int index, const QString &filePath)
+{
+    // Segments only arrive while their recording is capturing or finalizing
+    int sessionId = recordingSessionId;
+    if (!segmentedSessions.contains(sessionId))
     {
-        emit badRequest(reply); // Notify system about failed request
-        qWarning() << "Google request failed:" << reply->errorString();
+        qWarning() << "Segment" << index << "does not belong to a recording:" << filePath;
+        QFile::remove(filePath); // Left by a recording that failed to start
+        return;
     }
 
-    reply->deleteLater();
-    return response;
+    // Counted from now, so the recording cannot complete while the segment is converted
+    ++segmentedSessions[sessionId].pendingUploads;
+    conformToCaptureProfile(filePath, [this, sessionId, index, filePath](bool)
+                            { startSegmentJob(sessionId, index, filePath); });
+}
+
+/**
+ * @name startSegmentJob
+ * @brief Starts the transcription job of a segment in the capture profile
+ * @param[in] sessionId: Identifier of the recording
+ * @param[in] index: Segment index
+ * @param[in] filePath: Path to the segment file
+ * @author Callum Thompson
+ */
+void AudioHandler::startSegmentJob(int sessionId, int index, const QString &filePath)
+{
+    TranscriptionJob *job = transcribe(filePath);
+
+    connect(job, &TranscriptionJob::finished, this, [this, sessionId, index](const Transcript &transcript)
+            { segmentedSessions[sessionId].stitcher.addSegment(index, transcript.getContent()); });
+    connect(job, &TranscriptionJob::failed, this, [this, sessionId, index, filePath](const QString &errorMessage)
+            {
+                qWarning() << "Segment" << index << "transcription failed:" << errorMessage << "- kept" << filePath;
+                segmentedSessions[sessionId].failedSegments.append(index);
+            });
+
+    // Every job is destroyed after its final signal, whichever way it ended
+    connect(job, &QObject::destroyed, this, [this, sessionId, index, filePath]()
+    {
+        if (!segmentedSessions[sessionId].failedSegments.contains(index))
+        {
+            QFile::remove(filePath);
+        }
+        --segmentedSessions[sessionId].pendingUploads;
+        completeSegmentedTranscription(sessionId);
+    });
 }
 
+/**
+ * @name completeSegmentedTranscription
+ * @brief Emits the stitched transcript once every segment of a recording
+ * has been transcribed
+ * @details Does nothing while the recording continues or its segment
+ * transcriptions are still in flight. If any segment failed, the transcript
+ * would have a gap, so segmentedTranscriptionFailed() is emitted instead.
+ * @param[in] sessionId: Identifier of the recording
+ * @author Callum Thompson
+ */
+void AudioHandler::completeSegmentedTranscription(int sessionId)
+{
+    auto it = segmentedSessions.find(sessionId);
+    if (it == segmentedSessions.end() || !it->recordingFinished || it->pendingUploads > 0)
+    {
+        return;
+    }
+
+    if (!it->failedSegments.isEmpty())
+    {
+        QList<int> failed = it->failedSegments;
+        std::sort(failed.begin(), failed.end());
+        QStringList indices;
+        for (int index : failed)
+        {
+            indices.append(QString::number(index));
+        }
+        int segmentCount = it->stitcher.segmentCount() + failed.size();
+        segmentedSessions.erase(it);
+        emit segmentedTranscriptionFailed(sessionId, QString("%1 of %2 segments could not be transcribed (%3)")
+                                                         .arg(failed.size())
+                                                         .arg(segmentCount)
+                                                         .arg(indices.join(", ")));
+        return;
+    }
+
+    Transcript transcript(it->start, it->stitcher.stitch());
+    segmentedSessions.erase(it);
+    emit segmentedTranscriptionCompleted(sessionId, transcript);
+}
 
 /**
- * @name startRecording
- * @brief Starts audio recording
- * @details This function initializes the audio input and recorder,
- * sets the output file, and starts recording.
- * It also requests microphone permission if not already granted.
- * @note The function emits a signal when the recording starts.
- * @see requestMicrophonePermission
- * @see QAudioInput
- * @param[in] outputFile: Path to the output file
- * @return void
+ * @name selectMicrophone
+ * @brief Returns the microphone used for recording
+ * @return Default microphone, or a null device if no microphone is available
  * @author Andres Pedreros Castro
  */
-void AudioHandler::startRecording(const QString &outputFile)
+QAudioDevice AudioHandler::selectMicrophone() const
 {
-    requestMicrophonePermission();
-
     // Get available microphones
     QList<QAudioDevice> devices = QMediaDevices::audioInputs();
     if (devices.isEmpty())
     {
         qWarning() << "No microphone detected!";
-        return;
+        return QAudioDevice();
     }
 
     QAudioDevice defaultMic = devices.first();
     qInfo() << "🎤 Using microphone:" << defaultMic.description();
+    return defaultMic;
+}
 
-    // Delete previous audio input if it exists
-    if (audioInput != nullptr)
-    {
-        delete audioInput;
-        audioInput = nullptr;
-    }
+/**
+ * @name setCaptureProfile
+ * @brief Sets the format that recordings are stored and uploaded in
+ * @details Takes effect from the next recording.
+ * @param[in] profile: Capture profile
+ * @author Callum Thompson
+ */
+void AudioHandler::setCaptureProfile(const CaptureProfile &profile)
+{
+    captureProfile = profile;
+}
 
-    // Create QAudioInput with the validated format
-    audioInput = new QAudioInput(defaultMic);
-    captureSession.setAudioInput(audioInput);
-    captureSession.setRecorder(&recorder);
+/**
+ * @name getCaptureProfile
+ * @brief Returns the format that recordings are stored and uploaded in
+ * @return Capture profile
+ * @author Callum Thompson
+ */
+CaptureProfile AudioHandler::getCaptureProfile() const
+{
+    return captureProfile;
+}
 
-    // Set up recorder output
-    QString projectDir = QDir(QCoreApplication::applicationDirPath()).absolutePath();
-    QString filePath = QDir(projectDir).filePath(outputFile);
-    recorder.setOutputLocation(QUrl::fromLocalFile(filePath));
+/**
+ * @name conformToCaptureProfile
+ * @brief Converts a finalized recording to the capture profile
+ * @details Not every multimedia backend honours the requested sample rate
+ * and channel count, and some always record at the device's native format.
+ * If the file differs from the profile it is downmixed and resampled in
+ * place, which also shrinks the upload. Files already in the profile's
+ * format are left untouched. The conversion runs on a worker thread, like
+ * FLAC encoding, so long recordings do not block the interface.
+ * @param[in] audioPath: Path to the recorded WAV file
+ * @param[in] onFinished: Called on this thread once the conversion ends,
+ * with true if the file is now in the profile's format; may be empty
+ * @author Callum Thompson
+ */
+void AudioHandler::conformToCaptureProfile(const QString &audioPath, const std::function<void(bool)> &onFinished)
+{
+    CaptureProfile profile = captureProfile;
+    AudioMetadataCache::getInstance(); // Create the shared cache on this thread
+    QThreadPool::globalInstance()->start([this, audioPath, profile, onFinished]()
+    {
+        bool conformed = convertToProfile(audioPath, profile);
+        if (onFinished)
+        {
+            QMetaObject::invokeMethod(this, [onFinished, conformed]() { onFinished(conformed); }, Qt::QueuedConnection);
+        }
+    });
+}
 
-    // Set media format to Wave
-    QMediaFormat mediaFormat;
-    mediaFormat.setFileFormat(QMediaFormat::Wave);
-    recorder.setMediaFormat(mediaFormat);
+/**
+ * @name convertToProfile
+ * @brief Converts a recording to a capture profile in place
+ * @details Safe to call from a worker thread.
+ * @param[in] audioPath: Path to the recorded WAV file
+ * @param[in] profile: Format to convert to
+ * @return True if the file is now in the profile's format
+ * @author Callum Thompson
+ */
+bool AudioHandler::convertToProfile(const QString &audioPath, const CaptureProfile &profile)
+{
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+    if (!metadata.isPcm16())
+    {
+        return false;
+    }
+    if (metadata.sampleRate == profile.sampleRate && metadata.channels == profile.channels)
+    {
+        return true;
+    }
 
-    // Apply required settings to recorder
-    recorder.setAudioSampleRate(48000);
-    recorder.setAudioChannelCount(2);
+    QString convertedPath = audioPath + ".part";
+    if (!AudioResampler::convertFile(audioPath, convertedPath, profile.sampleRate, profile.channels))
+    {
+        QFile::remove(convertedPath);
+        return false;
+    }
 
-    recorder.record();
+    QFile::remove(audioPath);
+    if (!QFile::rename(convertedPath, audioPath))
+    {
+        qWarning() << "Could not replace recording with converted audio:" << audioPath;
+        return false;
+    }
+    AudioMetadataCache::getInstance()->invalidate(audioPath);
+    return true;
 }
 
 /**
- * @name pauseRecording
- * @brief Pauses audio recording
- * @details This function pauses the audio recording.
- * It can be resumed later using the resumeRecording() function.
- * @author Andres Pedreros Castro
- * @return void
+ * @name setSilenceTrimming
+ * @brief Enables or disables removing silence before upload
+ * @details When enabled, silences longer than a second are compressed to a
+ * short pause before the audio is uploaded. silenceRemoved() reports how
+ * much was removed for each job.
+ * @param[in] enabled: True to remove long silences
+ * @author Callum Thompson
  */
-void AudioHandler::pauseRecording()
+void AudioHandler::setSilenceTrimming(bool enabled)
 {
-    recorder.pause();
+    trimSilence = enabled;
 }
 
 /**
- * @name resumeRecording
- * @brief Resumes audio recording
- * @details This function resumes the audio recording after it has been paused.
- * It continues recording from the point where it was paused.
- * @author Andres Pedreros Castro
- * @return void
+ * @name setStreamingCapture
+ * @brief Selects the recorder used by segmented recording
+ * @details When enabled, audio is captured with QAudioSource and written,
+ * segmented and checked for pauses while recording, instead of through
+ * QMediaRecorder. The whole recording is also kept as a single WAV file.
+ * Takes effect from the next recording.
+ * @see StreamingCapture
+ * @param[in] enabled: True to use streaming capture
+ * @author Callum Thompson
  */
-void AudioHandler::resumeRecording()
+void AudioHandler::setStreamingCapture(bool enabled)
 {
-    recorder.record();
+    useStreamingCapture = enabled;
 }
 
 /**
- * @name stopRecording
- * @brief Stops audio recording
- * @details This function stops the audio recording and finalizes the output file.
- * It can be called after recording is complete or if the user wants to stop recording.
- * @author Andres Pedreros Castro
- * @return void
+ * @name getCaptureStatistics
+ * @brief Returns the health counters of the last streaming capture
+ * @return Dropped frames and capture buffer usage
+ * @author Callum Thompson
  */
-void AudioHandler::stopRecording()
+CaptureStatistics AudioHandler::getCaptureStatistics() const
 {
-    recorder.stop();
+    return streamingCapture->statistics();
+}
+
+/**
+ * @name setChunking
+ * @brief Sets how long recordings are split for parallel transcription
+ * @details Recordings longer than `chunkSecs` after silence removal are cut
+ * at pauses into chunks of about that length, and up to
+ * `maxParallelUploads` of them are transcribed at the same time. Chunks
+ * are always kept below the Whisper upload limit.
+ * @param[in] chunkSecs: Preferred chunk length in seconds
+ * @param[in] maxParallelUploads: Maximum number of chunks uploaded at once
+ * @author Callum Thompson
+ */
+void AudioHandler::setChunking(int chunkSecs, int maxParallelUploads)
+{
+    chunkLengthSecs = qMax(30, chunkSecs);
+    this->maxParallelUploads = qMax(1, maxParallelUploads);
 }
 
 /**
@@ -534,7 +1214,7 @@ void AudioHandler::playRecording(const QString &filePath)
  */
 void AudioHandler::setGoogleApiKey(const QString &key)
 {
-    googleSpeechApiKey = key;
+    googleBackend->setApiKey(key);
 }
 
 /**
@@ -547,32 +1227,21 @@ void AudioHandler::setGoogleApiKey(const QString &key)
  */
 void AudioHandler::setOpenAIApiKey(const QString &key)
 {
-    openAIApiKey = key;
+    whisperBackend->setApiKey(key);
 }
 
 /**
  * @name getAudioDuration
  * @brief Retrieves the duration of an audio file
- * @details This function reads the audio file and calculates its duration
- * based on the file size and audio format.
- * It assumes a specific format (16-bit PCM, 2 channels, 48000Hz) for the calculation.
- * @note This function is specific to WAV files and may not work for other audio formats.
+ * @details Computes the duration from the exact frame count and sample rate
+ * of the WAV file. The file's chunks are parsed once and cached, so repeated
+ * calls do not read the file again.
+ * @see AudioMetadataCache
  * @param[in] audioPath: Path to the audio file
- * @return Duration of the audio file in seconds
+ * @return Duration of the audio file in seconds, or 0 if it is not a valid WAV file
  * @author Andres Pedreros Castro
  */
 double AudioHandler::getAudioDuration(const QString &audioPath) const
 {
-    QFile file(audioPath);
-
-    // Attempt to open the audio file
-    if (!file.open(QIODevice::ReadOnly))
-        return 0;// Return 0 on failure
-
-    // Get the total size of the file in bytes
-    qint64 fileSize = file.size();
-    file.close();
-
-    // Assume 16-bit PCM, 2 channels, 48000Hz => 192000 bytes/sec
-    return fileSize / 192000.0;
+    return AudioMetadataCache::getInstance()->lookup(audioPath).durationSecs();
 }
@@ -12,10 +12,10 @@
 
 #include <string>
 #include <iostream>
+#include <functional>
 #include <QJsonArray>
 #include <QObject>
 #include <QFile>
-#include <QEventLoop>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
@@ -30,13 +30,28 @@
 #include <QCoreApplication>
 #include <QTime>
 #include <QDebug>
+#include <QHash>
 #include "transcript.h"
+#include "audiometadata.h"
+#include "captureprofile.h"
+#include "transcriptionjob.h"
+#include "transcriptstitcher.h"
+#include "segmentedrecorder.h"
+#include "streamingcapture.h"
+#include "chunkedtranscription.h"
+#include "whisperbackend.h"
+#include "googlespeechbackend.h"
+#include "localwhisperbackend.h"
+#include "hedgedtranscription.h"
+#include "latencyhistory.h"
+#include "transcriptcache.h"
 
 /**
  * @class AudioHandler
  * @brief Singleton class for handling audio recording and transcription.
- * @details This class provides methods to record audio, transcribe it using Google Speech API,
- *          and manage microphone permissions. It uses QMediaRecorder for recording and QNetworkAccessManager
+ * @details This class provides methods to record audio, transcribe it with the registered
+ *          TranscriptionBackend implementations (Whisper, Google Speech, or whisper.cpp locally),
+ *          and manage microphone permissions. It uses QMediaRecorder for recording and the shared NetworkManager
  *          for sending audio data to the API. The class is designed as a singleton to ensure
  *          that only one instance exists throughout the application.
  * @note The class is not thread-safe and should be used in a single-threaded context.
@@ -51,39 +66,101 @@ private:
 
 public:
     static AudioHandler *getInstance();             // Get the singleton instance
-    Transcript transcribe(const QString &filename); // Transcribe audio file
-    void startRecording(const QString &outputFile); // Start audio recording
-    void stopRecording();                           // Stop audio recording
-    void pauseRecording();                          // Pause audio recording
-    void resumeRecording();                         // Resume audio recording
+    TranscriptionJob *transcribe(const QString &filename); // Start transcribing audio file
+    int startSegmentedRecording(const QString &outputFile); // Start recording with live segment transcription
+    void stopSegmentedRecording();                  // Stop segmented recording and finish transcription
+    void setSegmentLength(int segmentSecs, int overlapSecs);
     void handlePermissionResponse();
     void playRecording(const QString &filePath);
 
     void setGoogleApiKey(const QString& key);
     void setOpenAIApiKey(const QString& key);
     double getAudioDuration(const QString& path) const;
+    void setCaptureProfile(const CaptureProfile &profile);
+    CaptureProfile getCaptureProfile() const;
+    void conformToCaptureProfile(const QString &audioPath, const std::function<void(bool)> &onFinished = {});
+    void setSilenceTrimming(bool enabled);
+    void setChunking(int chunkSecs, int maxParallelUploads);
+    void setStreamingCapture(bool enabled);
+    void setLocalTranscription(const QString &executablePath, const QString &modelPath);
+    void registerBackend(TranscriptionBackend *backend);
+    void setHedging(bool enabled, double maxClipSecs = 60.0);
+    void setTranscriptCacheSize(qint64 bytes);
+    CaptureStatistics getCaptureStatistics() const;
 
 signals:
-    void transcriptionCompleted(const QString &transcribedText); // Signal for transcription completion
     void microphonePermissionDenied();
     void microphonePermissionGranted();
     void badRequest(QNetworkReply *reply);
+    void segmentedRecordingStopped(int recordingId);    // Microphone released; the next recording may start
+    void segmentedTranscriptionCompleted(int recordingId, const Transcript &transcript); // Stitched transcript of all segments
+    void segmentedTranscriptionFailed(int recordingId, const QString &errorMessage); // Some segments could not be transcribed
+    void silenceRemoved(int jobId, double removedSecs, double originalSecs); // Silence trimmed before upload
 
 private:
-    QString googleSpeechApiKey;
-    QString openAIApiKey;
-    QNetworkAccessManager *networkManager;
+    WhisperBackend *whisperBackend;                      // OpenAI Whisper API
+    GoogleSpeechBackend *googleBackend;                  // Google Speech-to-Text API
+    LocalWhisperBackend *localBackend;                   // whisper.cpp on this computer
+    QList<TranscriptionBackend *> backends;              // Backends chooseBackend() picks from
+    QHash<const TranscriptionBackend *, LatencyHistory> latencyHistory; // Recent latencies of each backend
+    bool hedging = false;                                // Race a second backend against slow answers
+    double hedgeMaxSecs = 60.0;                          // Longest recording that is hedged
+    bool cacheTranscripts = true;                        // Reuse transcripts of audio sent before
 
-    QString sendToWhisperAPI(const QString &audioPath); // Send audio to Google Speech API
-    QString sendToGoogleSpeechAPI(const QString &audioPath);
+    int lastJobId = 0;                                   // Identifier of the most recent job
+
+    bool trimSilence = true;                             // Remove long silences before upload
+    int chunkLengthSecs = 300;                           // Preferred length of each upload chunk
+    int maxParallelUploads = 4;                          // Chunks of one recording uploaded at once
+    static constexpr qint64 WHISPER_UPLOAD_LIMIT = 20 * 1024 * 1024; // Below the 25 MB Whisper file limit
+    static constexpr double HEDGE_PERCENTILE = 90.0;     // Latency percentile a primary is given before hedging
+
+    static QList<UploadChunk> encodeForUpload(const QString &audioPath, bool trimSilence, int chunkSecs);
+    void uploadForTranscription(TranscriptionJob *job, const QString &audioPath, const QList<UploadChunk> &chunks);
+    void uploadChunks(TranscriptionJob *job, const QString &audioPath, const QList<UploadChunk> &chunks);
+    void startRequest(TranscriptionJob *job, TranscriptionBackend *backend, const QString &audioPath, const QByteArray &flac);
+    void handleTranscriptionResult(TranscriptionJob *job, TranscriptionRequest *request, TranscriptionBackend *backend,
+                                   const QString &audioPath, const QByteArray &flac);
+    void completeJob(TranscriptionJob *job, TranscriptionBackend *backend, const QString &text);
+    void startHedgedRequest(TranscriptionJob *job, TranscriptionBackend *primary, TranscriptionBackend *secondary,
+                            const QString &audioPath, const QByteArray &flac);
+    int hedgeDelayMs(TranscriptionBackend *backend, double uploadSecs) const;
+    double uploadDuration(const TranscriptionJob *job, const QString &audioPath) const;
+    TranscriptionBackend *chooseBackend(const AudioMetadata &metadata, double uploadSecs, qint64 uploadBytes,
+                                        bool isFlac, bool offline, bool needTimestamps,
+                                        const TranscriptionBackend *exclude = nullptr) const;
+    bool isOffline() const;
     QTime getCurrentTime() const;                            // Get current time
     int getAudioChannelCount(const QString &audioPath) const; // Get audio channel count
-    QString outputFilePath;                                  // Output file path for recording
-    QMediaRecorder recorder;                                 // Media recorder for audio
-    QMediaCaptureSession captureSession;                     // Media capture session
-    QAudioInput *audioInput = nullptr; 
+    CaptureProfile captureProfile = CaptureProfile::speech(); // Format recordings are stored in
+
+    SegmentedRecorder *segmentedRecorder;                    // Records rolling segments for live transcription
+    StreamingCapture *streamingCapture;                      // Records through QAudioSource and segments at pauses
+    bool useStreamingCapture = false;                        // Use streamingCapture for segmented recording
+    int segmentOverlapSecs = 2;                              // Audio shared by consecutive segments
+
+    /**
+     * @brief Segmented recording whose transcription has not completed
+     */
+    struct SegmentedSession
+    {
+        TranscriptStitcher stitcher;     // Collects per-segment transcriptions
+        QTime start;                     // Start time of the recording
+        int pendingUploads = 0;          // Segment transcriptions still in flight
+        QList<int> failedSegments;       // Segments that could not be transcribed; their files are kept
+        bool recordingFinished = false;  // All segment files have been finalized
+    };
+    QHash<int, SegmentedSession> segmentedSessions;          // Recordings still being transcribed, by id
+    int recordingSessionId = 0;                              // Recording the microphone is capturing, or 0
+    int lastSessionId = 0;                                   // Identifier of the most recent recording
 
     void requestMicrophonePermission(); // Request microphone permission
+    QAudioDevice selectMicrophone() const;
+    void transcribeSegment(int index, const QString &filePath);
+    void startSegmentJob(int sessionId, int index, const QString &filePath);
+    static bool convertToProfile(const QString &audioPath, const CaptureProfile &profile);
+    void finishSegmentedRecording();
+    void completeSegmentedTranscription(int sessionId);
 
 };
 
@@ -0,0 +1,273 @@
+/**
+ * @file audiometadata.cpp
+ * @brief Definition of AudioMetadata struct and AudioMetadataCache class
+ *
+ * Parses the RIFF chunk structure of WAV files and caches the result so the
+ * recording pipeline reads each file's header at most once.
+ *
+ * @author Andres Pedreros Castro (apedrero@uwo.ca)
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 5, 2025
+ */
+
+#include <cstring>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QDebug>
+#include "audiometadata.h"
+
+AudioMetadataCache *AudioMetadataCache::instance = nullptr;
+
+namespace
+{
+const int formatPcm = 1;
+const int formatExtensible = 0xFFFE;
+}
+
+/**
+ * @name durationSecs
+ * @brief Returns the length of the audio
+ * @return Duration in seconds, or 0 if the metadata is invalid
+ * @author Andres Pedreros Castro
+ */
+double AudioMetadata::durationSecs() const
+{
+    if (!valid || sampleRate <= 0)
+    {
+        return 0;
+    }
+    return static_cast<double>(frameCount) / sampleRate;
+}
+
+/**
+ * @name isPcm16
+ * @brief Returns whether the samples are 16-bit integer PCM
+ * @details This is the LINEAR16 encoding accepted by every transcription
+ * service and processed by the audio pipeline.
+ * @return True for 16-bit integer PCM
+ * @author Callum Thompson
+ */
+bool AudioMetadata::isPcm16() const
+{
+    return valid && formatTag == formatPcm && bitsPerSample == 16;
+}
+
+/**
+ * @name parseWav
+ * @brief Parses the chunks of a WAV file held in memory
+ * @details Walks every RIFF chunk in order, reading the format from the "fmt "
+ * chunk and the location of the samples from the "data" chunk, and skipping
+ * any others (LIST, fact, cue, ...). Chunks are word-aligned as required by
+ * RIFF. A data chunk whose declared size is zero or runs past the end of the
+ * file (as written by an interrupted recorder) is clamped to the file.
+ * @param[in] data: File contents
+ * @param[in] size: Size of the file in bytes
+ * @return Parsed metadata; `valid` is false if the file is not a usable WAV file
+ * @author Andres Pedreros Castro
+ * @author Callum Thompson
+ */
+AudioMetadata AudioMetadata::parseWav(const uchar *data, qint64 size)
+{
+    AudioMetadata metadata;
+
+    // RIFF header: "RIFF" <size> "WAVE"
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return metadata;
+    }
+
+    bool haveFormat = false;
+    bool haveData = false;
+    qint64 offset = 12;
+    while (offset + 8 <= size && !haveData)
+    {
+        const uchar *chunk = data + offset;
+        qint64 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+        qint64 bodyOffset = offset + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if (chunkSize < 16 || bodyOffset + 16 > size)
+            {
+                return metadata; // Truncated format chunk
+            }
+            const uchar *fmt = data + bodyOffset;
+            metadata.formatTag = qFromLittleEndian<quint16>(fmt);
+            metadata.channels = qFromLittleEndian<quint16>(fmt + 2);
+            metadata.sampleRate = static_cast<int>(qFromLittleEndian<quint32>(fmt + 4));
+            metadata.blockAlign = qFromLittleEndian<quint16>(fmt + 12);
+            metadata.bitsPerSample = qFromLittleEndian<quint16>(fmt + 14);
+
+            // WAVE_FORMAT_EXTENSIBLE stores the real format in the sub-format GUID
+            if (metadata.formatTag == formatExtensible && chunkSize >= 40 && bodyOffset + 26 <= size)
+            {
+                metadata.formatTag = qFromLittleEndian<quint16>(fmt + 24);
+            }
+            haveFormat = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            qint64 available = size - bodyOffset;
+            if (chunkSize == 0 || chunkSize > available)
+            {
+                chunkSize = available;
+            }
+            metadata.dataOffset = bodyOffset;
+            metadata.dataSize = chunkSize;
+            haveData = true;
+        }
+
+        // Chunks are padded to an even number of bytes
+        offset = bodyOffset + chunkSize + (chunkSize & 1);
+    }
+
+    if (!haveFormat || !haveData || metadata.channels <= 0 || metadata.sampleRate <= 0)
+    {
+        return metadata;
+    }
+
+    // Older writers sometimes leave blockAlign unset
+    if (metadata.blockAlign <= 0)
+    {
+        metadata.blockAlign = metadata.channels * ((metadata.bitsPerSample + 7) / 8);
+    }
+    if (metadata.blockAlign <= 0)
+    {
+        return metadata;
+    }
+
+    metadata.frameCount = metadata.dataSize / metadata.blockAlign;
+    metadata.valid = true;
+    return metadata;
+}
+
+/**
+ * @name wavHeader
+ * @brief Builds the 44-byte header of a 16-bit PCM WAV file
+ * @details Files written incrementally can be given a data size of zero and
+ * have the header rewritten once the size is known; parseWav also accepts
+ * the zero size if the file is never finalized.
+ * @param[in] sampleRate: Frames per second
+ * @param[in] channels: Number of channels
+ * @param[in] dataSize: Bytes of sample data that follow the header
+ * @return Header bytes
+ * @author Callum Thompson
+ */
+QByteArray AudioMetadata::wavHeader(int sampleRate, int channels, qint64 dataSize)
+{
+    QByteArray header(44, '\0');
+    uchar *out = reinterpret_cast<uchar *>(header.data());
+    quint16 blockAlign = static_cast<quint16>(channels * 2);
+
+    std::memcpy(out, "RIFF", 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(36 + dataSize), out + 4);
+    std::memcpy(out + 8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(16, out + 16);
+    qToLittleEndian<quint16>(formatPcm, out + 20);
+    qToLittleEndian<quint16>(static_cast<quint16>(channels), out + 22);
+    qToLittleEndian<quint32>(static_cast<quint32>(sampleRate), out + 24);
+    qToLittleEndian<quint32>(static_cast<quint32>(sampleRate) * blockAlign, out + 28);
+    qToLittleEndian<quint16>(blockAlign, out + 32);
+    qToLittleEndian<quint16>(16, out + 34);
+    std::memcpy(out + 36, "data", 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(dataSize), out + 40);
+    return header;
+}
+
+/**
+ * @name getInstance
+ * @brief Returns the singleton instance of AudioMetadataCache
+ * @return Shared metadata cache
+ * @author Callum Thompson
+ */
+AudioMetadataCache *AudioMetadataCache::getInstance()
+{
+    if (!instance)
+    {
+        instance = new AudioMetadataCache();
+    }
+    return instance;
+}
+
+/**
+ * @name lookup
+ * @brief Returns the metadata of a WAV file
+ * @details Parses the file the first time it is seen, or when its
+ * modification time or size has changed since it was last parsed.
+ * @param[in] filePath: Path to the WAV file
+ * @return Metadata of the file; `valid` is false if it could not be parsed
+ * @author Callum Thompson
+ */
+AudioMetadata AudioMetadataCache::lookup(const QString &filePath)
+{
+    QFileInfo info(filePath);
+    if (!info.exists())
+    {
+        return AudioMetadata();
+    }
+
+    QDateTime modified = info.lastModified();
+    qint64 size = info.size();
+    QString key = info.absoluteFilePath();
+
+    {
+        QMutexLocker locker(&mutex);
+        auto it = entries.constFind(key);
+        if (it != entries.constEnd() && it->modified == modified && it->size == size)
+        {
+            return it->metadata;
+        }
+    }
+
+    // Parse outside the lock so other files can be looked up meanwhile
+    AudioMetadata metadata = readFile(filePath);
+
+    QMutexLocker locker(&mutex);
+    entries.insert(key, {modified, size, metadata});
+    return metadata;
+}
+
+/**
+ * @name invalidate
+ * @brief Forgets the cached metadata of a file
+ * @details Used when a file is rewritten within the resolution of its
+ * modification time.
+ * @param[in] filePath: Path to the WAV file
+ * @author Callum Thompson
+ */
+void AudioMetadataCache::invalidate(const QString &filePath)
+{
+    QMutexLocker locker(&mutex);
+    entries.remove(QFileInfo(filePath).absoluteFilePath());
+}
+
+/**
+ * @name readFile
+ * @brief Maps a WAV file and parses its chunks
+ * @details Only the pages holding the chunk headers are actually read.
+ * @param[in] filePath: Path to the WAV file
+ * @return Parsed metadata
+ * @author Callum Thompson
+ */
+AudioMetadata AudioMetadataCache::readFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Could not open audio file:" << filePath;
+        return AudioMetadata();
+    }
+
+    qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data)
+    {
+        return AudioMetadata();
+    }
+
+    AudioMetadata metadata = AudioMetadata::parseWav(data, size);
+    file.unmap(const_cast<uchar *>(data));
+    return metadata;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file audiometadata.h
+ * @brief Declaration of AudioMetadata struct and AudioMetadataCache class
+ *
+ * @author Andres Pedreros Castro (apedrero@uwo.ca)
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 5, 2025
+ */
+
+#ifndef AUDIOMETADATA_H
+#define AUDIOMETADATA_H
+
+#include <QString>
+#include <QHash>
+#include <QDateTime>
+#include <QMutex>
+
+/**
+ * @struct AudioMetadata
+ * @brief Format and layout of a WAV file
+ * @details Produced by walking the RIFF chunks of the file, so files with
+ * LIST, fact or other extra chunks and any sample rate are described
+ * correctly.
+ * @author Andres Pedreros Castro
+ * @author Callum Thompson
+ */
+struct AudioMetadata
+{
+    bool valid = false;      // File is a readable WAV file
+    int formatTag = 0;       // 1 = integer PCM, 3 = IEEE float (extensible formats are resolved)
+    int sampleRate = 0;      // Frames per second
+    int channels = 0;        // Interleaved channels per frame
+    int bitsPerSample = 0;   // Bits per sample of a single channel
+    int blockAlign = 0;      // Bytes per frame
+    qint64 dataOffset = 0;   // Offset of the first sample in the file
+    qint64 dataSize = 0;     // Bytes of sample data
+    qint64 frameCount = 0;   // Number of complete frames
+
+    double durationSecs() const;
+    bool isPcm16() const;
+
+    static AudioMetadata parseWav(const uchar *data, qint64 size);
+    static QByteArray wavHeader(int sampleRate, int channels, qint64 dataSize);
+};
+
+/**
+ * @class AudioMetadataCache
+ * @brief Caches parsed WAV metadata per file
+ * @details Entries are keyed by path and invalidated when the file's
+ * modification time or size changes. A cached lookup only checks the file's
+ * attributes and does not read the file. Lookups are thread-safe so worker
+ * threads can share the cache.
+ * @author Callum Thompson
+ */
+class AudioMetadataCache
+{
+public:
+    static AudioMetadataCache *getInstance();
+
+    AudioMetadata lookup(const QString &filePath);
+    void invalidate(const QString &filePath);
+
+private:
+    AudioMetadataCache() = default;
+
+    /**
+     * @brief Parsed metadata and the file attributes it was parsed from
+     */
+    struct Entry
+    {
+        QDateTime modified;
+        qint64 size;
+        AudioMetadata metadata;
+    };
+
+    static AudioMetadataCache *instance;
+    QHash<QString, Entry> entries;
+    QMutex mutex;
+
+    static AudioMetadata readFile(const QString &filePath);
+};
+
+#endif // AUDIOMETADATA_H
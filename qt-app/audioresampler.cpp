@@ -0,0 +1,390 @@
+/**
+ * @file audioresampler.cpp
+ * @brief Definition of AudioResampler class
+ *
+ * Polyphase rational resampling: the input is conceptually upsampled by L,
+ * low-pass filtered and decimated by M, but only the filter taps that land
+ * on real input samples are ever evaluated.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 6, 2025
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <QFile>
+#include <QVarLengthArray>
+#include <QtMath>
+#include <QDebug>
+#include "audioresampler.h"
+#include "audiometadata.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define RESAMPLER_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RESAMPLER_NEON
+#endif
+
+namespace
+{
+const int zeroCrossings = 16;      // Sinc lobes kept on each side of the centre tap
+const double passband = 0.9;       // Fraction of the output Nyquist band kept
+const qint64 blockFrames = 4096;   // Frames converted per block by convertFile
+}
+
+/**
+ * @name AudioResampler
+ * @brief Constructor for AudioResampler
+ * @details Output channels are produced by averaging all input channels
+ * when mono is requested, by duplicating a mono input when more channels
+ * are requested, and otherwise by keeping the leading input channels.
+ * @param[in] inputRate: Sample rate of the input
+ * @param[in] inputChannels: Channels in each input frame
+ * @param[in] outputRate: Sample rate to produce
+ * @param[in] outputChannels: Channels in each output frame
+ * @author Callum Thompson
+ */
+AudioResampler::AudioResampler(int inputRate, int inputChannels, int outputRate, int outputChannels)
+    : inputChannels(qMax(1, inputChannels)), outputChannels(qMax(1, outputChannels))
+{
+    workingChannels = this->outputChannels == 1 ? 1 : qMin(this->inputChannels, this->outputChannels);
+
+    int divisor = std::gcd(qMax(1, inputRate), qMax(1, outputRate));
+    upFactor = qMax(1, outputRate) / divisor;
+    downFactor = qMax(1, inputRate) / divisor;
+
+    designFilter();
+
+    // Prime the history with silence so the first outputs have full support,
+    // and start at the filter's centre so the output is not delayed
+    history = QVector<QVector<float>>(workingChannels, QVector<float>(tapsPerPhase - 1, 0.0f));
+    qint64 centre = (static_cast<qint64>(tapsPerPhase) * upFactor - 1) / 2;
+    timeInBuffer = centre + static_cast<qint64>(tapsPerPhase - 1) * upFactor;
+}
+
+/**
+ * @name process
+ * @brief Converts a block of interleaved input frames
+ * @details Appends every output frame that can be computed from the input
+ * seen so far; the remainder is produced by later calls or by flush().
+ * @param[in] input: Interleaved 16-bit samples
+ * @param[in] frames: Number of input frames
+ * @param[out] output: Receives interleaved 16-bit output samples
+ * @author Callum Thompson
+ */
+void AudioResampler::process(const qint16 *input, qint64 frames, QVector<qint16> &output)
+{
+    if (frames <= 0)
+    {
+        return;
+    }
+    appendInput(input, frames);
+    framesIn += frames;
+    produceOutput(output, (framesIn * upFactor + downFactor - 1) / downFactor);
+}
+
+/**
+ * @name flush
+ * @brief Produces the output still held back by the filter
+ * @details Called once at the end of the stream. The total output length
+ * is exactly the input duration at the output rate.
+ * @param[out] output: Receives the remaining interleaved output samples
+ * @author Callum Thompson
+ */
+void AudioResampler::flush(QVector<qint16> &output)
+{
+    // Enough silence to cover the filter's look-ahead of half its length
+    qint64 padding = tapsPerPhase + tapsPerPhase / 2 + 1;
+    for (QVector<float> &channel : history)
+    {
+        channel.resize(channel.size() + padding);
+        std::fill(channel.end() - padding, channel.end(), 0.0f);
+    }
+    produceOutput(output, (framesIn * upFactor + downFactor - 1) / downFactor);
+}
+
+/**
+ * @name isPassthrough
+ * @brief Returns whether the conversion leaves the audio unchanged
+ * @return True if the rates and channel counts match
+ * @author Callum Thompson
+ */
+bool AudioResampler::isPassthrough() const
+{
+    return upFactor == downFactor && inputChannels == outputChannels;
+}
+
+/**
+ * @name convertFile
+ * @brief Resamples and downmixes a 16-bit PCM WAV file into a new file
+ * @details The input is streamed in blocks, so memory use does not depend
+ * on the recording length.
+ * @param[in] inputPath: WAV file to read
+ * @param[in] outputPath: WAV file to write; must differ from the input
+ * @param[in] outputRate: Sample rate of the new file
+ * @param[in] outputChannels: Channels of the new file
+ * @return True on success
+ * @author Callum Thompson
+ */
+bool AudioResampler::convertFile(const QString &inputPath, const QString &outputPath, int outputRate, int outputChannels)
+{
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(inputPath);
+    if (!metadata.isPcm16())
+    {
+        qWarning() << "Cannot resample audio that is not 16-bit PCM:" << inputPath;
+        return false;
+    }
+
+    QFile inputFile(inputPath);
+    QFile outputFile(outputPath);
+    if (!inputFile.open(QIODevice::ReadOnly) || !inputFile.seek(metadata.dataOffset))
+    {
+        qWarning() << "Could not open audio file:" << inputPath;
+        return false;
+    }
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Could not create audio file:" << outputPath;
+        return false;
+    }
+
+    AudioResampler resampler(metadata.sampleRate, metadata.channels, outputRate, outputChannels);
+    outputFile.write(AudioMetadata::wavHeader(outputRate, outputChannels, 0));
+
+    QVector<qint16> converted;
+    qint64 dataWritten = 0;
+    qint64 remaining = metadata.frameCount;
+    QByteArray block;
+    while (remaining > 0)
+    {
+        block = inputFile.read(qMin(remaining, blockFrames) * metadata.blockAlign);
+        qint64 frames = block.size() / metadata.blockAlign;
+        if (frames <= 0)
+        {
+            break;
+        }
+        remaining -= frames;
+
+        converted.clear();
+        resampler.process(reinterpret_cast<const qint16 *>(block.constData()), frames, converted);
+        dataWritten += outputFile.write(reinterpret_cast<const char *>(converted.constData()), converted.size() * qint64(sizeof(qint16)));
+    }
+
+    converted.clear();
+    resampler.flush(converted);
+    dataWritten += outputFile.write(reinterpret_cast<const char *>(converted.constData()), converted.size() * qint64(sizeof(qint16)));
+
+    // Rewrite the header now that the data size is known
+    if (!outputFile.seek(0) || outputFile.write(AudioMetadata::wavHeader(outputRate, outputChannels, dataWritten)) != 44)
+    {
+        qWarning() << "Could not finalize audio file:" << outputPath;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @name designFilter
+ * @brief Builds the polyphase filter bank
+ * @details A Blackman-windowed sinc at the upsampled rate, cut off just
+ * below the lower of the two Nyquist frequencies, split into upFactor
+ * phases. Each phase is stored reversed and padded to a multiple of four
+ * taps so it can be applied to the history with a plain dot product.
+ * @author Callum Thompson
+ */
+void AudioResampler::designFilter()
+{
+    if (upFactor == 1 && downFactor == 1)
+    {
+        tapsPerPhase = 1;
+        coefficients = {1.0f};
+        return;
+    }
+
+    int widest = qMax(upFactor, downFactor);
+    tapsPerPhase = (2 * zeroCrossings * widest + upFactor - 1) / upFactor;
+    tapsPerPhase = (tapsPerPhase + 3) & ~3;
+
+    qint64 length = static_cast<qint64>(tapsPerPhase) * upFactor;
+    double cutoff = 0.5 * passband / widest;   // Cycles per upsampled sample
+    // Centre on a whole tap so the output is not shifted by half a sample;
+    // taps past the symmetric span are left at zero
+    qint64 centre = (length - 1) / 2;
+
+    QVector<double> prototype(length, 0.0);
+    for (qint64 n = 0; n <= 2 * centre; ++n)
+    {
+        double t = static_cast<double>(n - centre);
+        double sinc = n == centre ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double phase = M_PI * n / centre;
+        double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        prototype[n] = sinc * window * upFactor;
+    }
+
+    coefficients.resize(length);
+    for (int p = 0; p < upFactor; ++p)
+    {
+        float *phaseTaps = coefficients.data() + static_cast<qint64>(p) * tapsPerPhase;
+        for (int k = 0; k < tapsPerPhase; ++k)
+        {
+            phaseTaps[tapsPerPhase - 1 - k] = static_cast<float>(prototype[p + static_cast<qint64>(k) * upFactor]);
+        }
+    }
+}
+
+/**
+ * @name appendInput
+ * @brief Adds input frames to the history, downmixing if required
+ * @param[in] input: Interleaved 16-bit samples
+ * @param[in] frames: Number of input frames
+ * @author Callum Thompson
+ */
+void AudioResampler::appendInput(const qint16 *input, qint64 frames)
+{
+    const float scale = 1.0f / 32768.0f;
+
+    if (workingChannels == 1 && inputChannels > 1)
+    {
+        QVector<float> &mono = history[0];
+        qint64 start = mono.size();
+        mono.resize(start + frames);
+        float *out = mono.data() + start;
+        const float mixScale = scale / inputChannels;
+        for (qint64 i = 0; i < frames; ++i)
+        {
+            const qint16 *frame = input + i * inputChannels;
+            int sum = 0;
+            for (int c = 0; c < inputChannels; ++c)
+            {
+                sum += frame[c];
+            }
+            out[i] = sum * mixScale;
+        }
+        return;
+    }
+
+    for (int c = 0; c < workingChannels; ++c)
+    {
+        QVector<float> &channel = history[c];
+        qint64 start = channel.size();
+        channel.resize(start + frames);
+        float *out = channel.data() + start;
+        for (qint64 i = 0; i < frames; ++i)
+        {
+            out[i] = input[i * inputChannels + c] * scale;
+        }
+    }
+}
+
+/**
+ * @name produceOutput
+ * @brief Computes output frames from the buffered history
+ * @details Stops when the next output needs input that has not arrived or
+ * when `limit` frames have been produced in total, then discards history
+ * that no future output depends on.
+ * @param[out] output: Receives interleaved 16-bit output samples
+ * @param[in] limit: Total number of output frames the stream should have
+ * @author Callum Thompson
+ */
+void AudioResampler::produceOutput(QVector<qint16> &output, qint64 limit)
+{
+    qint64 available = history[0].size();
+    qint64 start = output.size();
+    qint64 produced = 0;
+
+    // Size the output for the worst case, then trim
+    qint64 capacity = qMax<qint64>(0, qMin(limit - framesOut, (available * upFactor) / downFactor + 1));
+    output.resize(start + capacity * outputChannels);
+    qint16 *out = output.data() + start;
+
+    QVarLengthArray<float, 2> values(workingChannels);
+    while (produced < capacity)
+    {
+        qint64 newest = timeInBuffer / upFactor;
+        if (newest >= available)
+        {
+            break;
+        }
+        const float *phaseTaps = coefficients.constData() + (timeInBuffer % upFactor) * tapsPerPhase;
+        qint64 oldest = newest - tapsPerPhase + 1;
+
+        for (int c = 0; c < workingChannels; ++c)
+        {
+            values[c] = dotProduct(phaseTaps, history[c].constData() + oldest, tapsPerPhase);
+        }
+        for (int c = 0; c < outputChannels; ++c)
+        {
+            float sample = std::nearbyint(values[qMin(c, workingChannels - 1)] * 32768.0f);
+            *out++ = static_cast<qint16>(std::clamp(sample, -32768.0f, 32767.0f));
+        }
+
+        timeInBuffer += downFactor;
+        ++produced;
+    }
+    output.resize(start + produced * outputChannels);
+    framesOut += produced;
+
+    // Keep only the history still needed by the next output
+    qint64 discard = qMin(available, timeInBuffer / upFactor - (tapsPerPhase - 1));
+    if (discard > 0)
+    {
+        for (QVector<float> &channel : history)
+        {
+            channel.remove(0, discard);
+        }
+        timeInBuffer -= discard * upFactor;
+    }
+}
+
+/**
+ * @name dotProduct
+ * @brief Multiplies two float arrays element-wise and sums the products
+ * @param[in] a: First array
+ * @param[in] b: Second array
+ * @param[in] count: Number of elements; a multiple of four unless 1
+ * @return Sum of products
+ * @author Callum Thompson
+ */
+float AudioResampler::dotProduct(const float *a, const float *b, int count)
+{
+    if (count < 4)
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < count; ++i)
+        {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+
+#if defined(RESAMPLER_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (int i = 0; i < count; i += 4)
+    {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(RESAMPLER_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int i = 0; i < count; i += 4)
+    {
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    return vaddvq_f32(acc);
+#else
+    float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < count; i += 4)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            lanes[j] += a[i + j] * b[i + j];
+        }
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+}
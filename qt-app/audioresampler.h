@@ -0,0 +1,56 @@
+/**
+ * @file audioresampler.h
+ * @brief Declaration of AudioResampler class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 6, 2025
+ */
+
+#ifndef AUDIORESAMPLER_H
+#define AUDIORESAMPLER_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @class AudioResampler
+ * @brief Streaming sample rate converter and channel downmixer for 16-bit PCM
+ * @details Converts between any two sample rates with a rational polyphase
+ * FIR filter (windowed sinc, anti-aliased for downsampling). Multi-channel
+ * input is averaged to mono first when mono output is requested, so the
+ * filter only runs once per frame. Input may be supplied in blocks of any
+ * size; filter history is carried between calls. The filter's inner product
+ * uses SSE on x86 and NEON on ARM.
+ * @author Callum Thompson
+ */
+class AudioResampler
+{
+public:
+    AudioResampler(int inputRate, int inputChannels, int outputRate, int outputChannels);
+
+    void process(const qint16 *input, qint64 frames, QVector<qint16> &output);
+    void flush(QVector<qint16> &output);
+    bool isPassthrough() const;
+
+    static bool convertFile(const QString &inputPath, const QString &outputPath, int outputRate, int outputChannels);
+
+private:
+    int inputChannels;
+    int outputChannels;
+    int workingChannels;          // Channels actually filtered (1 when downmixing)
+    int upFactor;                 // Interpolation factor L
+    int downFactor;               // Decimation factor M
+    int tapsPerPhase;             // Filter taps applied per output sample
+    QVector<float> coefficients;  // upFactor phases of tapsPerPhase taps, stored reversed
+    QVector<QVector<float>> history; // Buffered input per working channel
+    qint64 timeInBuffer;          // Position of the next output, in upsampled samples from the buffer start
+    qint64 framesIn = 0;          // Total input frames received
+    qint64 framesOut = 0;         // Total output frames produced
+
+    void designFilter();
+    void appendInput(const qint16 *input, qint64 frames);
+    void produceOutput(QVector<qint16> &output, qint64 limit);
+    static float dotProduct(const float *a, const float *b, int count);
+};
+
+#endif // AUDIORESAMPLER_H
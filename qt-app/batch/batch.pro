@@ -0,0 +1,33 @@
+QT       += core network multimedia
+
+# Settings reads keyFile.txt and is a widget class; no widgets are created
+QT += widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = rheumai-batch
+
+# Recording, transcription and summarization, shared with the application
+include(../pipeline.pri)
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    main.cpp \
+    batchprocessor.cpp \
+    ../settings.cpp \
+    ../windowbuilder.cpp
+
+HEADERS += \
+    batchprocessor.h \
+    ../settings.h \
+    ../windowbuilder.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+RESOURCES += \
+    ../resources.qrc
@@ -0,0 +1,397 @@
+/**
+ * @file batchprocessor.cpp
+ * @brief Definition of BatchProcessor class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 15, 2025
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDebug>
+#include "batchprocessor.h"
+#include "audiohandler.h"
+#include "filehandler.h"
+#include "responsecache.h"
+#include "summarygenerator.h"
+#include "visitqueue.h"
+
+namespace
+{
+/**
+ * @brief Returns the stream results are printed to
+ */
+QTextStream &console()
+{
+    static QTextStream out(stdout);
+    return out;
+}
+
+/**
+ * @brief Formats a stage duration, or "-" if the stage did not run
+ */
+QString formatMs(qint64 ms)
+{
+    return ms < 0 ? QString("-") : QString::number(ms / 1000.0, 'f', 2) + " s";
+}
+}
+
+/**
+ * @name BatchProcessor (constructor)
+ * @brief Prepares a batch
+ * @param[in] items: Recordings to process, in order
+ * @param[in] concurrency: Recordings transcribed at once
+ * @param[in] summarize: True to summarize the transcripts of items with a patient
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+BatchProcessor::BatchProcessor(const QList<BatchItem> &items, int concurrency, bool summarize, QObject *parent)
+    : QObject(parent), concurrency(qMax(1, concurrency)), summarize(summarize)
+{
+    for (const BatchItem &item : items)
+    {
+        ItemState state;
+        state.item = item;
+        state.audioSecs = AudioHandler::getInstance()->getAudioDuration(item.audioPath);
+        states.append(state);
+    }
+
+    visitQueue = new VisitQueue(this);
+    summaryGenerator = new SummaryGenerator(this);
+    connect(visitQueue, &VisitQueue::summaryReady, this, [this](int patientID, const QString &summaryText)
+            { handleSummary(patientID, summaryText, true); });
+    connect(visitQueue, &VisitQueue::summaryFailed, this, [this](int patientID)
+            { handleSummary(patientID, QString(), false); });
+}
+
+/**
+ * @name start
+ * @brief Starts processing the items
+ * @details finished() is emitted once every item is done, straight away if
+ * there are none.
+ * @author Callum Thompson
+ */
+void BatchProcessor::start()
+{
+    batchClock.start();
+    console() << "Processing " << states.size() << " recordings, " << concurrency << " at a time\n";
+    console().flush();
+    if (states.isEmpty())
+    {
+        printTotals();
+        emit finished(0);
+        return;
+    }
+    startNext();
+}
+
+/**
+ * @name readManifest
+ * @brief Reads the recordings listed in a manifest file
+ * @details Each line holds an audio path, optionally followed by a comma
+ * and the patient ID. Blank lines and lines starting with '#' are skipped.
+ * Relative paths are resolved against the manifest's directory.
+ * @param[in] manifestPath: Path to the manifest
+ * @param[out] ok: Set to false if the manifest could not be read or has an invalid line
+ * @return Items in manifest order
+ * @author Callum Thompson
+ */
+QList<BatchItem> BatchProcessor::readManifest(const QString &manifestPath, bool *ok)
+{
+    *ok = true;
+    QList<BatchItem> items;
+    QFile file(manifestPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qWarning() << "Could not open manifest:" << manifestPath;
+        *ok = false;
+        return items;
+    }
+
+    QDir baseDir = QFileInfo(manifestPath).absoluteDir();
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#'))
+        {
+            continue;
+        }
+
+        QStringList fields = line.split(',');
+        BatchItem item;
+        item.audioPath = baseDir.absoluteFilePath(fields.value(0).trimmed());
+        if (fields.size() > 1)
+        {
+            bool validID = false;
+            item.patientID = fields.value(1).trimmed().toInt(&validID);
+            if (!validID)
+            {
+                qWarning() << "Invalid patient ID on line" << lineNumber << "of" << manifestPath;
+                *ok = false;
+                return items;
+            }
+        }
+        items.append(item);
+    }
+    return items;
+}
+
+/**
+ * @name scanDirectory
+ * @brief Lists the WAV recordings in a directory
+ * @details Segment files left behind by an interrupted recording are skipped.
+ * @param[in] directoryPath: Directory to scan
+ * @param[in] patientID: Patient the recordings belong to, or -1
+ * @return Items sorted by file name
+ * @author Callum Thompson
+ */
+QList<BatchItem> BatchProcessor::scanDirectory(const QString &directoryPath, int patientID)
+{
+    QList<BatchItem> items;
+    QDir dir(directoryPath);
+    const QFileInfoList files = dir.entryInfoList({"*.wav", "*.WAV"}, QDir::Files, QDir::Name);
+    for (const QFileInfo &info : files)
+    {
+        if (info.completeBaseName().contains("_seg"))
+        {
+            continue;
+        }
+        items.append({info.absoluteFilePath(), patientID});
+    }
+    return items;
+}
+
+/**
+ * @name startNext
+ * @brief Starts transcribing queued items until the concurrency limit is reached
+ * @author Callum Thompson
+ */
+void BatchProcessor::startNext()
+{
+    while (transcribing < concurrency && nextItem < states.size())
+    {
+        int index = nextItem++;
+        states[index].startedMs = batchClock.elapsed();
+        ++transcribing;
+
+        TranscriptionJob *job = AudioHandler::getInstance()->transcribe(states[index].item.audioPath);
+        connect(job, &TranscriptionJob::finished, this, [this, index](const Transcript &transcript)
+                { handleTranscribed(index, transcript); });
+        connect(job, &TranscriptionJob::failed, this, [this, index](const QString &errorMessage)
+                { handleFailed(index, errorMessage); });
+    }
+}
+
+/**
+ * @name handleTranscribed
+ * @brief Saves a transcript and queues its summary
+ * @details Transcripts of items without a patient are written next to the
+ * recording instead.
+ * @param[in] index: Item that was transcribed
+ * @param[in] transcript: Transcript of the recording
+ * @author Callum Thompson
+ */
+void BatchProcessor::handleTranscribed(int index, const Transcript &transcript)
+{
+    ItemState &state = states[index];
+    state.transcribeMs = batchClock.elapsed() - state.startedMs;
+    --transcribing;
+
+    QElapsedTimer saveClock;
+    saveClock.start();
+    if (state.item.patientID >= 0)
+    {
+        //  Overwrite 'transcript_raw.txt' for summarizer and append to timestamped raw log
+        FileHandler::getInstance()->saveTranscript(state.item.patientID, transcript.getContent());
+        FileHandler::getInstance()->saveOrAppendRawTranscript(state.item.patientID, transcript);
+    }
+    else
+    {
+        QFileInfo info(state.item.audioPath);
+        QFile file(info.dir().filePath(info.completeBaseName() + ".txt"));
+        if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            QTextStream(&file) << transcript.getContent();
+        }
+        else
+        {
+            state.error = "Could not save transcript";
+        }
+    }
+    state.saveMs = saveClock.elapsed();
+
+    // Later recordings are transcribed while this one is summarized
+    startNext();
+    if (summarize && state.item.patientID >= 0 && state.error.isEmpty())
+    {
+        state.summaryQueuedMs = batchClock.elapsed();
+        awaitingSummary.insert(state.item.patientID, index);
+        visitQueue->summarize(state.item.patientID);
+        return;
+    }
+    finishItem(index);
+}
+
+/**
+ * @name handleFailed
+ * @brief Records a failed transcription
+ * @param[in] index: Item that failed
+ * @param[in] errorMessage: Reason for the failure
+ * @author Callum Thompson
+ */
+void BatchProcessor::handleFailed(int index, const QString &errorMessage)
+{
+    ItemState &state = states[index];
+    state.transcribeMs = batchClock.elapsed() - state.startedMs;
+    state.error = errorMessage;
+    --transcribing;
+    startNext();
+    finishItem(index);
+}
+
+/**
+ * @name handleSummary
+ * @brief Completes every item waiting for a patient's summary
+ * @details VisitQueue summarizes the patient's whole transcript for the day,
+ * so one summary completes all of that patient's items queued before it.
+ * @param[in] patientID: Patient that was summarized
+ * @param[in] summaryText: Response of the LLM
+ * @param[in] succeeded: False if no summary could be generated
+ * @author Callum Thompson
+ */
+void BatchProcessor::handleSummary(int patientID, const QString &summaryText, bool succeeded)
+{
+    int sections = 0;
+    if (succeeded)
+    {
+        summaryGenerator->setSummaryText(summaryText);
+        sections = summaryGenerator->sectionsFound();
+    }
+
+    const QList<int> indices = awaitingSummary.values(patientID);
+    awaitingSummary.remove(patientID);
+    for (int index : indices)
+    {
+        ItemState &state = states[index];
+        state.summarizeMs = batchClock.elapsed() - state.summaryQueuedMs;
+        state.summarySections = sections;
+        if (!succeeded)
+        {
+            state.error = "Summary failed";
+        }
+        finishItem(index);
+    }
+}
+
+/**
+ * @name finishItem
+ * @brief Reports a finished item and ends the batch after the last one
+ * @param[in] index: Item that finished
+ * @author Callum Thompson
+ */
+void BatchProcessor::finishItem(int index)
+{
+    ++finishedItems;
+    printItem(index);
+
+    if (finishedItems == states.size())
+    {
+        printTotals();
+        int failures = 0;
+        for (const ItemState &state : states)
+        {
+            failures += !state.error.isEmpty();
+        }
+        emit finished(failures);
+    }
+}
+
+/**
+ * @name printItem
+ * @brief Prints the result and stage timings of an item
+ * @param[in] index: Item to print
+ * @author Callum Thompson
+ */
+void BatchProcessor::printItem(int index) const
+{
+    const ItemState &state = states[index];
+    QString width = QString::number(states.size());
+    console() << QString("[%1/%2] ").arg(finishedItems, width.size()).arg(width)
+              << (state.error.isEmpty() ? "ok    " : "FAILED") << ' '
+              << QFileInfo(state.item.audioPath).fileName();
+    if (state.item.patientID >= 0)
+    {
+        console() << " (patient " << state.item.patientID << ')';
+    }
+    console() << "\n    audio " << QString::number(state.audioSecs, 'f', 1) << " s"
+              << ", queued " << formatMs(state.startedMs)
+              << ", transcribe " << formatMs(state.transcribeMs)
+              << ", save " << state.saveMs << " ms"
+              << ", summarize " << formatMs(state.summarizeMs);
+    if (state.summarizeMs >= 0 && state.error.isEmpty())
+    {
+        console() << " (" << state.summarySections << "/4 sections)";
+    }
+    if (!state.error.isEmpty())
+    {
+        console() << "\n    error: " << state.error;
+    }
+    console() << '\n';
+    console().flush();
+}
+
+/**
+ * @name printTotals
+ * @brief Prints the throughput of the whole batch
+ * @author Callum Thompson
+ */
+void BatchProcessor::printTotals() const
+{
+    double wallSecs = batchClock.elapsed() / 1000.0;
+    double audioSecs = 0.0;
+    qint64 transcribeMs = 0;
+    qint64 summarizeMs = 0;
+    int transcribed = 0;
+    int summarized = 0;
+    int failures = 0;
+    for (const ItemState &state : states)
+    {
+        audioSecs += state.audioSecs;
+        failures += !state.error.isEmpty();
+        if (state.transcribeMs >= 0)
+        {
+            transcribeMs += state.transcribeMs;
+            ++transcribed;
+        }
+        if (state.summarizeMs >= 0)
+        {
+            summarizeMs += state.summarizeMs;
+            ++summarized;
+        }
+    }
+
+    console() << "\n" << states.size() - failures << " of " << states.size() << " recordings processed in "
+              << QString::number(wallSecs, 'f', 1) << " s\n";
+    if (wallSecs > 0.0)
+    {
+        console() << "  " << QString::number(audioSecs / 60.0, 'f', 1) << " min of audio, "
+                  << QString::number(audioSecs / wallSecs, 'f', 1) << "x real time, "
+                  << QString::number(states.size() * 60.0 / wallSecs, 'f', 1) << " recordings/min\n";
+    }
+    if (transcribed > 0)
+    {
+        console() << "  mean transcribe " << formatMs(transcribeMs / transcribed) << "\n";
+    }
+    if (summarized > 0)
+    {
+        console() << "  mean summarize " << formatMs(summarizeMs / summarized) << "\n";
+        DiskCache::Statistics stored = ResponseCache::getInstance()->statistics();
+        console() << "  stored summaries used " << stored.hits << " of " << stored.hits + stored.misses << "\n";
+    }
+    console().flush();
+}
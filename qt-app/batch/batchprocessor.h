@@ -0,0 +1,98 @@
+/**
+ * @file batchprocessor.h
+ * @brief Declaration of BatchItem struct and BatchProcessor class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 15, 2025
+ */
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMultiHash>
+#include <QString>
+#include "transcript.h"
+
+class SummaryGenerator;
+class VisitQueue;
+
+/**
+ * @struct BatchItem
+ * @brief Recording to process and the patient it belongs to
+ * @details Items without a patient are only transcribed; the transcript is
+ * written next to the recording.
+ * @author Callum Thompson
+ */
+struct BatchItem
+{
+    QString audioPath;
+    int patientID = -1; // Patient the recording belongs to, or -1
+};
+
+/**
+ * @class BatchProcessor
+ * @brief Transcribes, saves and summarizes a list of recordings without a
+ * user interface
+ * @details Runs the same pipeline as the application: AudioHandler
+ * transcribes, FileHandler saves, and VisitQueue summarizes through
+ * LLMClient. Up to `concurrency` recordings are transcribed at once;
+ * summaries are generated in parallel with them, one per patient. Each item's stage timings are printed as it finishes, and
+ * the overall throughput once every item has finished.
+ * @author Callum Thompson
+ */
+class BatchProcessor : public QObject
+{
+    Q_OBJECT
+
+public:
+    BatchProcessor(const QList<BatchItem> &items, int concurrency, bool summarize, QObject *parent = nullptr);
+
+    void start();
+
+    static QList<BatchItem> readManifest(const QString &manifestPath, bool *ok);
+    static QList<BatchItem> scanDirectory(const QString &directoryPath, int patientID);
+
+signals:
+    void finished(int failedItems); // Every item has been processed
+
+private:
+    /**
+     * @brief Progress and stage timings of one item, in milliseconds
+     */
+    struct ItemState
+    {
+        BatchItem item;
+        double audioSecs = 0.0;
+        qint64 startedMs = -1;    // Time the item left the queue, from the start of the batch
+        qint64 transcribeMs = -1;
+        qint64 saveMs = -1;
+        qint64 summaryQueuedMs = -1;
+        qint64 summarizeMs = -1;
+        int summarySections = 0;  // Sections found in the summary
+        QString error;
+    };
+
+    QList<ItemState> states;
+    int concurrency;
+    bool summarize;
+    int nextItem = 0;             // Next item to start transcribing
+    int transcribing = 0;         // Items being transcribed
+    int finishedItems = 0;
+    QElapsedTimer batchClock;
+    QMultiHash<int, int> awaitingSummary; // Items waiting for a summary, by patient
+    VisitQueue *visitQueue;
+    SummaryGenerator *summaryGenerator;
+
+    void startNext();
+    void handleTranscribed(int index, const Transcript &transcript);
+    void handleFailed(int index, const QString &errorMessage);
+    void handleSummary(int patientID, const QString &summaryText, bool succeeded);
+    void finishItem(int index);
+    void printItem(int index) const;
+    void printTotals() const;
+};
+
+#endif // BATCHPROCESSOR_H
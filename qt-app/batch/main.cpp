@@ -0,0 +1,86 @@
+/**
+ * @file main.cpp
+ * @brief Entry point of the batch processing tool.
+ * @details Transcribes, and optionally summarizes, a directory of recordings
+ * or the recordings listed in a manifest without opening the main window.
+ * @author Callum Thompson
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QTimer>
+#include <QDebug>
+#include "batchprocessor.h"
+#include "settings.h"
+
+/**
+ * @name main
+ * @brief Main function of the batch tool.
+ * @details Reads the recordings to process, loads the API keys and
+ * preferences from keyFile.txt, and processes the recordings. Run it from
+ * the application's directory so the keyFile and patient folders are found.
+ * @return 0 if every recording was processed, 1 otherwise.
+ * @param argc Number of command line arguments.
+ * @param argv Array of command line arguments.
+ * @author Callum Thompson
+ */
+int main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("rheumai-batch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Transcribes and summarizes recorded visits.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Directory of WAV recordings, or a manifest of \"path[,patientID]\" lines.");
+    QCommandLineOption jobsOption({"j", "jobs"}, "Recordings transcribed at once.", "count", "2");
+    QCommandLineOption patientOption("patient", "Patient the recordings in a directory belong to.", "id");
+    QCommandLineOption noSummaryOption("no-summary", "Only transcribe the recordings.");
+    parser.addOption(jobsOption);
+    parser.addOption(patientOption);
+    parser.addOption(noSummaryOption);
+    parser.process(a);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    bool ok = true;
+    int jobs = parser.value(jobsOption).toInt(&ok);
+    if (!ok || jobs < 1) {
+        qWarning() << "Invalid job count:" << parser.value(jobsOption);
+        return 1;
+    }
+    int patientID = -1;
+    if (parser.isSet(patientOption)) {
+        patientID = parser.value(patientOption).toInt(&ok);
+        if (!ok || patientID < 0) {
+            qWarning() << "Invalid patient ID:" << parser.value(patientOption);
+            return 1;
+        }
+    }
+
+    // Collect the recordings
+    QList<BatchItem> items;
+    QFileInfo input(arguments.first());
+    if (input.isDir()) {
+        items = BatchProcessor::scanDirectory(input.absoluteFilePath(), patientID);
+    } else {
+        items = BatchProcessor::readManifest(input.absoluteFilePath(), &ok);
+        if (!ok) {
+            return 1;
+        }
+    }
+
+    // Load API keys and transcription preferences; no settings window is shown
+    Settings::getInstance(nullptr);
+
+    BatchProcessor processor(items, jobs, !parser.isSet(noSummaryOption));
+    QObject::connect(&processor, &BatchProcessor::finished, &a, [](int failedItems) {
+        QCoreApplication::exit(failedItems == 0 ? 0 : 1);
+    });
+    QTimer::singleShot(0, &processor, &BatchProcessor::start);
+
+    return a.exec();
+}
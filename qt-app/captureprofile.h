@@ -0,0 +1,53 @@
+/**
+ * @file captureprofile.h
+ * @brief Declaration of CaptureProfile struct
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 6, 2025
+ */
+
+#ifndef CAPTUREPROFILE_H
+#define CAPTUREPROFILE_H
+
+#include <QString>
+
+/**
+ * @struct CaptureProfile
+ * @brief Audio format that recordings are stored and uploaded in
+ * @details The speech profile (16 kHz mono) is what both transcription
+ * services process internally and is about six times smaller than the
+ * high fidelity profile (48 kHz stereo), which is kept for playback quality.
+ * @author Callum Thompson
+ */
+struct CaptureProfile
+{
+    QString name;    // Name stored in the settings key file
+    int sampleRate;  // Frames per second
+    int channels;    // Number of channels
+
+    /**
+     * @brief 16 kHz mono, the native format of the speech recognizers
+     */
+    static CaptureProfile speech()
+    {
+        return {"Speech", 16000, 1};
+    }
+
+    /**
+     * @brief 48 kHz stereo, the microphone's native format
+     */
+    static CaptureProfile highFidelity()
+    {
+        return {"High Fidelity", 48000, 2};
+    }
+
+    /**
+     * @brief Returns the profile with the given name, defaulting to speech
+     */
+    static CaptureProfile fromName(const QString &name)
+    {
+        return name == highFidelity().name ? highFidelity() : speech();
+    }
+};
+
+#endif // CAPTUREPROFILE_H
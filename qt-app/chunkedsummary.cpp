@@ -0,0 +1,230 @@
+/**
+ * @file chunkedsummary.cpp
+ * @brief Definition of ChunkedSummary class
+ *
+ * Map-reduce summarization of transcripts too long for a single request.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 17, 2025
+ */
+
+#include <QRegularExpression>
+#include <QDebug>
+#include "chunkedsummary.h"
+#include "llmclient.h"
+
+/**
+ * @name ChunkedSummary (constructor)
+ * @brief Prepares the summary of a split transcript
+ * @param[in] parts: Consecutive parts of the transcript, from splitTranscript()
+ * @param[in] refresh: True to generate new summaries even if some are stored
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+ChunkedSummary::ChunkedSummary(const QStringList &parts, bool refresh, QObject *parent)
+    : QObject(parent), parts(parts), refresh(refresh), partSummaries(parts.size()), remaining(parts.size())
+{
+    // No logic body
+}
+
+/**
+ * @name start
+ * @brief Sends the summary requests of all parts
+ * @author Callum Thompson
+ */
+void ChunkedSummary::start()
+{
+    for (int index = 0; index < parts.size(); ++index)
+    {
+        // The number of parts is left out, so earlier parts keep their stored summaries as the day grows
+        QString prompt = QString("The transcript below is part %1 of one day's visit recordings. "
+                                 "Write the note for this part only; the notes of all parts will be "
+                                 "combined afterwards.\n\n")
+                             .arg(index + 1)
+                         + parts[index];
+
+        LLMRequest *request = LLMClient::getInstance()->sendRequest(prompt, index, refresh);
+        connect(request, &LLMRequest::finished, this, [this, index](const QString &summaryText)
+                { handlePartSummary(index, summaryText); });
+        connect(request, &LLMRequest::failed, this, [this, index](const QString &errorMessage)
+                { fail(QString("Part %1 could not be summarized: %2").arg(index + 1).arg(errorMessage)); });
+    }
+}
+
+/**
+ * @name splitTranscript
+ * @brief Splits a transcript into parts that each fit a request budget
+ * @details Recordings are separated by "Timestamp:" lines and are packed
+ * into parts in order, never split unless a single recording exceeds the
+ * budget; it is then split at line, sentence or word boundaries.
+ * @param[in] transcript: Full transcript
+ * @param[in] maxChars: Largest size of a part
+ * @return Parts in order; a single part if the transcript fits the budget
+ * @author Callum Thompson
+ */
+QStringList ChunkedSummary::splitTranscript(const QString &transcript, int maxChars)
+{
+    if (maxChars <= 0 || transcript.size() <= maxChars)
+    {
+        return {transcript};
+    }
+
+    // Start of each recording
+    static const QRegularExpression timestampLine("^Timestamp:", QRegularExpression::MultilineOption);
+    QList<qsizetype> starts = {0};
+    QRegularExpressionMatchIterator matches = timestampLine.globalMatch(transcript);
+    while (matches.hasNext())
+    {
+        qsizetype start = matches.next().capturedStart();
+        if (start > 0)
+        {
+            starts.append(start);
+        }
+    }
+    starts.append(transcript.size());
+
+    QStringList chunks;
+    QString current;
+    for (int i = 0; i + 1 < starts.size(); ++i)
+    {
+        QString segment = transcript.mid(starts[i], starts[i + 1] - starts[i]);
+        if (current.size() + segment.size() <= maxChars)
+        {
+            current += segment;
+            continue;
+        }
+
+        if (!current.trimmed().isEmpty())
+        {
+            chunks.append(current.trimmed());
+        }
+        current.clear();
+        if (segment.size() <= maxChars)
+        {
+            current = segment;
+        }
+        else
+        {
+            appendPieces(chunks, segment, maxChars);
+        }
+    }
+    if (!current.trimmed().isEmpty())
+    {
+        chunks.append(current.trimmed());
+    }
+    return chunks;
+}
+
+/**
+ * @name appendPieces
+ * @brief Splits a recording longer than the budget into pieces
+ * @details Each piece ends at the last line break, sentence end or space
+ * within the budget, preferring them in that order.
+ * @param[in,out] chunks: Receives the pieces
+ * @param[in] segment: Text of the recording
+ * @param[in] maxChars: Largest size of a piece
+ * @author Callum Thompson
+ */
+void ChunkedSummary::appendPieces(QStringList &chunks, const QString &segment, int maxChars)
+{
+    QStringView rest(segment);
+    while (rest.size() > maxChars)
+    {
+        QStringView window = rest.first(maxChars);
+        qsizetype cut = window.lastIndexOf(u'\n');
+        if (cut < maxChars / 2)
+        {
+            cut = window.lastIndexOf(u". ") + 1;
+        }
+        if (cut < maxChars / 2)
+        {
+            cut = window.lastIndexOf(u' ');
+        }
+        if (cut < maxChars / 2)
+        {
+            cut = maxChars;
+        }
+
+        QString piece = rest.first(cut).trimmed().toString();
+        if (!piece.isEmpty())
+        {
+            chunks.append(piece);
+        }
+        rest = rest.sliced(cut);
+    }
+    if (!rest.trimmed().isEmpty())
+    {
+        chunks.append(rest.trimmed().toString());
+    }
+}
+
+/**
+ * @name handlePartSummary
+ * @brief Records the summary of a part and merges once all are done
+ * @param[in] index: Part that was summarized
+ * @param[in] summaryText: Summary of the part
+ * @author Callum Thompson
+ */
+void ChunkedSummary::handlePartSummary(int index, const QString &summaryText)
+{
+    if (ended)
+    {
+        return;
+    }
+    partSummaries[index] = summaryText;
+    if (--remaining == 0)
+    {
+        merge();
+    }
+}
+
+/**
+ * @name merge
+ * @brief Combines the part summaries into one
+ * @details The merge is streamed like any other summary, so its sections
+ * are shown as they are written.
+ * @author Callum Thompson
+ */
+void ChunkedSummary::merge()
+{
+    QString prompt = QString("The notes below were written from %1 consecutive parts of one day's visit "
+                             "transcript, in order. Combine them into a single note, merging repeated "
+                             "details and keeping the later information where the parts disagree.")
+                         .arg(parts.size());
+    for (int index = 0; index < partSummaries.size(); ++index)
+    {
+        prompt += QString("\n\nNotes of part %1:\n\n").arg(index + 1) + partSummaries[index];
+    }
+
+    LLMRequest *request = LLMClient::getInstance()->sendRequest(prompt, QVariant(), refresh);
+    connect(request, &LLMRequest::partialResponse, this, &ChunkedSummary::partialResponse);
+    connect(request, &LLMRequest::finished, this, [this](const QString &summaryText)
+            {
+                if (!ended)
+                {
+                    ended = true;
+                    emit finished(summaryText);
+                }
+            });
+    connect(request, &LLMRequest::failed, this, [this](const QString &errorMessage)
+            { fail("The notes could not be combined: " + errorMessage); });
+}
+
+/**
+ * @name fail
+ * @brief Fails the summary once
+ * @details Requests still in flight finish on their own; their responses
+ * are ignored but stored for the next attempt.
+ * @param[in] errorMessage: Description of the failure
+ * @author Callum Thompson
+ */
+void ChunkedSummary::fail(const QString &errorMessage)
+{
+    if (ended)
+    {
+        return;
+    }
+    ended = true;
+    qWarning() << "Chunked summary failed:" << errorMessage;
+    emit failed(errorMessage);
+}
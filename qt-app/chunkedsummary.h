@@ -0,0 +1,57 @@
+/**
+ * @file chunkedsummary.h
+ * @brief Declaration of ChunkedSummary class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 17, 2025
+ */
+
+#ifndef CHUNKEDSUMMARY_H
+#define CHUNKEDSUMMARY_H
+
+#include <QObject>
+#include <QStringList>
+
+/**
+ * @class ChunkedSummary
+ * @brief Summarizes a long transcript as several parts sent concurrently,
+ * then merges their summaries
+ * @details Each part is summarized in the usual sections by its own
+ * request, all at once; a final request combines the part summaries into
+ * one. The total time is governed by the slowest part and the merge rather
+ * than the length of the transcript. Parts are packed from the start of
+ * the transcript, so appending to a day's transcript leaves the earlier
+ * parts unchanged and their summaries are found in ResponseCache. The
+ * first failed request fails the whole summary.
+ * @author Callum Thompson
+ */
+class ChunkedSummary : public QObject
+{
+    Q_OBJECT
+
+public:
+    ChunkedSummary(const QStringList &parts, bool refresh, QObject *parent);
+
+    void start();
+
+    static QStringList splitTranscript(const QString &transcript, int maxChars);
+
+signals:
+    void partialResponse(const QString &textSoFar); // Merged summary received so far
+    void finished(const QString &summaryText);      // Merged summary
+    void failed(const QString &errorMessage);       // A part or the merge could not be summarized
+
+private:
+    QStringList parts;
+    bool refresh;
+    QStringList partSummaries;
+    int remaining;             // Parts not yet summarized
+    bool ended = false;
+
+    void handlePartSummary(int index, const QString &summaryText);
+    void merge();
+    void fail(const QString &errorMessage);
+    static void appendPieces(QStringList &chunks, const QString &segment, int maxChars);
+};
+
+#endif // CHUNKEDSUMMARY_H
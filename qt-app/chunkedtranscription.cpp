@@ -0,0 +1,137 @@
+/**
+ * @file chunkedtranscription.cpp
+ * @brief Definition of ChunkedTranscription class
+ *
+ * Uploads the chunks of a long recording in parallel and merges their
+ * transcripts by timestamp.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 9, 2025
+ */
+
+#include <algorithm>
+#include <QStringList>
+#include <QDebug>
+#include "chunkedtranscription.h"
+
+/**
+ * @name ChunkedTranscription (constructor)
+ * @brief Prepares the chunks of a recording for upload
+ * @param[in] chunks: Encoded chunks in recording order
+ * @param[in] maxParallel: Maximum number of uploads in flight
+ * @param[in] uploader: Sends one chunk and returns its reply, or nullptr on failure
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+ChunkedTranscription::ChunkedTranscription(const QList<UploadChunk> &chunks, int maxParallel, Uploader uploader, QObject *parent)
+    : QObject(parent), chunks(chunks), maxParallel(qMax(1, maxParallel)), uploader(std::move(uploader)), remaining(chunks.size())
+{
+    // No logic body
+}
+
+/**
+ * @name start
+ * @brief Starts the first uploads
+ * @author Callum Thompson
+ */
+void ChunkedTranscription::start()
+{
+    while (!ended && nextChunk < chunks.size() && active.size() < maxParallel)
+    {
+        startNext();
+    }
+}
+
+/**
+ * @name startNext
+ * @brief Uploads the next chunk in order
+ * @details The chunk's audio is released once it has been handed to the
+ * backend.
+ * @author Callum Thompson
+ */
+void ChunkedTranscription::startNext()
+{
+    int index = nextChunk++;
+    TranscriptionRequest *request = uploader(chunks[index]);
+    chunks[index].flac.clear();
+    if (!request)
+    {
+        ended = true;
+        abortAll();
+        emit failed(QString("Chunk %1 could not be sent").arg(index));
+        return;
+    }
+
+    request->setParent(this);
+    active.append(request);
+    emit requestStarted(request);
+    connect(request, &TranscriptionRequest::finished, this, [this, index, request]()
+            { handleResult(index, request); });
+}
+
+/**
+ * @name handleResult
+ * @brief Records the transcript of a chunk and starts the next upload
+ * @details Segment start times are converted from chunk time to recording
+ * time.
+ * @param[in] index: Chunk index
+ * @param[in] request: Finished request
+ * @author Callum Thompson
+ */
+void ChunkedTranscription::handleResult(int index, TranscriptionRequest *request)
+{
+    request->deleteLater();
+    active.removeAll(request);
+    if (ended)
+    {
+        return; // Another chunk already failed
+    }
+
+    if (!request->isSuccessful())
+    {
+        qWarning() << "Chunk" << index << "transcription failed:" << request->errorString();
+        ended = true;
+        abortAll();
+        emit failed(request->errorString());
+        return;
+    }
+
+    const TrimmedAudioMap &timeMap = chunks[index].timeMap;
+    for (const TranscriptSegment &segment : request->segments())
+    {
+        segments.append({timeMap.toOriginalSecs(segment.startSecs), segment.text});
+    }
+    if (--remaining > 0)
+    {
+        start();
+        return;
+    }
+
+    // Merge the segments of every chunk by their time in the recording
+    ended = true;
+    std::stable_sort(segments.begin(), segments.end(), [](const TranscriptSegment &a, const TranscriptSegment &b)
+                     { return a.startSecs < b.startSecs; });
+    QStringList texts;
+    for (const TranscriptSegment &segment : segments)
+    {
+        texts.append(segment.text);
+    }
+    emit finished(texts.join(' '));
+}
+
+/**
+ * @name abortAll
+ * @brief Aborts every upload still in flight
+ * @author Callum Thompson
+ */
+void ChunkedTranscription::abortAll()
+{
+    const QList<QPointer<TranscriptionRequest>> running = active;
+    for (const QPointer<TranscriptionRequest> &request : running)
+    {
+        if (request)
+        {
+            request->abort();
+        }
+    }
+}
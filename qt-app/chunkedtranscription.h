@@ -0,0 +1,73 @@
+/**
+ * @file chunkedtranscription.h
+ * @brief Declaration of UploadChunk struct and ChunkedTranscription class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 9, 2025
+ */
+
+#ifndef CHUNKEDTRANSCRIPTION_H
+#define CHUNKEDTRANSCRIPTION_H
+
+#include <functional>
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QPointer>
+#include "transcriptionbackend.h"
+#include "voiceactivitydetector.h"
+
+/**
+ * @struct UploadChunk
+ * @brief Encoded audio ready to upload and the part of the recording it holds
+ * @author Callum Thompson
+ */
+struct UploadChunk
+{
+    QByteArray flac;          // FLAC stream of the chunk
+    TrimmedAudioMap timeMap;  // Maps chunk times to recording times
+};
+
+/**
+ * @class ChunkedTranscription
+ * @brief Transcribes a long recording as several chunks uploaded concurrently
+ * @details At most a fixed number of chunks are uploaded at once; the next
+ * chunk starts as soon as one finishes. Each result's segment timestamps
+ * are mapped back to the recording and the segments of all chunks are
+ * merged in time order, so the total time is governed by the slowest chunk
+ * rather than the length of the recording. The first failed chunk fails
+ * the whole transcription and aborts the others.
+ * @author Callum Thompson
+ */
+class ChunkedTranscription : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Uploader = std::function<TranscriptionRequest *(const UploadChunk &chunk)>;
+
+    ChunkedTranscription(const QList<UploadChunk> &chunks, int maxParallel, Uploader uploader, QObject *parent);
+
+    void start();
+
+signals:
+    void requestStarted(TranscriptionRequest *request); // A chunk upload has been sent
+    void finished(const QString &text);        // All chunks were transcribed
+    void failed(const QString &errorMessage);  // A chunk could not be transcribed
+
+private:
+    QList<UploadChunk> chunks;
+    int maxParallel;
+    Uploader uploader;
+    int nextChunk = 0;                         // Index of the next chunk to upload
+    int remaining;                             // Chunks not yet transcribed
+    bool ended = false;
+    QList<TranscriptSegment> segments;         // Segments of all finished chunks, in recording time
+    QList<QPointer<TranscriptionRequest>> active; // Uploads in flight
+
+    void startNext();
+    void handleResult(int index, TranscriptionRequest *request);
+    void abortAll();
+};
+
+#endif // CHUNKEDTRANSCRIPTION_H
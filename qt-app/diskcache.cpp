@@ -0,0 +1,206 @@
+/**
+ * @file diskcache.cpp
+ * @brief Definition of DiskCache class
+ *
+ * Each entry is a UTF-8 text file named after a digest of its key. The
+ * file's modification time records when it was last used, so the eviction
+ * order survives restarts without a separate index file.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 16, 2025
+ */
+
+#include <algorithm>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QDebug>
+#include "diskcache.h"
+
+/**
+ * @name DiskCache (constructor)
+ * @brief Initializes a cache stored in a directory
+ * @details The directory is only read when the cache is first used.
+ * @param[in] directory: Directory holding the entry files
+ * @param[in] maximumBytes: Size the cache may grow to on disk
+ * @author Callum Thompson
+ */
+DiskCache::DiskCache(const QString &directory, qint64 maximumBytes)
+    : directory(directory), maximumBytes(maximumBytes)
+{
+    // No logic body
+}
+
+/**
+ * @name lookup
+ * @brief Returns a stored entry
+ * @details A hit marks the entry as recently used.
+ * @param[in] key: Key of the entry
+ * @param[out] text: Receives the entry on a hit
+ * @return True if the entry was stored
+ * @author Callum Thompson
+ */
+bool DiskCache::lookup(const QString &key, QString &text)
+{
+    QMutexLocker locker(&mutex);
+    loadIndex();
+    QString name = fileName(key);
+    auto it = entries.find(name);
+    if (it == entries.end())
+    {
+        ++counts.misses;
+        return false;
+    }
+
+    QFile file(QDir(directory).filePath(name));
+    if (!file.open(QIODevice::ReadWrite))
+    {
+        // Deleted behind our back
+        totalBytes -= it->size;
+        entries.erase(it);
+        ++counts.misses;
+        return false;
+    }
+    text = QString::fromUtf8(file.readAll());
+    ++counts.hits;
+    counts.bytesRead += it->size;
+
+    QDateTime now = QDateTime::currentDateTime();
+    file.setFileTime(now, QFileDevice::FileModificationTime);
+    it->lastUsedMs = now.toMSecsSinceEpoch();
+    return true;
+}
+
+/**
+ * @name store
+ * @brief Saves an entry and evicts old entries if the cache is full
+ * @param[in] key: Key of the entry
+ * @param[in] text: Text to store
+ * @author Callum Thompson
+ */
+void DiskCache::store(const QString &key, const QString &text)
+{
+    QMutexLocker locker(&mutex);
+    loadIndex();
+    QDir().mkpath(directory);
+
+    QString name = fileName(key);
+    QByteArray contents = text.toUtf8();
+    QSaveFile file(QDir(directory).filePath(name));
+    if (!file.open(QIODevice::WriteOnly) || file.write(contents) != contents.size() || !file.commit())
+    {
+        qWarning() << "Could not write cache entry:" << file.errorString();
+        return;
+    }
+
+    auto it = entries.find(name);
+    if (it != entries.end())
+    {
+        totalBytes -= it->size;
+    }
+    entries.insert(name, {contents.size(), QDateTime::currentMSecsSinceEpoch()});
+    totalBytes += contents.size();
+    evict();
+}
+
+/**
+ * @name setMaximumSize
+ * @brief Sets the size the cache may grow to on disk
+ * @param[in] bytes: Largest total size of the stored entries; 0 keeps nothing
+ * @author Callum Thompson
+ */
+void DiskCache::setMaximumSize(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    maximumBytes = qMax<qint64>(0, bytes);
+    if (loaded)
+    {
+        evict();
+    }
+}
+
+/**
+ * @name statistics
+ * @brief Returns the hits and misses of the cache so far
+ * @return Lookup counts since the cache was created
+ * @author Callum Thompson
+ */
+DiskCache::Statistics DiskCache::statistics()
+{
+    QMutexLocker locker(&mutex);
+    return counts;
+}
+
+/**
+ * @name fileName
+ * @brief Returns the name of the file holding an entry
+ * @param[in] key: Key of the entry
+ * @return File name within the cache directory
+ * @author Callum Thompson
+ */
+QString DiskCache::fileName(const QString &key) const
+{
+    return QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".txt";
+}
+
+/**
+ * @name loadIndex
+ * @brief Reads the sizes and last uses of the stored entries
+ * @details Only done once; the index is kept up to date afterwards. Must
+ * be called with the mutex held.
+ * @author Callum Thompson
+ */
+void DiskCache::loadIndex()
+{
+    if (loaded)
+    {
+        return;
+    }
+    loaded = true;
+
+    const QFileInfoList files = QDir(directory).entryInfoList({"*.txt"}, QDir::Files);
+    for (const QFileInfo &info : files)
+    {
+        entries.insert(info.fileName(), {info.size(), info.lastModified().toMSecsSinceEpoch()});
+        totalBytes += info.size();
+    }
+    evict();
+}
+
+/**
+ * @name evict
+ * @brief Deletes the least recently used entries until the cache fits
+ * its size limit
+ * @details Must be called with the mutex held.
+ * @author Callum Thompson
+ */
+void DiskCache::evict()
+{
+    if (totalBytes <= maximumBytes)
+    {
+        return;
+    }
+
+    QList<QPair<qint64, QString>> byAge;
+    byAge.reserve(entries.size());
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it)
+    {
+        byAge.append({it->lastUsedMs, it.key()});
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    QDir dir(directory);
+    for (const QPair<qint64, QString> &oldest : byAge)
+    {
+        if (totalBytes <= maximumBytes)
+        {
+            break;
+        }
+        dir.remove(oldest.second);
+        totalBytes -= entries.take(oldest.second).size;
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * @file diskcache.h
+ * @brief Declaration of DiskCache class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 16, 2025
+ */
+
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+/**
+ * @class DiskCache
+ * @brief Keeps text entries in a directory, evicting the least recently
+ * used once it grows past its size limit
+ * @details Each entry is a UTF-8 text file named after a digest of its key.
+ * Lookups and stores are thread-safe. Hits and misses are counted so the
+ * caches built on it can report how much they save.
+ * @author Callum Thompson
+ */
+class DiskCache
+{
+public:
+    /**
+     * @brief Lookups since the cache was created
+     */
+    struct Statistics
+    {
+        int hits = 0;
+        int misses = 0;
+        qint64 bytesRead = 0; // Size of the entries returned by hits
+    };
+
+    bool lookup(const QString &key, QString &text);
+    void store(const QString &key, const QString &text);
+    void setMaximumSize(qint64 bytes);
+    Statistics statistics();
+
+protected:
+    DiskCache(const QString &directory, qint64 maximumBytes);
+    virtual ~DiskCache() = default;
+
+private:
+    /**
+     * @brief Size and last use of a stored entry
+     */
+    struct Entry
+    {
+        qint64 size;
+        qint64 lastUsedMs; // Milliseconds since the epoch
+    };
+
+    QString directory;
+    QHash<QString, Entry> entries;   // Keyed by file name
+    qint64 totalBytes = 0;
+    qint64 maximumBytes;
+    bool loaded = false;
+    Statistics counts;
+    QMutex mutex;
+
+    QString fileName(const QString &key) const;
+    void loadIndex();
+    void evict();
+};
+
+#endif // DISKCACHE_H
@@ -14,13 +14,26 @@
  */
 
 #include <QTextStream>
+#include <QDateTime>
 #include <QDebug>
+#include <QCryptographicHash>
+#include <QCborMap>
+#include <QCborValue>
+#include <QFileInfo>
 #include "filehandler.h"
+#include "notesections.h"
 
 // Create an instance of the FileHandler class since it is a singleton
 // This instance will be used to access the methods of the class
 FileHandler *FileHandler::instance = nullptr;
 
+namespace
+{
+// Format of summary.cbor. Sections are stored by title, so adding one does
+// not change the format; increase this only for incompatible changes.
+const int summaryRecordVersion = 1;
+}
+
 /**
  * @name FileHandler (constructor)
  * @brief Initializes the FileHandler instance
@@ -191,6 +204,216 @@ QString FileHandler::loadSummaryText(int patientID)
     return summaryContent;// Return the loaded summary
 }
 
+/**
+ * @name saveSummaryText
+ * @brief Saves the summary of a patient
+ * @details Overwrites `summary.txt` in the patient's folder.
+ * @param patientID The ID of the patient
+ * @param summaryText The summary returned by the LLM
+ * @return True if the summary was saved
+ * @author Callum Thompson
+ */
+bool FileHandler::saveSummaryText(int patientID, const QString &summaryText)
+{
+    QString folderPath = patientDatabasePath + "/" + QString::number(patientID);
+    QDir().mkpath(folderPath); // Ensure patient folder exists
+
+    QFile file(folderPath + "/summary.txt");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qInfo() << "Failed to save summary!";
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << summaryText;
+    file.close();
+    return true;
+}
+
+/**
+ * @name saveSummaryMark
+ * @brief Records how much of the transcript the saved summary covers
+ * @details Writes `summary_mark.json` in the patient's folder with the
+ * length and digest of the transcript that was summarized.
+ * @param patientID The ID of the patient
+ * @param summarizedTranscript The transcript the saved summary was generated from
+ * @return True if the mark was saved
+ * @author Callum Thompson
+ */
+bool FileHandler::saveSummaryMark(int patientID, const QString &summarizedTranscript)
+{
+    QString folderPath = patientDatabasePath + "/" + QString::number(patientID);
+    QDir().mkpath(folderPath); // Ensure patient folder exists
+
+    QJsonObject mark;
+    mark["chars"] = summarizedTranscript.size();
+    mark["sha1"] = QString::fromLatin1(
+        QCryptographicHash::hash(summarizedTranscript.toUtf8(), QCryptographicHash::Sha1).toHex());
+
+    QFile file(folderPath + "/summary_mark.json");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qInfo() << "Failed to save summary mark!";
+        return false;
+    }
+    file.write(QJsonDocument(mark).toJson(QJsonDocument::Compact));
+    file.close();
+    return true;
+}
+
+/**
+ * @name loadSummaryMark
+ * @brief Returns how much of a transcript the saved summary covers
+ * @details The mark only applies while the transcript still starts with
+ * the text that was summarized; a transcript that was replaced, such as on
+ * a new day, is not covered at all.
+ * @param patientID The ID of the patient
+ * @param transcript The patient's current transcript
+ * @return Length of the start of the transcript already summarized, or 0
+ * @author Callum Thompson
+ */
+qsizetype FileHandler::loadSummaryMark(int patientID, const QString &transcript)
+{
+    QFile file(patientDatabasePath + "/" + QString::number(patientID) + "/summary_mark.json");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return 0;
+    }
+    QJsonObject mark = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    qsizetype chars = mark.value("chars").toInteger();
+    if (chars <= 0 || chars > transcript.size())
+    {
+        return 0;
+    }
+    QByteArray digest = QCryptographicHash::hash(QStringView(transcript).first(chars).toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QString::fromLatin1(digest) == mark.value("sha1").toString() ? chars : 0;
+}
+
+/**
+ * @name saveSummaryRecord
+ * @brief Saves the parsed summary of a patient
+ * @details Writes `summary.cbor` in the patient's folder, holding the
+ * sections by title along with the model, the prompt version and the time
+ * `summary.txt` was written. Must be called after saveSummaryText().
+ * @param patientID The ID of the patient
+ * @param summary The summary parsed from `summary.txt`
+ * @param model The model that generated the summary, or empty if unknown
+ * @param promptVersion The version of the prompt it was generated from, or empty if unknown
+ * @return True if the record was saved
+ * @author Callum Thompson
+ */
+bool FileHandler::saveSummaryRecord(int patientID, const Summary &summary, const QString &model,
+                                    const QString &promptVersion)
+{
+    QString folderPath = patientDatabasePath + "/" + QString::number(patientID);
+    QDir().mkpath(folderPath); // Ensure patient folder exists
+
+    QCborMap sections;
+    sections[NoteSections::title(NoteSections::IntervalHistory).toString()] = summary.getIntervalHistory();
+    sections[NoteSections::title(NoteSections::PhysicalExamination).toString()] = summary.getPhysicalExamination();
+    sections[NoteSections::title(NoteSections::CurrentStatus).toString()] = summary.getCurrentStatus();
+    sections[NoteSections::title(NoteSections::Plan).toString()] = summary.getPlan();
+
+    QFileInfo textInfo(folderPath + "/summary.txt");
+    QCborMap record;
+    record[QStringLiteral("version")] = summaryRecordVersion;
+    record[QStringLiteral("model")] = model;
+    record[QStringLiteral("prompt")] = promptVersion;
+    record[QStringLiteral("generated")] =
+        QCborValue(textInfo.exists() ? textInfo.lastModified().toUTC() : QDateTime::currentDateTimeUtc());
+    record[QStringLiteral("sections")] = sections;
+
+    QFile file(folderPath + "/summary.cbor");
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qInfo() << "Failed to save summary record!";
+        return false;
+    }
+    file.write(record.toCborValue().toCbor());
+    file.close();
+    return true;
+}
+
+/**
+ * @name loadSummaryRecord
+ * @brief Loads the parsed summary of a patient
+ * @details The record is only used while it is at least as recent as
+ * `summary.txt`, so a summary saved without one is never shadowed by an
+ * older record. Sections missing from the record are reported as not
+ * found, as they are when parsing the text.
+ * @param patientID The ID of the patient
+ * @param summary Receives the sections; unchanged if there is no usable record
+ * @return True if the summary was loaded from the record
+ * @author Callum Thompson
+ */
+bool FileHandler::loadSummaryRecord(int patientID, Summary &summary)
+{
+    QString folderPath = patientDatabasePath + "/" + QString::number(patientID);
+    QFileInfo recordInfo(folderPath + "/summary.cbor");
+    QFileInfo textInfo(folderPath + "/summary.txt");
+    if (!recordInfo.exists() || !textInfo.exists() || recordInfo.lastModified() < textInfo.lastModified())
+    {
+        return false;
+    }
+
+    QFile file(recordInfo.filePath());
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QCborParserError error;
+    QCborMap record = QCborValue::fromCbor(file.readAll(), &error).toMap();
+    file.close();
+
+    qint64 version = record.value(QStringLiteral("version")).toInteger();
+    if (error.error != QCborError::NoError || version < 1 || version > summaryRecordVersion)
+    {
+        qWarning() << "Ignoring summary record of patient" << patientID << "with version" << version;
+        return false;
+    }
+
+    QCborMap sections = record.value(QStringLiteral("sections")).toMap();
+    auto sectionText = [&sections](NoteSections::Section section) -> QString
+    {
+        QCborValue text = sections.value(NoteSections::title(section).toString());
+        return text.isString() ? text.toString() : NoteSections::notFoundText(section);
+    };
+
+    summary.clear();
+    summary.setIntervalHistory(sectionText(NoteSections::IntervalHistory));
+    summary.setPhysicalExamination(sectionText(NoteSections::PhysicalExamination));
+    summary.setCurrentStatus(sectionText(NoteSections::CurrentStatus));
+    summary.setPlan(sectionText(NoteSections::Plan));
+    return true;
+}
+
+/**
+ * @name newVisitAudioPath
+ * @brief Returns a new path for the recording of a visit
+ * @details Each visit is recorded to its own file in the patient's `visits`
+ * folder, named after the time the visit started, so recordings of
+ * different visits never overwrite each other.
+ * @param patientID The ID of the patient
+ * @return Absolute path of a WAV file that does not exist yet
+ * @author Callum Thompson
+ */
+QString FileHandler::newVisitAudioPath(int patientID)
+{
+    QDir visitsDir(patientDatabasePath + "/" + QString::number(patientID) + "/visits");
+    visitsDir.mkpath("."); // Ensure visits folder exists
+
+    QString baseName = "visit_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    QString filePath = visitsDir.absoluteFilePath(baseName + ".wav");
+    for (int suffix = 2; QFile::exists(filePath); ++suffix)
+    {
+        filePath = visitsDir.absoluteFilePath(baseName + "_" + QString::number(suffix) + ".wav");
+    }
+    return filePath;
+}
+
 /**
  * @name loadTranscript
  * @brief Loads the most recent transcript for a patient
@@ -65,6 +65,12 @@ public:
     QString getJsonFilename() const;
     QString readTranscript(); // Read raw transcript file
     QString loadSummaryText(int patientID);
+    bool saveSummaryText(int patientID, const QString &summaryText);
+    bool saveSummaryMark(int patientID, const QString &summarizedTranscript);
+    qsizetype loadSummaryMark(int patientID, const QString &transcript);
+    bool saveSummaryRecord(int patientID, const Summary &summary, const QString &model, const QString &promptVersion);
+    bool loadSummaryRecord(int patientID, Summary &summary);
+    QString newVisitAudioPath(int patientID);
     QString loadTranscript(int patientID);
 };
 
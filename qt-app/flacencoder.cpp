@@ -0,0 +1,661 @@
+/**
+ * @file flacencoder.cpp
+ * @brief Definition of FlacEncoder class
+ *
+ * Encodes 16-bit PCM as a FLAC stream (https://xiph.org/flac/format.html)
+ * so recordings can be uploaded at roughly half their WAV size.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 7, 2025
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <QFile>
+#include <QDebug>
+#include "flacencoder.h"
+#include "audiometadata.h"
+
+namespace
+{
+const int blockSize = 4096;          // Samples per channel in each frame
+const int maxFixedOrder = 4;         // Highest fixed predictor order defined by FLAC
+const int maxPartitionOrder = 8;     // Highest Rice partition order tried
+const int maxRiceParameter = 14;     // Highest parameter of the 4-bit Rice method
+
+/**
+ * @class BitWriter
+ * @brief Appends big-endian bit fields to a byte array
+ * @author Callum Thompson
+ */
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray &out) : out(out) {}
+
+    void write(quint32 value, int bits)
+    {
+        if (bits == 0)
+        {
+            return;
+        }
+        accumulator = (accumulator << bits) | (value & (0xFFFFFFFFu >> (32 - bits)));
+        count += bits;
+        while (count >= 8)
+        {
+            count -= 8;
+            out.append(static_cast<char>(accumulator >> count));
+        }
+    }
+
+    void writeSigned(qint32 value, int bits)
+    {
+        write(static_cast<quint32>(value), bits);
+    }
+
+    // Writes `zeros` zero bits followed by a one bit
+    void writeUnary(quint32 zeros)
+    {
+        while (zeros >= 32)
+        {
+            write(0, 32);
+            zeros -= 32;
+        }
+        write(1, static_cast<int>(zeros) + 1);
+    }
+
+    void alignToByte()
+    {
+        if (count > 0)
+        {
+            write(0, 8 - count);
+        }
+    }
+
+private:
+    QByteArray &out;
+    quint64 accumulator = 0;
+    int count = 0;
+};
+
+/**
+ * @name crc8
+ * @brief CRC-8 of the frame header (polynomial x^8 + x^2 + x + 1)
+ */
+quint8 crc8(const uchar *data, qint64 length)
+{
+    quint8 crc = 0;
+    for (qint64 i = 0; i < length; ++i)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x80) ? static_cast<quint8>((crc << 1) ^ 0x07) : static_cast<quint8>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @name crc16
+ * @brief CRC-16 of a whole frame (polynomial x^16 + x^15 + x^2 + 1)
+ */
+quint16 crc16(const uchar *data, qint64 length)
+{
+    static quint16 table[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            quint16 crc = static_cast<quint16>(i << 8);
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 0x8000) ? static_cast<quint16>((crc << 1) ^ 0x8005) : static_cast<quint16>(crc << 1);
+            }
+            table[i] = crc;
+        }
+        tableReady = true;
+    }
+
+    quint16 crc = 0;
+    for (qint64 i = 0; i < length; ++i)
+    {
+        crc = static_cast<quint16>((crc << 8) ^ table[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+/**
+ * @name fixedResidual
+ * @brief Computes the residual of a fixed polynomial predictor
+ * @param[in] x: Samples
+ * @param[in] n: Number of samples
+ * @param[in] order: Predictor order (0 to 4)
+ * @param[out] residual: Receives n - order values
+ */
+void fixedResidual(const qint32 *x, int n, int order, qint32 *residual)
+{
+    for (int i = order; i < n; ++i)
+    {
+        qint32 r;
+        switch (order)
+        {
+        case 0: r = x[i]; break;
+        case 1: r = x[i] - x[i - 1]; break;
+        case 2: r = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+        case 3: r = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+        default: r = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+        }
+        residual[i - order] = r;
+    }
+}
+
+/**
+ * @name bestFixedOrder
+ * @brief Picks the fixed predictor with the smallest total absolute residual
+ * @details All orders are evaluated in one pass using successive differences.
+ * @param[in] x: Samples
+ * @param[in] n: Number of samples
+ * @param[out] cost: Total absolute residual of the chosen order
+ * @return Chosen predictor order
+ */
+int bestFixedOrder(const qint32 *x, int n, quint64 &cost)
+{
+    quint64 sums[maxFixedOrder + 1] = {0, 0, 0, 0, 0};
+    int highest = qMin(maxFixedOrder, n - 1);
+
+    // Sum over the same samples for every order so the totals are comparable
+    for (int i = maxFixedOrder; i < n; ++i)
+    {
+        qint64 e0 = x[i];
+        qint64 e1 = e0 - x[i - 1];
+        qint64 e2 = e1 - (x[i - 1] - x[i - 2]);
+        qint64 e3 = e2 - ((x[i - 1] - x[i - 2]) - (x[i - 2] - x[i - 3]));
+        qint64 e4 = e3 - (((x[i - 1] - x[i - 2]) - (x[i - 2] - x[i - 3])) - ((x[i - 2] - x[i - 3]) - (x[i - 3] - x[i - 4])));
+        sums[0] += std::llabs(e0);
+        sums[1] += std::llabs(e1);
+        sums[2] += std::llabs(e2);
+        sums[3] += std::llabs(e3);
+        sums[4] += std::llabs(e4);
+    }
+
+    int best = 0;
+    for (int order = 1; order <= highest; ++order)
+    {
+        if (sums[order] < sums[best])
+        {
+            best = order;
+        }
+    }
+    cost = sums[best];
+    return best;
+}
+
+/**
+ * @name foldResidual
+ * @brief Maps a signed residual to the unsigned value that is Rice coded
+ */
+inline quint32 foldResidual(qint32 r)
+{
+    return (static_cast<quint32>(r) << 1) ^ static_cast<quint32>(r >> 31);
+}
+
+/**
+ * @name riceParameter
+ * @brief Estimates the best Rice parameter from the mean folded residual
+ * @param[in] sum: Sum of folded residuals in the partition
+ * @param[in] count: Number of residuals in the partition
+ * @return Rice parameter
+ */
+int riceParameter(quint64 sum, int count)
+{
+    int k = 0;
+    while (k < maxRiceParameter && (static_cast<quint64>(count) << (k + 1)) < sum)
+    {
+        ++k;
+    }
+    return k;
+}
+
+/**
+ * @struct RicePlan
+ * @brief Chosen partitioning of a residual and its Rice parameters
+ */
+struct RicePlan
+{
+    int partitionOrder = 0;
+    QVector<int> parameters;
+    quint64 bits = ~0ull;
+};
+
+/**
+ * @name planRice
+ * @brief Chooses the partition order and parameters with the fewest bits
+ * @param[in] folded: Folded residual
+ * @param[in] blockLength: Samples in the block, including warm-up samples
+ * @param[in] order: Predictor order (number of warm-up samples)
+ * @return Plan with the smallest exact size
+ */
+RicePlan planRice(const quint32 *folded, int blockLength, int order)
+{
+    RicePlan best;
+    for (int partitionOrder = 0; partitionOrder <= maxPartitionOrder; ++partitionOrder)
+    {
+        int partitions = 1 << partitionOrder;
+        if (blockLength % partitions != 0 || (blockLength >> partitionOrder) <= order)
+        {
+            break;
+        }
+
+        RicePlan plan;
+        plan.partitionOrder = partitionOrder;
+        plan.bits = 2 + 4;
+        const quint32 *partition = folded;
+        for (int p = 0; p < partitions; ++p)
+        {
+            int count = (blockLength >> partitionOrder) - (p == 0 ? order : 0);
+            quint64 sum = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                sum += partition[i];
+            }
+            int k = riceParameter(sum, count);
+
+            // Exact size: unary quotient, stop bit and k low bits per value
+            quint64 bits = static_cast<quint64>(count) * (k + 1);
+            for (int i = 0; i < count; ++i)
+            {
+                bits += partition[i] >> k;
+            }
+            plan.parameters.append(k);
+            plan.bits += 4 + bits;
+            partition += count;
+        }
+
+        if (plan.bits < best.bits)
+        {
+            best = plan;
+        }
+    }
+    return best;
+}
+
+/**
+ * @name writeSubframe
+ * @brief Encodes one channel of a block as the smallest subframe type
+ * @param[in,out] writer: Frame being written
+ * @param[in] x: Samples of the channel
+ * @param[in] n: Number of samples
+ * @param[in] bitsPerSample: Sample width (17 for a side channel)
+ */
+void writeSubframe(BitWriter &writer, const qint32 *x, int n, int bitsPerSample)
+{
+    // CONSTANT subframe (typically digital silence)
+    bool constant = true;
+    for (int i = 1; i < n && constant; ++i)
+    {
+        constant = x[i] == x[0];
+    }
+    if (constant)
+    {
+        writer.write(0x00, 8);
+        writer.writeSigned(x[0], bitsPerSample);
+        return;
+    }
+
+    quint64 cost;
+    int order = bestFixedOrder(x, n, cost);
+
+    QVector<qint32> residual(n - order);
+    fixedResidual(x, n, order, residual.data());
+    QVector<quint32> folded(residual.size());
+    for (int i = 0; i < residual.size(); ++i)
+    {
+        folded[i] = foldResidual(residual[i]);
+    }
+    RicePlan plan = planRice(folded.constData(), n, order);
+
+    // VERBATIM subframe if prediction does not pay off (e.g. white noise)
+    quint64 fixedBits = static_cast<quint64>(order) * bitsPerSample + plan.bits;
+    if (fixedBits >= static_cast<quint64>(n) * bitsPerSample)
+    {
+        writer.write(0x02, 8);
+        for (int i = 0; i < n; ++i)
+        {
+            writer.writeSigned(x[i], bitsPerSample);
+        }
+        return;
+    }
+
+    // FIXED subframe: header, warm-up samples, then the Rice-coded residual
+    writer.write((0x08 | order) << 1, 8);
+    for (int i = 0; i < order; ++i)
+    {
+        writer.writeSigned(x[i], bitsPerSample);
+    }
+    writer.write(0, 2);
+    writer.write(plan.partitionOrder, 4);
+
+    const quint32 *value = folded.constData();
+    int partitions = 1 << plan.partitionOrder;
+    for (int p = 0; p < partitions; ++p)
+    {
+        int k = plan.parameters[p];
+        int count = (n >> plan.partitionOrder) - (p == 0 ? order : 0);
+        writer.write(k, 4);
+        for (int i = 0; i < count; ++i)
+        {
+            writer.writeUnary(value[i] >> k);
+            writer.write(value[i], k);
+        }
+        value += count;
+    }
+}
+
+/**
+ * @name sampleRateCode
+ * @brief Returns the frame header code of a sample rate
+ * @return Code of a common rate, or 0 to refer to STREAMINFO
+ */
+int sampleRateCode(int sampleRate)
+{
+    switch (sampleRate)
+    {
+    case 8000: return 4;
+    case 16000: return 5;
+    case 22050: return 6;
+    case 24000: return 7;
+    case 32000: return 8;
+    case 44100: return 9;
+    case 48000: return 10;
+    case 96000: return 11;
+    default: return 0;
+    }
+}
+
+/**
+ * @name writeFrameNumber
+ * @brief Writes a frame number in FLAC's UTF-8-like variable-length coding
+ */
+void writeFrameNumber(BitWriter &writer, quint64 number)
+{
+    if (number < 0x80)
+    {
+        writer.write(static_cast<quint32>(number), 8);
+        return;
+    }
+
+    int continuationBytes = 1;
+    while (continuationBytes < 6 && number >= (1ull << (5 * continuationBytes + 6)))
+    {
+        ++continuationBytes;
+    }
+    quint32 lead = (0xFF00u >> (continuationBytes + 1)) & 0xFF;
+    writer.write(lead | static_cast<quint32>(number >> (6 * continuationBytes)), 8);
+    for (int i = continuationBytes - 1; i >= 0; --i)
+    {
+        writer.write(0x80 | ((number >> (6 * i)) & 0x3F), 8);
+    }
+}
+}
+
+/**
+ * @name FlacEncoder (constructor)
+ * @brief Creates an encoder for a stream of 16-bit PCM
+ * @param[in] sampleRate: Sample rate in Hz
+ * @param[in] channels: Number of channels (1 to 8)
+ * @author Callum Thompson
+ */
+FlacEncoder::FlacEncoder(int sampleRate, int channels)
+    : sampleRate(sampleRate), channels(qBound(1, channels, 8)), md5(QCryptographicHash::Md5)
+{
+}
+
+/**
+ * @name encode
+ * @brief Encodes interleaved samples
+ * @details Complete blocks are encoded immediately; the remainder is kept
+ * until more samples arrive or finish() is called.
+ * @param[in] samples: Interleaved 16-bit samples
+ * @param[in] frames: Number of sample frames
+ * @param[out] output: Receives the encoded FLAC frames
+ * @author Callum Thompson
+ */
+void FlacEncoder::encode(const qint16 *samples, qint64 frames, QByteArray &output)
+{
+    if (frames <= 0)
+    {
+        return;
+    }
+    md5.addData(QByteArrayView(reinterpret_cast<const char *>(samples), frames * channels * qint64(sizeof(qint16))));
+
+    // Complete a block started by a previous call
+    if (!pending.isEmpty())
+    {
+        qint64 needed = qMin<qint64>(blockSize - pending.size() / channels, frames);
+        appendPending(samples, needed * channels);
+        samples += needed * channels;
+        frames -= needed;
+        if (pending.size() / channels < blockSize)
+        {
+            return;
+        }
+        encodeBlock(pending.constData(), blockSize, output);
+        pending.clear();
+    }
+
+    // Encode whole blocks straight from the input
+    while (frames >= blockSize)
+    {
+        encodeBlock(samples, blockSize, output);
+        samples += blockSize * channels;
+        frames -= blockSize;
+    }
+    appendPending(samples, frames * channels);
+}
+
+/**
+ * @name finish
+ * @brief Encodes the final, possibly short, block
+ * @param[out] output: Receives the encoded FLAC frame
+ * @author Callum Thompson
+ */
+void FlacEncoder::finish(QByteArray &output)
+{
+    if (!pending.isEmpty())
+    {
+        encodeBlock(pending.constData(), pending.size() / channels, output);
+        pending.clear();
+    }
+}
+
+/**
+ * @name streamHeader
+ * @brief Returns the "fLaC" marker and STREAMINFO block
+ * @details The header has a fixed size of 42 bytes. Before finish() the
+ * totals describe only the audio encoded so far, so a file written while
+ * encoding should have its header rewritten at the end.
+ * @return Stream header bytes
+ * @author Callum Thompson
+ */
+QByteArray FlacEncoder::streamHeader() const
+{
+    QByteArray header("fLaC");
+    BitWriter writer(header);
+
+    writer.write(0x80, 8);            // Last metadata block, type STREAMINFO
+    writer.write(34, 24);             // Block length
+    writer.write(blockSize, 16);      // Minimum block size
+    writer.write(blockSize, 16);      // Maximum block size
+    writer.write(minFrameBytes, 24);
+    writer.write(maxFrameBytes, 24);
+    writer.write(sampleRate, 20);
+    writer.write(channels - 1, 3);
+    writer.write(16 - 1, 5);
+    writer.write(static_cast<quint32>(totalSamples >> 32), 4);
+    writer.write(static_cast<quint32>(totalSamples), 32);
+    header.append(md5.result());
+    return header;
+}
+
+/**
+ * @name encodeWavFile
+ * @brief Encodes a 16-bit PCM WAV file as a complete FLAC stream
+ * @details The file is memory-mapped and encoded without further copies.
+ * Safe to call from a worker thread.
+ * @param[in] wavPath: Path to the WAV file
+ * @return FLAC stream, or an empty array if the file is not 16-bit PCM
+ * @author Callum Thompson
+ */
+QByteArray FlacEncoder::encodeWavFile(const QString &wavPath)
+{
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(wavPath);
+    if (!metadata.isPcm16() || metadata.channels > 8)
+    {
+        return QByteArray();
+    }
+
+    QFile file(wavPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Could not open audio file for encoding:" << wavPath;
+        return QByteArray();
+    }
+    const uchar *data = metadata.dataSize > 0 ? file.map(metadata.dataOffset, metadata.frameCount * metadata.blockAlign) : nullptr;
+    if (!data)
+    {
+        qWarning() << "Could not map audio file for encoding:" << wavPath;
+        return QByteArray();
+    }
+
+    FlacEncoder encoder(metadata.sampleRate, metadata.channels);
+    QByteArray frames;
+    frames.reserve(metadata.dataSize / 2); // Speech usually compresses to about half
+    encoder.encode(reinterpret_cast<const qint16 *>(data), metadata.frameCount, frames);
+    encoder.finish(frames);
+    file.unmap(const_cast<uchar *>(data));
+
+    return encoder.streamHeader() + frames;
+}
+
+/**
+ * @name appendPending
+ * @brief Buffers samples until a full block is available
+ * @param[in] samples: Interleaved samples
+ * @param[in] count: Number of samples (not frames)
+ * @author Callum Thompson
+ */
+void FlacEncoder::appendPending(const qint16 *samples, qint64 count)
+{
+    qsizetype start = pending.size();
+    pending.resize(start + count);
+    std::copy(samples, samples + count, pending.begin() + start);
+}
+
+/**
+ * @name encodeBlock
+ * @brief Encodes one FLAC frame
+ * @details For stereo input, all four channel decorrelation modes are
+ * estimated and the cheapest is coded.
+ * @param[in] samples: Interleaved samples of the block
+ * @param[in] length: Samples per channel in the block
+ * @param[out] output: Receives the frame
+ * @author Callum Thompson
+ */
+void FlacEncoder::encodeBlock(const qint16 *samples, int length, QByteArray &output)
+{
+    // Deinterleave, adding mid and side channels for stereo
+    int sourceCount = channels == 2 ? 4 : channels;
+    QVector<QVector<qint32>> source(sourceCount, QVector<qint32>(length));
+    for (int i = 0; i < length; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            source[c][i] = samples[i * channels + c];
+        }
+    }
+
+    int channelCode = channels - 1;
+    int coded[8];
+    int codedBits[8];
+    for (int c = 0; c < channels; ++c)
+    {
+        coded[c] = c;
+        codedBits[c] = 16;
+    }
+
+    if (channels == 2)
+    {
+        for (int i = 0; i < length; ++i)
+        {
+            source[2][i] = (source[0][i] + source[1][i]) >> 1; // Mid
+            source[3][i] = source[0][i] - source[1][i];        // Side
+        }
+
+        quint64 cost[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            bestFixedOrder(source[c].constData(), length, cost[c]);
+        }
+
+        // Channel assignment codes: 1 = left/right, 8 = left/side, 9 = side/right, 10 = mid/side
+        quint64 best = cost[0] + cost[1];
+        if (cost[0] + cost[3] < best)
+        {
+            best = cost[0] + cost[3];
+            channelCode = 8;
+        }
+        if (cost[3] + cost[1] < best)
+        {
+            best = cost[3] + cost[1];
+            channelCode = 9;
+        }
+        if (cost[2] + cost[3] < best)
+        {
+            channelCode = 10;
+        }
+
+        switch (channelCode)
+        {
+        case 8: coded[1] = 3; codedBits[1] = 17; break;
+        case 9: coded[0] = 3; codedBits[0] = 17; break;
+        case 10: coded[0] = 2; coded[1] = 3; codedBits[1] = 17; break;
+        default: break;
+        }
+    }
+
+    QByteArray frame;
+    BitWriter writer(frame);
+
+    // Frame header
+    int blockSizeCode = length == blockSize ? 12 : 7;
+    writer.write(0xFFF8, 16);                    // Sync code, fixed block size
+    writer.write(blockSizeCode, 4);
+    writer.write(sampleRateCode(sampleRate), 4);
+    writer.write(channelCode, 4);
+    writer.write(4, 3);                          // 16 bits per sample
+    writer.write(0, 1);
+    writeFrameNumber(writer, frameNumber);
+    if (blockSizeCode == 7)
+    {
+        writer.write(length - 1, 16);
+    }
+    writer.write(crc8(reinterpret_cast<const uchar *>(frame.constData()), frame.size()), 8);
+
+    for (int c = 0; c < channels; ++c)
+    {
+        writeSubframe(writer, source[coded[c]].constData(), length, codedBits[c]);
+    }
+    writer.alignToByte();
+
+    quint16 crc = crc16(reinterpret_cast<const uchar *>(frame.constData()), frame.size());
+    writer.write(crc, 16);
+
+    quint32 frameBytes = static_cast<quint32>(frame.size());
+    minFrameBytes = frameNumber == 0 ? frameBytes : qMin(minFrameBytes, frameBytes);
+    maxFrameBytes = qMax(maxFrameBytes, frameBytes);
+    ++frameNumber;
+    totalSamples += length;
+    output.append(frame);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file flacencoder.h
+ * @brief Declaration of FlacEncoder class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 7, 2025
+ */
+
+#ifndef FLACENCODER_H
+#define FLACENCODER_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class FlacEncoder
+ * @brief Lossless FLAC encoder for 16-bit PCM audio
+ * @details Each block of samples is coded with the best of FLAC's fixed
+ * polynomial predictors (orders 0 to 4) and partitioned Rice coding of the
+ * residual. Stereo blocks additionally pick the cheapest of left/right,
+ * left/side, side/right and mid/side coding. Speech typically compresses
+ * to around half its PCM size. Samples can be supplied incrementally; the
+ * STREAMINFO header is complete once finish() has been called.
+ * @author Callum Thompson
+ */
+class FlacEncoder
+{
+public:
+    FlacEncoder(int sampleRate, int channels);
+
+    void encode(const qint16 *samples, qint64 frames, QByteArray &output);
+    void finish(QByteArray &output);
+    QByteArray streamHeader() const;
+
+    static QByteArray encodeWavFile(const QString &wavPath);
+
+private:
+    int sampleRate;
+    int channels;
+    QVector<qint16> pending;          // Interleaved samples short of a full block
+    quint64 frameNumber = 0;          // Index of the next FLAC frame
+    quint64 totalSamples = 0;         // Samples per channel encoded so far
+    quint32 minFrameBytes = 0;        // Smallest encoded frame
+    quint32 maxFrameBytes = 0;        // Largest encoded frame
+    QCryptographicHash md5;           // Signature of the unencoded audio
+
+    void appendPending(const qint16 *samples, qint64 count);
+    void encodeBlock(const qint16 *samples, int length, QByteArray &output);
+};
+
+#endif // FLACENCODER_H
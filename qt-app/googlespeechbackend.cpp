@@ -0,0 +1,212 @@
+/**
+ * @file googlespeechbackend.cpp
+ * @brief Definition of GoogleSpeechBackend class
+ *
+ * @author Andres Pedreros Castro (apedrero@uwo.ca)
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QUrl>
+#include <QDebug>
+#include "googlespeechbackend.h"
+#include "audiometadata.h"
+#include "streamingbodydevice.h"
+
+namespace
+{
+const double baseLatencySecs = 1.0;     // Request setup and recognition start
+const double latencyPerAudioSec = 0.04; // Processing time per second of audio
+}
+
+/**
+ * @name GoogleSpeechBackend (constructor)
+ * @brief Initializes the backend without an API key
+ * @details Registers the Speech-to-Text host so connections to it are opened ahead
+ * of the first upload.
+ * @param[in] networkManager: Network manager requests are sent with
+ * @author Callum Thompson
+ */
+GoogleSpeechBackend::GoogleSpeechBackend(NetworkManager *networkManager)
+    : networkManager(networkManager)
+{
+    networkManager->addHost(QUrl("https://speech.googleapis.com"));
+}
+
+/**
+ * @name setApiKey
+ * @brief Sets the Google Speech-to-Text API key
+ * @param[in] key: API key
+ * @author Callum Thompson
+ */
+void GoogleSpeechBackend::setApiKey(const QString &key)
+{
+    apiKey = key;
+}
+
+/**
+ * @name name
+ * @brief Returns the name of the backend
+ * @return "Google Speech-to-Text"
+ * @author Callum Thompson
+ */
+QString GoogleSpeechBackend::name() const
+{
+    return "Google Speech-to-Text";
+}
+
+/**
+ * @name configuration
+ * @brief Returns the API version and language requests use
+ * @return Configuration of the backend
+ * @author Callum Thompson
+ */
+QString GoogleSpeechBackend::configuration() const
+{
+    return "v1;en-CA";
+}
+
+/**
+ * @name capabilities
+ * @brief Returns the limits of synchronous recognition
+ * @details The request body is limited to 10 MB, and the audio is base64
+ * encoded inside it.
+ * @return Capabilities of the backend
+ * @author Callum Thompson
+ */
+BackendCapabilities GoogleSpeechBackend::capabilities() const
+{
+    BackendCapabilities caps;
+    caps.requiresNetwork = true;
+    caps.acceptsFlac = true;
+    caps.requiresPcm16 = true;
+    caps.providesTimestamps = true;
+    caps.maxDurationSecs = 60.0;
+    caps.maxUploadBytes = 7 * 1024 * 1024;
+    return caps;
+}
+
+/**
+ * @name isAvailable
+ * @brief Returns whether requests can be sent
+ * @return True if an API key has been set
+ * @author Callum Thompson
+ */
+bool GoogleSpeechBackend::isAvailable() const
+{
+    return !apiKey.isEmpty();
+}
+
+/**
+ * @name expectedLatencySecs
+ * @brief Estimates the time to transcribe audio of a given length
+ * @param[in] audioSecs: Length of the audio sent
+ * @return Expected seconds from sending to receiving the transcript
+ * @author Callum Thompson
+ */
+double GoogleSpeechBackend::expectedLatencySecs(double audioSecs) const
+{
+    return baseLatencySecs + latencyPerAudioSec * audioSecs;
+}
+
+/**
+ * @name start
+ * @brief Sends the audio file to Google Speech-to-Text API for transcription
+ * @details This function prepares the audio file and sends it to the Google Speech-to-Text API for transcription.
+ * It sets the necessary headers and returns without waiting for the response.
+ * The FLAC encoding is sent if available, otherwise the WAV file is sent as LINEAR16.
+ * @param[in] audioPath: Path to the audio file
+ * @param[in] flac: FLAC encoding of the audio file, or empty to send the WAV file
+ * @return Request in flight, or nullptr if the request could not be sent
+ * @author Andres Pedreros Castro
+ * @author Callum Thompson
+ */
+TranscriptionRequest *GoogleSpeechBackend::start(const QString &audioPath, const QByteArray &flac)
+{
+    // Construct the Google Speech-to-Text API URL with your API key
+    QUrl url("https://speech.googleapis.com/v1/speech:recognize?key=" + apiKey);
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    // Configure audio settings for Google's STT API from the file's own format
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+    QJsonObject config;
+    config["encoding"] = flac.isEmpty() ? "LINEAR16" : "FLAC"; // Raw WAV samples or lossless FLAC
+    config["sampleRateHertz"] = metadata.sampleRate;    // Sample rate the file was recorded at
+    config["languageCode"] = "en-CA";                   // Canadian English
+    config["audioChannelCount"] = metadata.channels;    // Mono or stereo audio
+
+    // Build the JSON body {"config":{...},"audio":{"content":"<base64>"}}. The audio
+    // is base64-encoded block by block while uploading instead of up front.
+    StreamingBodyDevice *payload = new StreamingBodyDevice;
+    payload->appendRaw("{\"config\":" + QJsonDocument(config).toJson(QJsonDocument::Compact) + ",\"audio\":{\"content\":\"");
+    if (!flac.isEmpty())
+    {
+        payload->appendBase64Data(flac);
+    }
+    else if (!payload->appendBase64File(audioPath))
+    {
+        qWarning() << "Could not open audio file: " << audioPath;
+        delete payload;
+        return nullptr;
+    }
+    payload->appendRaw("\"}}");
+    payload->open(QIODevice::ReadOnly);
+    request.setHeader(QNetworkRequest::ContentLengthHeader, payload->size());
+
+    // Send the POST request; the body is encoded as it is uploaded
+    QNetworkReply *reply = networkManager->post(request, payload);
+    payload->setParent(reply); // Cleanup when reply is finished
+    return new NetworkTranscriptionRequest(reply, &GoogleSpeechBackend::parseResponse);
+}
+
+/**
+ * @name parseResponse
+ * @brief Extracts the transcript from a Google Speech response
+ * @details Google Speech returns a nested array of results and alternatives.
+ * Each result ends at its "resultEndTime", so the next result starts there.
+ * @param[in] response: Raw JSON response
+ * @param[out] text: Receives the text of the whole audio
+ * @param[out] segments: Receives one segment per result
+ * @return True if the response is valid
+ * @author Andres Pedreros Castro
+ * @author Callum Thompson
+ */
+bool GoogleSpeechBackend::parseResponse(const QByteArray &response, QString &text, QList<TranscriptSegment> &segments)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(response);
+    if (!doc.isObject())
+    {
+        return false;
+    }
+
+    double startSecs = 0.0;
+    QJsonArray results = doc.object().value("results").toArray();
+    for (const QJsonValue &val : results)
+    {
+        QJsonObject result = val.toObject();
+        QJsonArray alternatives = result.value("alternatives").toArray();
+        if (!alternatives.isEmpty())
+        {
+            QString transcript = alternatives[0].toObject().value("transcript").toString();
+            text += transcript;
+            if (!transcript.trimmed().isEmpty())
+            {
+                segments.append({startSecs, transcript.trimmed()});
+            }
+        }
+
+        // Durations are strings such as "3.500s"
+        QString endTime = result.value("resultEndTime").toString();
+        if (endTime.endsWith('s'))
+        {
+            endTime.chop(1);
+            startSecs = endTime.toDouble();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file googlespeechbackend.h
+ * @brief Declaration of GoogleSpeechBackend class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#ifndef GOOGLESPEECHBACKEND_H
+#define GOOGLESPEECHBACKEND_H
+
+#include "networkmanager.h"
+#include "transcriptionbackend.h"
+
+/**
+ * @class GoogleSpeechBackend
+ * @brief Transcribes with the synchronous Google Speech-to-Text API
+ * @details Synchronous requests are limited to 60 seconds of audio and
+ * must be LINEAR16 or FLAC, but answer quickly, so this backend suits
+ * short recordings.
+ * @author Callum Thompson
+ */
+class GoogleSpeechBackend : public TranscriptionBackend
+{
+public:
+    explicit GoogleSpeechBackend(NetworkManager *networkManager);
+
+    void setApiKey(const QString &key);
+
+    QString name() const override;
+    QString configuration() const override;
+    BackendCapabilities capabilities() const override;
+    bool isAvailable() const override;
+    double expectedLatencySecs(double audioSecs) const override;
+    TranscriptionRequest *start(const QString &audioPath, const QByteArray &flac) override;
+
+private:
+    NetworkManager *networkManager;
+    QString apiKey;
+
+    static bool parseResponse(const QByteArray &response, QString &text, QList<TranscriptSegment> &segments);
+};
+
+#endif // GOOGLESPEECHBACKEND_H
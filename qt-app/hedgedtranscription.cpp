@@ -0,0 +1,156 @@
+/**
+ * @file hedgedtranscription.cpp
+ * @brief Definition of HedgedTranscription class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 12, 2025
+ */
+
+#include <QDebug>
+#include "hedgedtranscription.h"
+
+/**
+ * @name HedgedTranscription (constructor)
+ * @brief Prepares a hedged transcription
+ * @param[in] primary: Backend tried first
+ * @param[in] secondary: Backend raced against a slow primary
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] flac: FLAC encoding of the file, or empty to send the WAV file
+ * @param[in] hedgeDelayMs: Time to wait for the primary before starting the secondary
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+HedgedTranscription::HedgedTranscription(TranscriptionBackend *primary, TranscriptionBackend *secondary, const QString &audioPath,
+                                         const QByteArray &flac, int hedgeDelayMs, QObject *parent)
+    : QObject(parent), primary(primary), secondary(secondary), audioPath(audioPath), flac(flac)
+{
+    hedgeTimer.setSingleShot(true);
+    hedgeTimer.setInterval(qMax(0, hedgeDelayMs));
+    connect(&hedgeTimer, &QTimer::timeout, this, [this]()
+    {
+        qInfo() << this->primary->name() << "has not answered, also trying" << this->secondary->name();
+        startSecondary();
+    });
+}
+
+/**
+ * @name start
+ * @brief Sends the audio to the primary backend and starts the hedge timer
+ * @details If the primary cannot be sent the audio, the secondary is
+ * started straight away.
+ * @author Callum Thompson
+ */
+void HedgedTranscription::start()
+{
+    clock.start();
+    if (!launch(primary))
+    {
+        startSecondary();
+        return;
+    }
+    hedgeTimer.start();
+}
+
+/**
+ * @name launch
+ * @brief Sends the audio to a backend
+ * @param[in] backend: Backend to send to
+ * @return True if the request was sent
+ * @author Callum Thompson
+ */
+bool HedgedTranscription::launch(TranscriptionBackend *backend)
+{
+    TranscriptionRequest *request = backend->start(audioPath, flac);
+    if (!request)
+    {
+        return false;
+    }
+
+    request->setParent(this);
+    active.append(request);
+    emit requestStarted(request);
+    qint64 startedMs = clock.elapsed();
+    launched.insert(request, {backend, startedMs});
+    connect(request, &TranscriptionRequest::finished, this, [this, backend, request, startedMs]()
+            { handleResult(backend, request, startedMs); });
+    return true;
+}
+
+/**
+ * @name startSecondary
+ * @brief Sends the audio to the secondary backend, once
+ * @details Fails the transcription if nothing is left in flight.
+ * @author Callum Thompson
+ */
+void HedgedTranscription::startSecondary()
+{
+    hedgeTimer.stop();
+    if (ended || secondaryStarted)
+    {
+        return;
+    }
+
+    secondaryStarted = true;
+    if (!launch(secondary) && active.isEmpty())
+    {
+        ended = true;
+        emit failed("Transcription failed", nullptr);
+    }
+}
+
+/**
+ * @name handleResult
+ * @brief Takes the first successful transcript and aborts the other request
+ * @details The latency of the winner is reported, and the time the other
+ * request had run as a lower bound of its latency.
+ * @param[in] backend: Backend that answered
+ * @param[in] request: Finished request
+ * @param[in] startedMs: Time the request was sent, from the start of the transcription
+ * @author Callum Thompson
+ */
+void HedgedTranscription::handleResult(TranscriptionBackend *backend, TranscriptionRequest *request, qint64 startedMs)
+{
+    request->deleteLater();
+    active.removeAll(request);
+    launched.remove(request);
+    if (ended)
+    {
+        return; // The other backend already answered
+    }
+
+    if (request->isSuccessful())
+    {
+        ended = true;
+        hedgeTimer.stop();
+        emit latencyMeasured(backend, (clock.elapsed() - startedMs) / 1000.0, false);
+
+        // The losers would have taken at least as long as they had run
+        const QList<QPointer<TranscriptionRequest>> losers = active;
+        for (const QPointer<TranscriptionRequest> &loser : losers)
+        {
+            if (loser)
+            {
+                const QPair<TranscriptionBackend *, qint64> attempt = launched.value(loser);
+                emit latencyMeasured(attempt.first, (clock.elapsed() - attempt.second) / 1000.0, true);
+                loser->abort();
+            }
+        }
+        emit finished(request->text(), backend);
+        return;
+    }
+
+    qWarning() << backend->name() << "request failed:" << request->errorString();
+    if (!secondaryStarted)
+    {
+        startSecondary(); // No point waiting for the hedge delay
+        if (ended)
+        {
+            return;
+        }
+    }
+    if (active.isEmpty())
+    {
+        ended = true;
+        emit failed(request->errorString(), request->networkReply());
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * @file hedgedtranscription.h
+ * @brief Declaration of HedgedTranscription class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 12, 2025
+ */
+
+#ifndef HEDGEDTRANSCRIPTION_H
+#define HEDGEDTRANSCRIPTION_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QPointer>
+#include <QTimer>
+#include "transcriptionbackend.h"
+
+/**
+ * @class HedgedTranscription
+ * @brief Races a second backend against a primary backend that is slow
+ * to answer
+ * @details The audio is sent to the primary backend first. If no answer
+ * has arrived when the hedge delay expires, or the primary fails, the
+ * same audio is also sent to the secondary backend. The first successful
+ * transcript wins and the other request is aborted, so most recordings
+ * are only transcribed once while a stalled service no longer holds up
+ * the visit. The time an aborted request had run is reported as a lower
+ * bound of its latency, so the slow answers that were hedged still count
+ * towards the backend's tail latency.
+ * @author Callum Thompson
+ */
+class HedgedTranscription : public QObject
+{
+    Q_OBJECT
+
+public:
+    HedgedTranscription(TranscriptionBackend *primary, TranscriptionBackend *secondary, const QString &audioPath,
+                        const QByteArray &flac, int hedgeDelayMs, QObject *parent);
+
+    void start();
+
+signals:
+    void requestStarted(TranscriptionRequest *request);                // A backend has been sent the audio
+    void latencyMeasured(TranscriptionBackend *backend, double secs, bool lowerBound); // A backend answered, or was aborted after secs
+    void finished(const QString &text, TranscriptionBackend *winner);  // The first transcript arrived
+    void failed(const QString &errorMessage, QNetworkReply *reply);    // Both backends failed
+
+private:
+    TranscriptionBackend *primary;
+    TranscriptionBackend *secondary;
+    QString audioPath;
+    QByteArray flac;
+    QTimer hedgeTimer;                              // Fires when the secondary should be started
+    QElapsedTimer clock;                            // Started with the primary request
+    QList<QPointer<TranscriptionRequest>> active;   // Requests in flight
+    QHash<const TranscriptionRequest *, QPair<TranscriptionBackend *, qint64>> launched; // Backend and send time of each request
+    bool secondaryStarted = false;
+    bool ended = false;
+
+    bool launch(TranscriptionBackend *backend);
+    void startSecondary();
+    void handleResult(TranscriptionBackend *backend, TranscriptionRequest *request, qint64 startedMs);
+};
+
+#endif // HEDGEDTRANSCRIPTION_H
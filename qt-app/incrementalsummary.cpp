@@ -0,0 +1,160 @@
+/**
+ * @file incrementalsummary.cpp
+ * @brief Definition of IncrementalSummary class
+ *
+ * Amends a summary with the transcript appended since it was generated.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 25, 2025
+ */
+
+#include <QDebug>
+#include <algorithm>
+#include "incrementalsummary.h"
+#include "sectionindex.h"
+#include "llmclient.h"
+
+/**
+ * @name IncrementalSummary (constructor)
+ * @brief Prepares the amendment of a summary
+ * @param[in] previousSummary: Saved summary of the start of the transcript
+ * @param[in] transcript: Whole transcript
+ * @param[in] summarizedChars: Length of the start of the transcript the
+ * saved summary covers
+ * @param[in] structured: True if responses are returned as JSON
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+IncrementalSummary::IncrementalSummary(const QString &previousSummary, const QString &transcript,
+                                       qsizetype summarizedChars, bool structured, QObject *parent)
+    : QObject(parent), previousSummary(previousSummary), transcript(transcript), summarizedChars(summarizedChars),
+      structured(structured)
+{
+    // No logic body
+}
+
+/**
+ * @name start
+ * @brief Sends the earlier note and the new part of the transcript
+ * @details A JSON note cannot be amended section by section in markdown,
+ * so it is summarized again in full.
+ * @author Callum Thompson
+ */
+void IncrementalSummary::start()
+{
+    if (!structured && previousSummary.trimmed().startsWith('{'))
+    {
+        summarizeAll();
+        return;
+    }
+
+    QString addendum = transcript.mid(summarizedChars).trimmed();
+    QString reply = structured
+                        ? QString("Return the whole amended note.")
+                        : QString("Return only the sections whose content changes, each in full and starting "
+                                  "with its title in bold, in the usual order. Leave out the sections that "
+                                  "stay the same.");
+    QString prompt = "Below are the note written from the earlier part of today's visit transcript and the "
+                     "part of the transcript recorded since. Amend the note with the new part: add its "
+                     "information to the relevant sections and update the details that have changed. "
+                     + reply + "\n\nNote so far:\n\n" + previousSummary
+                     + "\n\nTranscript recorded since the note was written:\n\n" + addendum;
+    qInfo() << "Amending the summary with" << addendum.size() << "new characters of a"
+            << transcript.size() << "character transcript";
+
+    LLMRequest *request = LLMClient::getInstance()->sendRequest(prompt);
+    connect(request, &LLMRequest::partialResponse, this, [this](const QString &textSoFar)
+            { emit partialResponse(structured ? textSoFar : merge(textSoFar, true)); });
+    connect(request, &LLMRequest::finished, this, &IncrementalSummary::handleAmendment);
+    connect(request, &LLMRequest::failed, this, &IncrementalSummary::failed);
+}
+
+/**
+ * @name splitSections
+ * @brief Splits a markdown note at the bold titles of its sections
+ * @param[in] summaryText: Note, or the part of it received so far
+ * @param[in] completeOnly: True to leave out the last section found, which
+ * may still be being written
+ * @return Text of each of NoteSections, or a null string for sections the
+ * note does not have
+ * @author Callum Thompson
+ */
+QStringList IncrementalSummary::splitSections(const QString &summaryText, bool completeOnly)
+{
+    const SectionIndex index(summaryText);
+    QStringList sections(NoteSections::Count);
+    for (int section = 0; section < NoteSections::Count; ++section)
+    {
+        NoteSections::Section found = NoteSections::Section(section);
+        if (completeOnly ? index.isComplete(found) : index.contains(found))
+        {
+            sections[section] = index.section(found).trimmed().toString();
+        }
+    }
+    return sections;
+}
+
+/**
+ * @name handleAmendment
+ * @brief Merges the amended sections into the earlier note
+ * @param[in] amendment: Response of the LLM
+ * @author Callum Thompson
+ */
+void IncrementalSummary::handleAmendment(const QString &amendment)
+{
+    if (structured)
+    {
+        emit finished(amendment);
+        return;
+    }
+
+    const QStringList sections = splitSections(amendment);
+    bool amended = std::any_of(sections.begin(), sections.end(), [](const QString &section)
+                               { return !section.isNull(); });
+    if (!amended)
+    {
+        qWarning() << "The amendment has no sections, summarizing the whole transcript";
+        summarizeAll();
+        return;
+    }
+    emit finished(merge(amendment, false));
+}
+
+/**
+ * @name summarizeAll
+ * @brief Summarizes the whole transcript instead of amending the note
+ * @author Callum Thompson
+ */
+void IncrementalSummary::summarizeAll()
+{
+    LLMRequest *request = LLMClient::getInstance()->summarize(transcript);
+    connect(request, &LLMRequest::partialResponse, this, &IncrementalSummary::partialResponse);
+    connect(request, &LLMRequest::finished, this, &IncrementalSummary::finished);
+    connect(request, &LLMRequest::failed, this, &IncrementalSummary::failed);
+}
+
+/**
+ * @name merge
+ * @brief Replaces the sections of the earlier note that were amended
+ * @param[in] amendment: Response of the LLM, possibly incomplete
+ * @param[in] completeOnly: True to ignore an amended section that may still
+ * be being written
+ * @return Note with a bold title ahead of each section
+ * @author Callum Thompson
+ */
+QString IncrementalSummary::merge(const QString &amendment, bool completeOnly) const
+{
+    const QStringList previous = splitSections(previousSummary);
+    const QStringList amended = splitSections(amendment, completeOnly);
+
+    QString text;
+    for (int index = 0; index < NoteSections::Count; ++index)
+    {
+        const QString &section = amended[index].isNull() ? previous[index] : amended[index];
+        if (!section.isNull())
+        {
+            text += "**" + NoteSections::title(NoteSections::Section(index)).toString() + "**\n\n" + section + "\n\n";
+        }
+    }
+    return text.trimmed();
+}
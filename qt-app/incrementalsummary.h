@@ -0,0 +1,55 @@
+/**
+ * @file incrementalsummary.h
+ * @brief Declaration of IncrementalSummary class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 25, 2025
+ */
+
+#ifndef INCREMENTALSUMMARY_H
+#define INCREMENTALSUMMARY_H
+
+#include <QObject>
+#include <QStringList>
+
+/**
+ * @class IncrementalSummary
+ * @brief Amends a saved summary with the transcript recorded since it was
+ * written
+ * @details Only the earlier note and the new part of the transcript are
+ * sent, and the model returns just the sections the new part changes; the
+ * other sections are kept from the earlier note. A short addendum is thus
+ * summarized in a fraction of the time of the whole day's transcript.
+ * Structured (JSON) output always returns the whole note. If the response
+ * has none of the sections, the whole transcript is summarized instead.
+ * @author Callum Thompson
+ */
+class IncrementalSummary : public QObject
+{
+    Q_OBJECT
+
+public:
+    IncrementalSummary(const QString &previousSummary, const QString &transcript, qsizetype summarizedChars,
+                       bool structured, QObject *parent);
+
+    void start();
+
+    static QStringList splitSections(const QString &summaryText, bool completeOnly = false);
+
+signals:
+    void partialResponse(const QString &textSoFar); // Earlier note with the sections amended so far
+    void finished(const QString &summaryText);      // Amended note
+    void failed(const QString &errorMessage);       // The note could not be amended or regenerated
+
+private:
+    QString previousSummary;
+    QString transcript;
+    qsizetype summarizedChars; // Length of the transcript the earlier note covers
+    bool structured;
+
+    void handleAmendment(const QString &amendment);
+    void summarizeAll();
+    QString merge(const QString &amendment, bool completeOnly) const;
+};
+
+#endif // INCREMENTALSUMMARY_H
@@ -0,0 +1,104 @@
+/**
+ * @file latencyhistory.cpp
+ * @brief Definition of LatencyHistory class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 12, 2025
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "latencyhistory.h"
+
+/**
+ * @name record
+ * @brief Adds the latency of a finished request
+ * @param[in] observedSecs: Time the request took
+ * @param[in] expectedSecs: Time the backend predicted
+ * @author Callum Thompson
+ */
+void LatencyHistory::record(double observedSecs, double expectedSecs)
+{
+    if (expectedSecs <= 0.0)
+    {
+        return;
+    }
+    append(observedSecs / expectedSecs);
+}
+
+/**
+ * @name recordLowerBound
+ * @brief Adds the latency of a request aborted because another answered first
+ * @details The request had run for observedSecs, so its latency was at
+ * least that long. This is only informative when it is already beyond the
+ * given percentile; a request aborted shortly after it was sent says
+ * nothing about its latency and is not recorded, so it cannot push real
+ * samples out of the history.
+ * @param[in] observedSecs: Time the request had run when aborted
+ * @param[in] expectedSecs: Time the backend predicted
+ * @param[in] percentile: Percentile the time must exceed to be recorded
+ * @author Callum Thompson
+ */
+void LatencyHistory::recordLowerBound(double observedSecs, double expectedSecs, double percentile)
+{
+    if (expectedSecs <= 0.0)
+    {
+        return;
+    }
+
+    double ratio = observedSecs / expectedSecs;
+    if (ratio > percentileRatio(percentile))
+    {
+        append(ratio);
+    }
+}
+
+/**
+ * @name sampleCount
+ * @brief Returns the number of latencies recorded
+ * @return Samples held, at most 64
+ * @author Callum Thompson
+ */
+int LatencyHistory::sampleCount() const
+{
+    return ratios.size();
+}
+
+/**
+ * @name percentileRatio
+ * @brief Returns a percentile of the observed to expected latency ratio
+ * @param[in] percentile: Percentile between 0 and 100
+ * @return Ratio at the percentile, or 1 if nothing has been recorded
+ * @author Callum Thompson
+ */
+double LatencyHistory::percentileRatio(double percentile) const
+{
+    if (ratios.isEmpty())
+    {
+        return 1.0;
+    }
+
+    QVector<double> sorted = ratios;
+    int index = qBound(0, static_cast<int>(std::ceil(percentile / 100.0 * sorted.size())) - 1, int(sorted.size()) - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+/**
+ * @name append
+ * @brief Stores a latency ratio, replacing the oldest once the history is full
+ * @param[in] ratio: Observed / expected latency
+ * @author Callum Thompson
+ */
+void LatencyHistory::append(double ratio)
+{
+    if (ratios.size() < capacity)
+    {
+        ratios.append(ratio);
+    }
+    else
+    {
+        ratios[next] = ratio;
+    }
+    next = (next + 1) % capacity;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file latencyhistory.h
+ * @brief Declaration of LatencyHistory class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 12, 2025
+ */
+
+#ifndef LATENCYHISTORY_H
+#define LATENCYHISTORY_H
+
+#include <QVector>
+
+/**
+ * @class LatencyHistory
+ * @brief Recent response times of a transcription backend
+ * @details Each sample is the observed latency divided by the latency the
+ * backend predicted for that audio, so requests of different lengths can
+ * be compared. Only the most recent samples are kept, so the history
+ * follows changes in service load.
+ * @author Callum Thompson
+ */
+class LatencyHistory
+{
+public:
+    void record(double observedSecs, double expectedSecs);
+    void recordLowerBound(double observedSecs, double expectedSecs, double percentile);
+    int sampleCount() const;
+    double percentileRatio(double percentile) const;
+
+private:
+    static const int capacity = 64;
+    QVector<double> ratios;   // Observed / expected latency, oldest overwritten first
+    int next = 0;             // Slot the next sample is written to
+
+    void append(double ratio);
+};
+
+#endif // LATENCYHISTORY_H
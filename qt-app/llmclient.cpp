@@ -10,11 +10,49 @@
  * @date Mar. 4, 2025
  */
 
+#include <QTextStream>
+#include <QCryptographicHash>
 #include "llmclient.h"
-#include "settings.h"
+#include "streamingbodydevice.h"
+#include "responsecache.h"
+#include "chunkedsummary.h"
+#include "sectionedsummary.h"
+#include "summaryschema.h"
+#include "incrementalsummary.h"
 
 LLMClient *LLMClient::instance = nullptr;
 
+namespace
+{
+const char *defaultBaseUrl = "https://generativelanguage.googleapis.com/v1beta";
+const char *modelName = "gemini-1.5-flash-8b-001"; // Cached content requires a versioned model
+const int cacheTtlSecs = 3600;                       // Lifetime of the cached initial prompt
+const int cacheExpiryMarginSecs = 60;                // Recreate the cache this long before it expires
+const int cacheRetryDelaySecs = 600;                 // Wait after failing to create the cache
+const int defaultSummaryPartTokens = 0;              // Never split unless configured
+const int charsPerToken = 4;                         // Rough size of a token of English text
+
+/**
+ * @brief Returns the generation settings sent with a request, serialized
+ * @details Structured requests also ask for JSON following SummarySchema.
+ */
+const QByteArray &generationConfig(bool structured)
+{
+    static const QByteArray config = []()
+    {
+        // Add parameters for the request
+        QJsonObject generationConfig;
+        generationConfig["temperature"] = 0;
+        generationConfig["top_p"] = 1.0;
+        generationConfig["top_k"] = 40;
+        return QJsonDocument(generationConfig).toJson(QJsonDocument::Compact);
+    }();
+    static const QByteArray structuredConfig = config.chopped(1) + ",\"responseMimeType\":\"application/json\","
+                                               "\"responseSchema\":" + SummarySchema::responseSchema() + "}";
+    return structured ? structuredConfig : config;
+}
+}
+
 /**
  * @name LLMClient (constructor)
  * @brief Initializes the LLM client, including the network access manager
@@ -23,9 +61,10 @@ LLMClient *LLMClient::instance = nullptr;
  * @author Callum Thompson
  */
 LLMClient::LLMClient()
-    : QObject(nullptr), networkManager(new QNetworkAccessManager(this))
+    : QObject(nullptr), networkManager(NetworkManager::getInstance()), baseUrl(defaultBaseUrl),
+      summaryPartTokens(defaultSummaryPartTokens)
 {
-    connect(networkManager, &QNetworkAccessManager::finished, this, &LLMClient::handleNetworkReply);
+    networkManager->addHost(QUrl(baseUrl));
 }
 
 /**
@@ -52,45 +91,328 @@ LLMClient *LLMClient::getInstance()
  * @name sendRequest
  * @brief Combines the initial prompt with an additional prompt and sends as a
  * request to the LLM.
- * @details Initial prompt is read from file, `llmprompt.txt`. 
+ * @details Initial prompt is read from file, `llmprompt.txt`, on the first
+ * request. With context caching enabled the initial prompt is stored on the
+ * server once and only the additional prompt is sent; requests made while
+ * the cached content is being created wait for it. A request identical to
+ * one already in flight shares its call instead of sending another. A
+ * response stored in ResponseCache is returned without calling the API
+ * unless a fresh response is asked for; it is stored again either way. The
+ * returned request always ends with finished() or failed(), never before
+ * the caller has had a chance to connect to it. A request for one section
+ * of the note is sent with the prompt SectionedSummary derives for it,
+ * always inline.
  * @param[in] prompt: Additional prompt
+ * @param[in] context: Caller's context, carried by the request
+ * @param[in] refresh: True to generate a new response even if one is stored
+ * @param[in] section: Section of the note to write, or empty for the whole note
+ * @return Request, deleted after its final signal
  * @author Callum Thompson
  */
-void LLMClient::sendRequest(const QString &prompt)
+LLMRequest *LLMClient::sendRequest(const QString &prompt, const QVariant &context, bool refresh, const QString &section)
 {
-    // Abort if no API key is set
+    LLMRequest *request = new LLMRequest(++lastRequestId, context, this);
+
+    // Abort if no API key is set or the initial system prompt could not be loaded
+    QString errorMessage;
     if (apiKey.isEmpty())
     {
         qWarning() << "API Key is empty! Request aborted.";
-        return;
+        errorMessage = "API key is empty";
+    }
+    else if (!loadInitialPrompt())
+    {
+        errorMessage = "Initial prompt could not be loaded";
+    }
+    if (!errorMessage.isEmpty())
+    {
+        QMetaObject::invokeMethod(request, [request, errorMessage]()
+                                  { request->fail(errorMessage); }, Qt::QueuedConnection);
+        return request;
+    }
+
+    // Answer from a stored response
+    QString storedResponse;
+    if (responseCaching && !refresh && ResponseCache::getInstance()->lookup(responseKey(section, prompt), storedResponse))
+    {
+        bytesSaved += instructions(section).json.size() + prompt.toUtf8().size() + storedResponse.toUtf8().size();
+        logCacheStatistics();
+        QMetaObject::invokeMethod(request, [request, storedResponse]()
+                                  { request->complete(storedResponse); }, Qt::QueuedConnection);
+        return request;
+    }
+
+    // Share the call of an identical request already in flight
+    auto waiting = requestsByPrompt.find(qMakePair(section, prompt));
+    if (waiting != requestsByPrompt.end())
+    {
+        qInfo() << "Request" << request->getId() << "shares the call of an identical request";
+        waiting->append(request);
+        return request;
+    }
+    requestsByPrompt.insert(qMakePair(section, prompt), {request});
+
+    // Store the initial prompt on the server before the first request that needs it
+    if (section.isEmpty() && contextCaching && !cacheUsable() && QDateTime::currentDateTimeUtc() >= cacheRetryTime)
+    {
+        waitingPrompts.append(prompt);
+        if (!cacheReply)
+        {
+            createCachedContent();
+        }
+        return request;
+    }
+
+    // Send the prompt to the LLM
+    sendLLMRequest(section, prompt);
+    return request;
+}
+
+/**
+ * @name summarize
+ * @brief Requests the summary of a transcript, in parts if it is long
+ * @details A transcript within the part size is sent as a single request.
+ * A longer one is split at its recordings and summarized by ChunkedSummary,
+ * whose parts are sent concurrently and merged by a final request; the
+ * returned request then reports the merge. With sectioned summaries
+ * enabled, a transcript within the part size is instead written by
+ * SectionedSummary, one request per section.
+ * @param[in] transcript: Transcript to summarize
+ * @param[in] context: Caller's context, carried by the request
+ * @param[in] refresh: True to generate new summaries even if some are stored
+ * @return Request, deleted after its final signal
+ * @author Callum Thompson
+ */
+LLMRequest *LLMClient::summarize(const QString &transcript, const QVariant &context, bool refresh)
+{
+    QStringList parts = ChunkedSummary::splitTranscript(transcript, summaryPartTokens * charsPerToken);
+    if (parts.size() < 2 && sectionedSummaries)
+    {
+        LLMRequest *request = new LLMRequest(++lastRequestId, context, this);
+        SectionedSummary *summary = new SectionedSummary(transcript, refresh, request);
+        connect(summary, &SectionedSummary::partialResponse, request, &LLMRequest::reportPartial);
+        connect(summary, &SectionedSummary::finished, request, &LLMRequest::complete);
+        connect(summary, &SectionedSummary::failed, request, &LLMRequest::fail);
+        summary->start();
+        return request;
+    }
+    if (parts.size() < 2)
+    {
+        return sendRequest(transcript, context, refresh);
     }
 
-    QString initialPrompt;
+    qInfo() << "Summarizing a transcript of" << transcript.size() << "characters in" << parts.size() << "parts";
+    LLMRequest *request = new LLMRequest(++lastRequestId, context, this);
+    ChunkedSummary *summary = new ChunkedSummary(parts, refresh, request);
+    connect(summary, &ChunkedSummary::partialResponse, request, &LLMRequest::reportPartial);
+    connect(summary, &ChunkedSummary::finished, request, &LLMRequest::complete);
+    connect(summary, &ChunkedSummary::failed, request, &LLMRequest::fail);
+    summary->start();
+    return request;
+}
+
+/**
+ * @name amendSummary
+ * @brief Requests the summary of a transcript that has grown since it was
+ * last summarized
+ * @details With incremental summaries enabled, IncrementalSummary sends the
+ * saved summary and only the part of the transcript added since, and the
+ * returned request reports the amended note, or the saved summary itself
+ * if nothing was added. Otherwise the whole transcript is summarized.
+ * @param[in] previousSummary: Saved summary
+ * @param[in] transcript: Whole transcript
+ * @param[in] summarizedChars: Length of the start of the transcript the
+ * saved summary covers
+ * @param[in] context: Caller's context, carried by the request
+ * @return Request, deleted after its final signal
+ * @author Callum Thompson
+ */
+LLMRequest *LLMClient::amendSummary(const QString &previousSummary, const QString &transcript,
+                                    qsizetype summarizedChars, const QVariant &context)
+{
+    if (!incrementalSummaries || previousSummary.trimmed().isEmpty() || summarizedChars <= 0
+        || summarizedChars > transcript.size())
+    {
+        return summarize(transcript, context);
+    }
+
+    LLMRequest *request = new LLMRequest(++lastRequestId, context, this);
+    if (summarizedChars == transcript.size())
+    {
+        QMetaObject::invokeMethod(request, [request, previousSummary]()
+                                  { request->complete(previousSummary); }, Qt::QueuedConnection);
+        return request;
+    }
+    IncrementalSummary *summary = new IncrementalSummary(previousSummary, transcript, summarizedChars,
+                                                         structuredOutput, request);
+    connect(summary, &IncrementalSummary::partialResponse, request, &LLMRequest::reportPartial);
+    connect(summary, &IncrementalSummary::finished, request, &LLMRequest::complete);
+    connect(summary, &IncrementalSummary::failed, request, &LLMRequest::fail);
+    summary->start();
+    return request;
+}
+
+/**
+ * @name setIncrementalSummaries
+ * @brief Selects whether saved summaries are amended rather than regenerated
+ * @details Amending sends only the transcript added since the summary was
+ * written and returns only the sections it changes, so summaries of short
+ * addenda are much quicker. Disabled by default.
+ * @param[in] enabled: True to amend saved summaries
+ * @author Callum Thompson
+ */
+void LLMClient::setIncrementalSummaries(bool enabled)
+{
+    incrementalSummaries = enabled;
+}
+
+/**
+ * @name model
+ * @brief Returns the model summaries are generated by
+ * @return Versioned model name
+ * @author Callum Thompson
+ */
+QString LLMClient::model() const
+{
+    return modelName;
+}
+
+/**
+ * @name promptVersion
+ * @brief Returns the version of the instructions summaries are generated from
+ * @return Digest of llmprompt.txt, or an empty string if it cannot be read
+ * @author Callum Thompson
+ */
+QString LLMClient::promptVersion()
+{
+    return loadInitialPrompt() ? initialPrompt.version : QString();
+}
+
+/**
+ * @name setSummaryPartSize
+ * @brief Sets the length above which transcripts are summarized in parts
+ * @details Splitting adds a merge request after the parts, so it only pays
+ * off for transcripts near the model's context limit. Disabled by default.
+ * @param[in] tokens: Largest transcript, in tokens, sent in one request; 0
+ * always sends a single request
+ * @author Callum Thompson
+ */
+void LLMClient::setSummaryPartSize(int tokens)
+{
+    summaryPartTokens = qMax(0, tokens);
+}
+
+/**
+ * @name setSectionedSummaries
+ * @brief Selects whether each section of a summary is written by its own request
+ * @details The sections are then written concurrently from shorter prompts,
+ * so the summary is ready once its longest section is. Each request reads
+ * the whole transcript, so more input tokens are used. Disabled by default.
+ * @param[in] enabled: True to write sections concurrently
+ * @author Callum Thompson
+ */
+void LLMClient::setSectionedSummaries(bool enabled)
+{
+    sectionedSummaries = enabled;
+}
+
+/**
+ * @name setStructuredOutput
+ * @brief Selects whether whole notes are returned as JSON
+ * @details The request then carries SummarySchema's responseSchema and the
+ * model returns each section and subsection as a named member, which
+ * SummaryGenerator reads in one pass instead of searching for markdown
+ * titles. Requests for a single section, and responses that are not JSON,
+ * still use the markdown format. Disabled by default.
+ * @param[in] enabled: True to ask for structured output
+ * @author Callum Thompson
+ */
+void LLMClient::setStructuredOutput(bool enabled)
+{
+    structuredOutput = enabled;
+}
+
+/**
+ * @name loadInitialPrompt
+ * @brief Reads the initial prompt, once
+ * @details The prompts of the sections are derived from it again when next
+ * needed.
+ * @return True if the prompt is loaded and not empty
+ * @author Callum Thompson
+ */
+bool LLMClient::loadInitialPrompt()
+{
+    if (!initialPrompt.text.isEmpty())
+    {
+        return true;
+    }
 
     // Read the initial prompt from llmprompt.txt
     QFile file(":/llmprompt.txt");
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
         qWarning() << "Failed to open llmprompt.txt. Request aborted.";
-        return;
+        return false;
     }
-    initialPrompt = QTextStream(&file).readAll().trimmed();
+    QString prompt = QTextStream(&file).readAll().trimmed();
     file.close();
 
     // Abort if the initial system prompt is empty
-    if (initialPrompt.isEmpty())
+    if (prompt.isEmpty())
     {
         qWarning() << "Initial prompt is empty! Request aborted.";
-        return;
+        return false;
     }
 
-    // Combine initial prompt and user prompt
-    QString fullPrompt = initialPrompt + "\n\n" + prompt;
+    initialPrompt = makeInstructions(prompt);
+    sectionPrompts.clear();
+    return true;
+}
 
-    userPrompt = fullPrompt; // Store user prompt including initial prompt
+/**
+ * @name instructions
+ * @brief Returns the instructions sent ahead of a request's input
+ * @details The prompt of a section is derived from the initial prompt the
+ * first time it is needed. Must be called after the initial prompt has been
+ * loaded.
+ * @param[in] section: Section of the note, or empty for the whole note
+ * @return Instructions of the section
+ * @author Callum Thompson
+ */
+LLMClient::Instructions LLMClient::instructions(const QString &section)
+{
+    if (section.isEmpty())
+    {
+        return initialPrompt;
+    }
+
+    auto found = sectionPrompts.find(section);
+    if (found == sectionPrompts.end())
+    {
+        found = sectionPrompts.insert(section, makeInstructions(SectionedSummary::sectionPrompt(initialPrompt.text, section)));
+        qInfo() << "Prompt of the" << section.toLower() << "section is" << found->text.size() << "of"
+                << initialPrompt.text.size() << "characters";
+    }
+    return *found;
+}
 
-    // Send the combined prompt to the LLM
-    sendLLMRequest(fullPrompt);
+/**
+ * @name makeInstructions
+ * @brief Prepares instructions for sending
+ * @details The text is kept both as is, for the cached content, and as
+ * escaped UTF-8, so inline requests copy it into the body without converting
+ * it again.
+ * @param[in] text: Instructions
+ * @return Instructions with their escaped form and digest
+ * @author Callum Thompson
+ */
+LLMClient::Instructions LLMClient::makeInstructions(const QString &text)
+{
+    Instructions result;
+    result.text = text;
+    result.version = QString::fromLatin1(QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1).toHex());
+    StreamingBodyDevice::appendEscapedJson(result.json, text + "\n\n");
+    return result;
 }
 
 /**
@@ -103,46 +425,476 @@ void LLMClient::setApiKey(const QString& key)
     apiKey = key;
 }
 
+/**
+ * @name setStreaming
+ * @brief Selects whether responses are streamed
+ * @details Streamed requests report their text through partialResponse()
+ * as it is generated, so the first sections of a summary can be shown long
+ * before the last is written. Enabled by default.
+ * @param[in] enabled: True to stream responses
+ * @author Callum Thompson
+ */
+void LLMClient::setStreaming(bool enabled)
+{
+    streaming = enabled;
+}
+
+/**
+ * @name setContextCaching
+ * @brief Selects whether the initial prompt is cached on the server
+ * @details The initial prompt is then uploaded once as a cachedContents
+ * resource and each request only carries its transcript. The server
+ * requires a minimum prompt size for caching; if the cached content cannot
+ * be created, requests include the prompt inline and creation is retried
+ * after a while. Disabled by default.
+ * @param[in] enabled: True to cache the initial prompt
+ * @author Callum Thompson
+ */
+void LLMClient::setContextCaching(bool enabled)
+{
+    contextCaching = enabled;
+    if (!enabled)
+    {
+        cacheName.clear();
+    }
+}
+
+/**
+ * @name setResponseCacheSize
+ * @brief Sets the disk space for stored responses
+ * @param[in] bytes: Size limit of ResponseCache; 0 disables the cache
+ * @author Callum Thompson
+ */
+void LLMClient::setResponseCacheSize(qint64 bytes)
+{
+    responseCaching = bytes > 0;
+    ResponseCache::getInstance()->setMaximumSize(bytes);
+}
+
+/**
+ * @name responseKey
+ * @brief Returns the key of a request's response in ResponseCache
+ * @details Must be called after the initial prompt has been loaded.
+ * @param[in] section: Section of the note, or empty for the whole note
+ * @param[in] prompt: Input prompt, without the initial prompt
+ * @return Key combining the model, generation settings, instructions and input
+ * @author Callum Thompson
+ */
+QString LLMClient::responseKey(const QString &section, const QString &prompt)
+{
+    return ResponseCache::key(modelName, generationConfig(structuredOutput && section.isEmpty()),
+                              instructions(section).version, prompt);
+}
+
+/**
+ * @name logCacheStatistics
+ * @brief Logs how often stored responses were used and the traffic they saved
+ * @author Callum Thompson
+ */
+void LLMClient::logCacheStatistics() const
+{
+    DiskCache::Statistics stats = ResponseCache::getInstance()->statistics();
+    int lookups = stats.hits + stats.misses;
+    qInfo() << "Stored response used:" << stats.hits << "of" << lookups << "lookups hit ("
+            << (lookups > 0 ? stats.hits * 100 / lookups : 0) << "%)," << bytesSaved / 1024 << "KB not sent or received";
+}
+
+/**
+ * @name setBaseUrl
+ * @brief Sets the address of the Gemini API
+ * @details Allows requests to be sent to a local stand-in for the API.
+ * Cached content belongs to the server it was created on, so it is
+ * discarded.
+ * @param[in] url: Base URL, up to and including the API version
+ * @author Callum Thompson
+ */
+void LLMClient::setBaseUrl(const QString &url)
+{
+    QString trimmed = url.trimmed();
+    while (trimmed.endsWith('/'))
+    {
+        trimmed.chop(1);
+    }
+    baseUrl = trimmed.isEmpty() ? QString(defaultBaseUrl) : trimmed;
+    cacheName.clear();
+    networkManager->addHost(QUrl(baseUrl));
+}
+
+/**
+ * @name cacheUsable
+ * @brief Returns whether the cached initial prompt can be used
+ * @return True if cached content exists and is not about to expire
+ * @author Callum Thompson
+ */
+bool LLMClient::cacheUsable() const
+{
+    // Leave a margin so the content does not expire while a request is queued
+    return !cacheName.isEmpty() && QDateTime::currentDateTimeUtc().addSecs(cacheExpiryMarginSecs) < cacheExpiry;
+}
+
+/**
+ * @name createCachedContent
+ * @brief Uploads the initial prompt as cached content
+ * @details The reply is handled by handleCacheReply().
+ * @author Callum Thompson
+ */
+void LLMClient::createCachedContent()
+{
+    QNetworkRequest request(QUrl(baseUrl + "/cachedContents?key=" + apiKey));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    QByteArray body = "{\"model\":\"models/" + QByteArray(modelName) + "\",\"ttl\":\""
+                      + QByteArray::number(cacheTtlSecs) + "s\",\"systemInstruction\":{\"parts\":[{\"text\":\"";
+    StreamingBodyDevice::appendEscapedJson(body, initialPrompt.text);
+    body += "\"}]}}";
+
+    cacheReply = networkManager->post(request, body);
+    connect(cacheReply, &QNetworkReply::finished, this, [this, reply = cacheReply]()
+            { handleNetworkReply(reply); });
+}
+
+/**
+ * @name handleCacheReply
+ * @brief Records the cached content and sends the requests waiting for it
+ * @details If the content could not be created, the waiting requests include
+ * the initial prompt inline and creation is not retried for a while.
+ * @param[in] reply: Network reply of the cachedContents request
+ * @author Callum Thompson
+ */
+void LLMClient::handleCacheReply(QNetworkReply *reply)
+{
+    cacheReply = nullptr;
+    reply->deleteLater();
+
+    QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+    QString name = response.value("name").toString();
+    if (reply->error() != QNetworkReply::NoError || name.isEmpty())
+    {
+        qWarning() << "Could not cache the initial prompt, sending it with each request:" << reply->errorString();
+        cacheRetryTime = QDateTime::currentDateTimeUtc().addSecs(cacheRetryDelaySecs);
+    }
+    else
+    {
+        cacheName = name;
+        cacheExpiry = QDateTime::fromString(response.value("expireTime").toString(), Qt::ISODateWithMs);
+        if (!cacheExpiry.isValid())
+        {
+            cacheExpiry = QDateTime::currentDateTimeUtc().addSecs(cacheTtlSecs);
+        }
+        qInfo() << "Cached the initial prompt as" << cacheName << "until" << cacheExpiry.toString(Qt::ISODate)
+                << "using" << response.value("usageMetadata").toObject().value("totalTokenCount").toInt() << "tokens";
+    }
+
+    const QStringList prompts = waitingPrompts;
+    waitingPrompts.clear();
+    for (const QString &prompt : prompts)
+    {
+        sendLLMRequest(QString(), prompt);
+    }
+}
+
+/**
+ * @name retryExpiredCache
+ * @brief Resends a request whose cached content no longer exists
+ * @details The server answers 403 or 404 once cached content has expired or
+ * been deleted. The request is resent with the initial prompt inline, and
+ * the next request recreates the cached content.
+ * @param[in] reply: Failed network reply
+ * @param[in] call: Call the reply belongs to
+ * @return True if the request was resent
+ * @author Callum Thompson
+ */
+bool LLMClient::retryExpiredCache(QNetworkReply *reply, const Call &call)
+{
+    if (call.cacheName.isEmpty())
+    {
+        return false;
+    }
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 403 && status != 404)
+    {
+        return false;
+    }
+
+    qInfo() << "Cached content" << call.cacheName << "is gone, resending without it";
+    if (cacheName == call.cacheName)
+    {
+        cacheName.clear();
+    }
+    sendLLMRequest(call.section, call.prompt);
+    return true;
+}
+
 /**
  * @name sendLLMRequest
  * @brief Parses the input prompt, sets generation configuration, and sends as a
  * request and sends to the LLM.
  * @details This function constructs the JSON request body, sets the necessary headers, 
  * and sends the request to the google gemini API, the version is gemini-1.5-flash-8b.
- * @param[in] inputPrompt: Input prompt
+ * In streaming mode the streamGenerateContent method is used, which sends the
+ * response as server-sent events. The initial prompt is referenced by its
+ * cached content if usable, and otherwise sent inline ahead of the input.
+ * The prompt of a section is always sent inline.
+ * @param[in] section: Section of the note, or empty for the whole note
+ * @param[in] inputPrompt: Input prompt, without the initial prompt
  * @author Callum Thompson
  */
-void LLMClient::sendLLMRequest(const QString &inputPrompt)
+void LLMClient::sendLLMRequest(const QString &section, const QString &inputPrompt)
 {
     // Construct the API URL with the provided API key
-    QUrl url("https://generativelanguage.googleapis.com/v1beta/models/gemini-1.5-flash-8b:generateContent?key=" + apiKey);
+    QString method = streaming ? ":streamGenerateContent?alt=sse&key=" : ":generateContent?key=";
+    QUrl url(baseUrl + "/models/" + modelName + method + apiKey);
 
     // Set up the network request headers
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
-    // Constructing the JSON request body
-    QJsonObject textPart;
-    textPart["text"] = inputPrompt;
+    // Constructing the JSON request body. The prompt is escaped straight to UTF-8
+    // instead of going through a QJsonObject tree and a second serialization.
+    // The instructions were escaped when they were loaded.
+    bool useCache = section.isEmpty() && contextCaching && cacheUsable();
+    StreamingBodyDevice *body = new StreamingBodyDevice;
+    if (useCache)
+    {
+        body->appendRaw("{\"cachedContent\":\"" + cacheName.toUtf8() + "\",\"contents\":[{\"role\":\"user\",\"parts\":[{\"text\":");
+        body->appendJsonString(inputPrompt);
+    }
+    else
+    {
+        QByteArray text = "{\"contents\":[{\"parts\":[{\"text\":\"" + instructions(section).json;
+        StreamingBodyDevice::appendEscapedJson(text, inputPrompt);
+        text += '"';
+        body->appendRaw(text);
+    }
+    body->appendRaw("}]}],\"generationConfig\":" + generationConfig(structuredOutput && section.isEmpty()) + "}");
+    body->open(QIODevice::ReadOnly);
+    request.setHeader(QNetworkRequest::ContentLengthHeader, body->size());
 
-    QJsonObject content;
-    content["parts"] = QJsonArray{textPart};
+    // Send POST request
+    QNetworkReply *reply = networkManager->post(request, body);
+    body->setParent(reply); // Cleanup when reply is finished
+    connect(reply, &QNetworkReply::finished, this, [this, reply]()
+            { handleNetworkReply(reply); });
+
+    Call call;
+    call.section = section;
+    call.prompt = inputPrompt;
+    call.cacheName = useCache ? cacheName : QString();
+    call.streamed = streaming;
+    call.sentAt = QDateTime::currentMSecsSinceEpoch();
+    calls.insert(reply, call);
+    if (streaming)
+    {
+        connect(reply, &QNetworkReply::readyRead, this, [this, reply]()
+                { handleStreamData(reply); });
+    }
+}
 
-    QJsonObject requestBody;
-    requestBody["contents"] = QJsonArray{content};
+/**
+ * @name completeRequests
+ * @brief Stores a response and delivers it to every request waiting on a call
+ * @param[in] call: Finished call
+ * @param[in] response: Full response text
+ * @author Callum Thompson
+ */
+void LLMClient::completeRequests(const Call &call, const QString &response)
+{
+    if (responseCaching)
+    {
+        ResponseCache::getInstance()->store(responseKey(call.section, call.prompt), response);
+    }
 
-    // Add parameters for the request
-    QJsonObject generationConfig;
-    generationConfig["temperature"] = 0;
-    generationConfig["top_p"] = 1.0;
-    generationConfig["top_k"] = 40;
-    requestBody["generationConfig"] = generationConfig;
+    const QList<QPointer<LLMRequest>> requests = requestsByPrompt.take(qMakePair(call.section, call.prompt));
+    for (const QPointer<LLMRequest> &request : requests)
+    {
+        if (request)
+        {
+            request->complete(response);
+        }
+    }
+}
 
-    QJsonDocument jsonDoc(requestBody);
-    QByteArray jsonData = jsonDoc.toJson();
+/**
+ * @name failRequests
+ * @brief Fails every request waiting on a call
+ * @param[in] call: Failed call
+ * @param[in] errorMessage: Description of the failure
+ * @author Callum Thompson
+ */
+void LLMClient::failRequests(const Call &call, const QString &errorMessage)
+{
+    const QList<QPointer<LLMRequest>> requests = requestsByPrompt.take(qMakePair(call.section, call.prompt));
+    for (const QPointer<LLMRequest> &request : requests)
+    {
+        if (request)
+        {
+            request->fail(errorMessage);
+        }
+    }
+}
 
-    // Send POST request
-    networkManager->post(request, jsonData);
+/**
+ * @name handleStreamData
+ * @brief Reads the events received on a streamed response
+ * @details Reports the text received so far to the waiting requests whenever
+ * a chunk adds to it.
+ * @param[in] reply: Network reply of the streamed request
+ * @author Callum Thompson
+ */
+void LLMClient::handleStreamData(QNetworkReply *reply)
+{
+    auto call = calls.find(reply);
+    if (call == calls.end() || !call->streamed || reply->error() != QNetworkReply::NoError)
+    {
+        return; // Errors are reported once the reply finishes
+    }
+
+    call->stream.pending.append(reply->readAll());
+    if (readStreamEvents(call->stream))
+    {
+        // Receivers may send other requests, so do not hold on to the call
+        QString textSoFar = call->stream.text;
+        const QList<QPointer<LLMRequest>> requests = requestsByPrompt.value(qMakePair(call->section, call->prompt));
+        for (const QPointer<LLMRequest> &request : requests)
+        {
+            if (request)
+            {
+                request->reportPartial(textSoFar);
+            }
+        }
+    }
+}
+
+/**
+ * @name handleStreamFinished
+ * @brief Completes a streamed response
+ * @details Delivers the full response text to the waiting requests, or
+ * fails them if no text was received.
+ * @param[in] reply: Network reply of the streamed request
+ * @param[in,out] call: Call the reply belongs to
+ * @author Callum Thompson
+ */
+void LLMClient::handleStreamFinished(QNetworkReply *reply, Call &call)
+{
+    // The last event may not be followed by a blank line
+    ResponseStream &stream = call.stream;
+    stream.pending.append(reply->readAll());
+    stream.pending.append("\n\n");
+    readStreamEvents(stream);
+    logUsage(call, stream.usage);
+
+    if (stream.text.isEmpty())
+    {
+        qWarning() << "Response text is empty.";
+        failRequests(call, "Response text is empty.");
+        return;
+    }
+    completeRequests(call, stream.text);
+}
+
+/**
+ * @name readStreamEvents
+ * @brief Parses the complete server-sent events received on a stream
+ * @details Each event carries a partial GenerateContentResponse in its data
+ * lines; the text of its candidate is appended to the stream's text. An
+ * incomplete trailing line is kept until more data arrives.
+ * @param[in,out] stream: Streamed response
+ * @return True if text was added
+ * @author Callum Thompson
+ */
+bool LLMClient::readStreamEvents(ResponseStream &stream)
+{
+    bool textAdded = false;
+    qsizetype lineStart = 0;
+    qsizetype lineEnd;
+    while ((lineEnd = stream.pending.indexOf('\n', lineStart)) != -1)
+    {
+        QByteArrayView line(stream.pending.constData() + lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        if (line.endsWith('\r'))
+        {
+            line.chop(1);
+        }
+
+        if (line.isEmpty())
+        {
+            // A blank line dispatches the event
+            if (!stream.eventData.isEmpty())
+            {
+                QJsonDocument chunk = QJsonDocument::fromJson(stream.eventData);
+                stream.eventData.clear();
+                QString text = chunk.isObject() ? candidateText(chunk.object()) : QString();
+                if (chunk.object().contains("usageMetadata"))
+                {
+                    stream.usage = chunk.object().value("usageMetadata").toObject();
+                }
+                if (!text.isEmpty())
+                {
+                    stream.text += text;
+                    textAdded = true;
+                }
+            }
+        }
+        else if (line.startsWith("data:"))
+        {
+            QByteArrayView data = line.sliced(5);
+            if (data.startsWith(' '))
+            {
+                data = data.sliced(1);
+            }
+            if (!stream.eventData.isEmpty())
+            {
+                stream.eventData.append('\n');
+            }
+            stream.eventData.append(data);
+        }
+        // Other fields and comments are not sent by the API
+    }
+    stream.pending.remove(0, lineStart);
+    return textAdded;
+}
+
+/**
+ * @name logUsage
+ * @brief Logs the tokens and server time used by a request
+ * @details Shows whether the initial prompt was read from the cache.
+ * @param[in] call: Finished call
+ * @param[in] usage: Usage metadata of the response
+ * @author Callum Thompson
+ */
+void LLMClient::logUsage(const Call &call, const QJsonObject &usage)
+{
+    qint64 elapsedMs = QDateTime::currentMSecsSinceEpoch() - call.sentAt;
+    QString what = call.section.isEmpty() ? QString("Summary") : "Summary section " + call.section;
+    qInfo().noquote() << what << "request took" << elapsedMs << "ms using"
+            << usage.value("promptTokenCount").toInt() << "input tokens,"
+            << usage.value("cachedContentTokenCount").toInt() << "of them cached, and"
+            << usage.value("candidatesTokenCount").toInt() << "output tokens";
+}
+
+/**
+ * @name candidateText
+ * @brief Extracts the text of the first candidate of a response
+ * @param[in] response: GenerateContentResponse, or a chunk of a streamed one
+ * @return Concatenated text of the candidate's parts, or an empty string
+ * @author Callum Thompson
+ */
+QString LLMClient::candidateText(const QJsonObject &response)
+{
+    const QJsonArray candidates = response.value("candidates").toArray();
+    if (candidates.isEmpty())
+    {
+        return QString();
+    }
+
+    QString text;
+    const QJsonArray parts = candidates[0].toObject().value("content").toObject().value("parts").toArray();
+    for (const QJsonValue &part : parts)
+    {
+        text += part.toObject().value("text").toString();
+    }
+    return text;
 }
 
 /**
@@ -150,39 +902,61 @@ void LLMClient::sendLLMRequest(const QString &inputPrompt)
  * @brief Handle network reply by parsing the response data, converting it to a
  * JSON format, and emit a signal that a response has been recieved.
  * @details This function checks for errors in the network reply, parses the JSON response,
- * and extracts the relevant information. If the response is valid, it emits a signal with
- * the response text.
+ * and extracts the relevant information. If the response is valid, the response text is
+ * delivered to every request waiting on the call; otherwise they fail. Streamed replies
+ * are completed by handleStreamFinished().
  * @param[in] reply: Network reply
  * @author Callum Thompson
  */
 void LLMClient::handleNetworkReply(QNetworkReply *reply)
 {
-    // Read the full response payload from the network reply
-    QByteArray responseData = reply->readAll();
+    if (reply == cacheReply)
+    {
+        handleCacheReply(reply);
+        return;
+    }
+    Call call = calls.take(reply);
     reply->deleteLater(); // Clean up the reply object
 
     // Check for network errors (e.g., invalid API key or no connection)
     if (reply->error() != QNetworkReply::NoError)
     {
+        if (retryExpiredCache(reply, call))
+        {
+            return;
+        }
         qWarning() << "Network error:" << reply->errorString();
         emit invalidAPIKey(reply);// Notify the rest of the app
+        failRequests(call, reply->errorString());
+        return;
+    }
+
+    if (call.streamed)
+    {
+        handleStreamFinished(reply, call);
         return;
     }
 
+    // Read the full response payload from the network reply
+    QByteArray responseData = reply->readAll();
+
     // Parse the response JSON
     QJsonDocument jsonResponse = QJsonDocument::fromJson(responseData);
     if (!jsonResponse.isObject())
     {
         qWarning() << "Invalid JSON response.";
+        failRequests(call, "Invalid JSON response.");
         return;
     }
 
     QJsonObject jsonObj = jsonResponse.object();
+    logUsage(call, jsonObj.value("usageMetadata").toObject());
 
     // Verify the presence of "candidates" array
     if (!jsonObj.contains("candidates") || !jsonObj["candidates"].isArray())
     {
         qWarning() << "No candidates found in response.";
+        failRequests(call, "No candidates found in response.");
         return;
     }
 
@@ -192,6 +966,7 @@ void LLMClient::handleNetworkReply(QNetworkReply *reply)
     if (candidates.isEmpty() || !candidates[0].isObject())
     {
         qWarning() << "Empty candidates list.";
+        failRequests(call, "Empty candidates list.");
         return;
     }
 
@@ -201,6 +976,7 @@ void LLMClient::handleNetworkReply(QNetworkReply *reply)
     if (!candidate.contains("content") || !candidate["content"].isObject())
     {
         qWarning() << "No content in response.";
+        failRequests(call, "No content in response.");
         return;
     }
 
@@ -210,6 +986,7 @@ void LLMClient::handleNetworkReply(QNetworkReply *reply)
     if (!contentObj.contains("parts") || !contentObj["parts"].isArray())
     {
         qWarning() << "No parts in content.";
+        failRequests(call, "No parts in content.");
         return;
     }
 
@@ -219,6 +996,7 @@ void LLMClient::handleNetworkReply(QNetworkReply *reply)
     if (parts.isEmpty() || !parts[0].isObject())
     {
         qWarning() << "No valid text response found.";
+        failRequests(call, "No valid text response found.");
         return;
     }
 
@@ -227,10 +1005,11 @@ void LLMClient::handleNetworkReply(QNetworkReply *reply)
     if (responseText.isEmpty())
     {
         qWarning() << "Response text is empty.";
+        failRequests(call, "Response text is empty.");
         return;
     }
 
-    // Emit the final response
-    emit responseReceived(responseText);
+    // Deliver the final response
+    completeRequests(call, responseText);
 }
 
@@ -19,13 +19,25 @@
 #include <QUrl>
 #include <QDebug>
 #include <QFile>
+#include <QHash>
+#include <QDateTime>
+#include <QPointer>
+#include "llmrequest.h"
+#include "networkmanager.h"
 
 /**
  * @class LLMClient
  * @brief A class to handle communication with a large language model (LLM) API.
  * @details This class is responsible for sending requests to the LLM API and receiving responses. 
- * It uses the QNetworkAccessManager class to handle network operations and emits signals when responses are received.
+ * It sends requests through the shared NetworkManager. Each request is returned as an
+ * LLMRequest that reports its own response, so many requests can be in flight at once over the shared
+ * connection pool. Identical requests in flight share one call to the API.
  * The class also manages the API key and user prompt for the requests.
+ * In streaming mode the response arrives as server-sent events and the text
+ * generated so far is reported as each chunk is received. The initial prompt
+ * is read once and may be cached on the server, so only the transcript is
+ * uploaded with each request. A request may instead ask for a single section
+ * of the note, which is sent with that section's shorter prompt.
  * @author Callum Thompson
  */
 class LLMClient : public QObject
@@ -33,27 +45,112 @@ class LLMClient : public QObject
     Q_OBJECT
 
 public:
-    void sendRequest(const QString &prompt);
+    LLMRequest *sendRequest(const QString &prompt, const QVariant &context = QVariant(), bool refresh = false,
+                            const QString &section = QString());
+    LLMRequest *summarize(const QString &transcript, const QVariant &context = QVariant(), bool refresh = false);
+    LLMRequest *amendSummary(const QString &previousSummary, const QString &transcript, qsizetype summarizedChars,
+                             const QVariant &context = QVariant());
     static LLMClient *getInstance();
     void setApiKey(const QString& key);
+    void setStreaming(bool enabled);
+    void setContextCaching(bool enabled);
+    void setBaseUrl(const QString &url);
+    void setResponseCacheSize(qint64 bytes);
+    void setSummaryPartSize(int tokens);
+    void setSectionedSummaries(bool enabled);
+    void setStructuredOutput(bool enabled);
+    void setIncrementalSummaries(bool enabled);
+    QString model() const;
+    QString promptVersion();
 
 signals:
-    void responseReceived(const QString &response);
     void invalidAPIKey(QNetworkReply *reply);
 
 private slots:
     void handleNetworkReply(QNetworkReply *reply);
 
 private:
+    /**
+     * @struct ResponseStream
+     * @brief Progress of a streamed response
+     */
+    struct ResponseStream
+    {
+        QByteArray pending;   // Received bytes not yet forming a complete line
+        QByteArray eventData; // Data lines of the event being received
+        QString text;         // Response text received so far
+        QJsonObject usage;    // Token counts, sent with the last chunk
+    };
+
+    /**
+     * @struct Instructions
+     * @brief Prompt sent ahead of the input of a request
+     */
+    struct Instructions
+    {
+        QString text;    // Instructions as read or derived
+        QByteArray json; // text escaped for a JSON string, with separator
+        QString version; // Digest of text
+    };
+
+    /**
+     * @struct Call
+     * @brief Call to the API in flight
+     */
+    struct Call
+    {
+        QString section;       // Section of the note asked for, or empty for all of it
+        QString prompt;        // Input prompt, shared by the coalesced requests
+        QString cacheName;     // Cached content the call referenced, or empty
+        bool streamed = false; // Response arrives as server-sent events
+        ResponseStream stream; // Progress of a streamed response
+        qint64 sentAt = 0;     // Milliseconds since epoch when sent
+    };
+
     static LLMClient *instance; // Singleton instance
     explicit LLMClient();
     LLMClient(const LLMClient &) = delete;
     LLMClient &operator=(const LLMClient &) = delete;
-    QNetworkAccessManager *networkManager;
+    NetworkManager *networkManager;
     QString apiKey;
-    QString userPrompt; // Stores the user prompt for the second request
+    QString baseUrl;           // Gemini API address, up to the version
+    Instructions initialPrompt; // Instructions sent ahead of every input prompt
+    QHash<QString, Instructions> sectionPrompts; // Instructions of each section, derived from initialPrompt
+    bool responseCaching = true;
+    qint64 bytesSaved = 0;     // Request and response bytes avoided by stored responses
+    int summaryPartTokens;     // Transcripts longer than this are summarized in parts
+    bool sectionedSummaries = false; // Summaries are written one section per request
+    bool structuredOutput = false;   // Whole notes are returned as JSON
+    bool incrementalSummaries = false; // Saved summaries are amended with new transcript
+    bool streaming = true;
+    int lastRequestId = 0;
+    QHash<QNetworkReply *, Call> calls; // Calls to the API in flight
+    QHash<QPair<QString, QString>, QList<QPointer<LLMRequest>>> requestsByPrompt; // Requests waiting on each section and input prompt
+
+    bool contextCaching = false;
+    QString cacheName;                // Cached content holding the initial prompt
+    QDateTime cacheExpiry;            // When the server deletes cacheName
+    QDateTime cacheRetryTime;         // Earliest time to retry creating the cache after a failure
+    QNetworkReply *cacheReply = nullptr;  // Pending cachedContents request
+    QStringList waitingPrompts;       // Requests waiting for the cache to be created
 
-    void sendLLMRequest(const QString &inputPrompt);
+    bool loadInitialPrompt();
+    Instructions instructions(const QString &section);
+    static Instructions makeInstructions(const QString &text);
+    QString responseKey(const QString &section, const QString &prompt);
+    void logCacheStatistics() const;
+    bool cacheUsable() const;
+    void createCachedContent();
+    void handleCacheReply(QNetworkReply *reply);
+    bool retryExpiredCache(QNetworkReply *reply, const Call &call);
+    void sendLLMRequest(const QString &section, const QString &inputPrompt);
+    void completeRequests(const Call &call, const QString &response);
+    void failRequests(const Call &call, const QString &errorMessage);
+    void logUsage(const Call &call, const QJsonObject &usage);
+    void handleStreamData(QNetworkReply *reply);
+    void handleStreamFinished(QNetworkReply *reply, Call &call);
+    bool readStreamEvents(ResponseStream &stream);
+    static QString candidateText(const QJsonObject &response);
 };
 
 #endif // LLMCLIENT_H
@@ -0,0 +1,110 @@
+/**
+ * @file llmrequest.cpp
+ * @brief Definition of LLMRequest class
+ *
+ * Tracks a request to the LLM, reporting its response through signals to
+ * whoever sent it.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 16, 2025
+ */
+
+#include "llmrequest.h"
+
+/**
+ * @name LLMRequest (constructor)
+ * @brief Initializes a new request
+ * @details Requests are only created by LLMClient.
+ * @param[in] id: Unique request identifier
+ * @param[in] context: Caller's context, returned by getContext()
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+LLMRequest::LLMRequest(int id, const QVariant &context, QObject *parent)
+    : QObject(parent), id(id), context(context)
+{
+    // No logic body
+}
+
+/**
+ * @name getId
+ * @brief Returns the unique identifier of the request
+ * @return Request identifier
+ * @author Callum Thompson
+ */
+int LLMRequest::getId() const
+{
+    return id;
+}
+
+/**
+ * @name getContext
+ * @brief Returns the context the request was sent with
+ * @return Caller's context, such as a patient ID
+ * @author Callum Thompson
+ */
+const QVariant &LLMRequest::getContext() const
+{
+    return context;
+}
+
+/**
+ * @name isDone
+ * @brief Returns whether the request has finished or failed
+ * @return True once the request's final signal has been emitted
+ * @author Callum Thompson
+ */
+bool LLMRequest::isDone() const
+{
+    return done;
+}
+
+/**
+ * @name reportPartial
+ * @brief Reports the response text received so far
+ * @param[in] textSoFar: Response text received so far
+ * @author Callum Thompson
+ */
+void LLMRequest::reportPartial(const QString &textSoFar)
+{
+    if (!done)
+    {
+        emit partialResponse(textSoFar);
+    }
+}
+
+/**
+ * @name complete
+ * @brief Ends the request successfully
+ * @param[in] response: Full response text
+ * @author Callum Thompson
+ */
+void LLMRequest::complete(const QString &response)
+{
+    if (done)
+    {
+        return;
+    }
+    done = true;
+
+    emit finished(response);
+    deleteLater();
+}
+
+/**
+ * @name fail
+ * @brief Ends the request with an error
+ * @param[in] errorMessage: Description of the failure
+ * @author Callum Thompson
+ */
+void LLMRequest::fail(const QString &errorMessage)
+{
+    if (done)
+    {
+        return;
+    }
+    done = true;
+
+    emit failed(errorMessage);
+    deleteLater();
+}
@@ -0,0 +1,56 @@
+/**
+ * @file llmrequest.h
+ * @brief Declaration of LLMRequest class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 16, 2025
+ */
+
+#ifndef LLMREQUEST_H
+#define LLMREQUEST_H
+
+#include <QObject>
+#include <QString>
+#include <QVariant>
+
+/**
+ * @class LLMRequest
+ * @brief Handle to a single request sent to the LLM
+ * @details Returned by LLMClient::sendRequest(). The request carries the
+ * context it was sent with, such as the patient being summarized, so its
+ * response can be attributed no matter how many requests are in flight. In
+ * streaming mode it reports the text generated so far, and it ends by
+ * emitting exactly one of finished() or failed(). The request deletes itself
+ * after its final signal has been emitted, so callers that keep the pointer
+ * should hold it in a QPointer.
+ * @author Callum Thompson
+ */
+class LLMRequest : public QObject
+{
+    Q_OBJECT
+
+    friend class LLMClient;
+
+public:
+    int getId() const;
+    const QVariant &getContext() const;
+    bool isDone() const;
+
+signals:
+    void partialResponse(const QString &textSoFar); // Streaming mode only, before finished()
+    void finished(const QString &response);         // Full response text
+    void failed(const QString &errorMessage);       // No response will be received
+
+private:
+    LLMRequest(int id, const QVariant &context, QObject *parent);
+
+    int id;
+    QVariant context;
+    bool done = false;
+
+    void reportPartial(const QString &textSoFar);
+    void complete(const QString &response);
+    void fail(const QString &errorMessage);
+};
+
+#endif // LLMREQUEST_H
@@ -0,0 +1,270 @@
+/**
+ * @file localwhisperbackend.cpp
+ * @brief Definition of LocalWhisperBackend class
+ *
+ * The transcription runs in a separate whisper.cpp process, so a crash or a
+ * slow model never affects the application, and the process is killed when
+ * the request is aborted.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QDebug>
+#include "localwhisperbackend.h"
+
+namespace
+{
+const double modelLoadSecs = 0.5;           // Time to load a quantized model
+const double realTimeFactorPerCore = 0.4;   // Seconds of processing per second of audio on one core
+const char *const defaultExecutable = "whisper-cli";
+
+/**
+ * @class LocalTranscriptionRequest
+ * @brief Transcription running in a whisper.cpp process
+ */
+class LocalTranscriptionRequest : public TranscriptionRequest
+{
+public:
+    LocalTranscriptionRequest()
+    {
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        QObject::connect(&process, &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus status)
+                         { handleFinished(exitCode, status); });
+        QObject::connect(&process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error)
+        {
+            // May be raised inside start(), before the owner has connected to finished()
+            if (error == QProcess::FailedToStart)
+            {
+                QString message = "Could not start whisper.cpp: " + process.errorString();
+                QMetaObject::invokeMethod(this, [this, message]() { fail(message); }, Qt::QueuedConnection);
+            }
+        });
+    }
+
+    ~LocalTranscriptionRequest()
+    {
+        if (process.state() != QProcess::NotRunning)
+        {
+            process.kill();
+            process.waitForFinished();
+        }
+    }
+
+    bool begin(const QString &executable, const QString &model, const QString &audioPath, const QByteArray &flac)
+    {
+        if (!workDir.isValid())
+        {
+            qWarning() << "Could not create a temporary directory for whisper.cpp";
+            return false;
+        }
+
+        // Decode from the trimmed FLAC stream when there is one
+        QString inputPath = audioPath;
+        if (!flac.isEmpty())
+        {
+            inputPath = workDir.filePath("audio.flac");
+            QFile input(inputPath);
+            if (!input.open(QIODevice::WriteOnly) || input.write(flac) != flac.size())
+            {
+                qWarning() << "Could not write audio for whisper.cpp:" << inputPath;
+                return false;
+            }
+        }
+
+        outputBase = workDir.filePath("transcript");
+        QStringList arguments;
+        arguments << "-m" << model
+                  << "-t" << QString::number(QThread::idealThreadCount())
+                  << "-l" << "en"
+                  << "-oj" << "-of" << outputBase
+                  << "-np"
+                  << "-f" << inputPath;
+        process.start(executable, arguments);
+        return true;
+    }
+
+    void abort() override
+    {
+        if (process.state() != QProcess::NotRunning)
+        {
+            process.kill();
+        }
+    }
+
+private:
+    QProcess process;
+    QTemporaryDir workDir;
+    QString outputBase;
+
+    void handleFinished(int exitCode, QProcess::ExitStatus status)
+    {
+        if (status != QProcess::NormalExit || exitCode != 0)
+        {
+            fail(QString("whisper.cpp exited with code %1").arg(exitCode));
+            return;
+        }
+
+        // whisper-cli -oj writes {"transcription":[{"offsets":{"from":ms},"text":...}]}
+        QFile output(outputBase + ".json");
+        if (!output.open(QIODevice::ReadOnly))
+        {
+            fail("whisper.cpp did not write a transcript");
+            return;
+        }
+        QJsonDocument doc = QJsonDocument::fromJson(output.readAll());
+        if (!doc.isObject())
+        {
+            fail("Invalid response format");
+            return;
+        }
+
+        QStringList texts;
+        QList<TranscriptSegment> segments;
+        for (const QJsonValue &value : doc.object().value("transcription").toArray())
+        {
+            QJsonObject segment = value.toObject();
+            QString text = segment.value("text").toString().trimmed();
+            if (!text.isEmpty())
+            {
+                double startSecs = segment.value("offsets").toObject().value("from").toDouble() / 1000.0;
+                segments.append({startSecs, text});
+                texts.append(text);
+            }
+        }
+        succeed(texts.join(' '), segments);
+    }
+};
+}
+
+/**
+ * @name setModel
+ * @brief Configures the whisper.cpp program and model
+ * @param[in] newExecutable: Path of whisper-cli, or empty to search PATH
+ * @param[in] newModelPath: Path of the GGML model file; empty disables the backend
+ * @author Callum Thompson
+ */
+void LocalWhisperBackend::setModel(const QString &newExecutable, const QString &newModelPath)
+{
+    executable = newExecutable;
+    modelPath = newModelPath;
+}
+
+/**
+ * @name name
+ * @brief Returns the name of the backend
+ * @return "whisper.cpp (local)"
+ * @author Callum Thompson
+ */
+QString LocalWhisperBackend::name() const
+{
+    return "whisper.cpp (local)";
+}
+
+/**
+ * @name configuration
+ * @brief Returns the model file and language requests use
+ * @details The model's size and modification time are included so a
+ * replaced model does not reuse transcripts of the old one.
+ * @return Configuration of the backend
+ * @author Callum Thompson
+ */
+QString LocalWhisperBackend::configuration() const
+{
+    QFileInfo model(modelPath);
+    return QString("%1;%2;%3;en").arg(model.fileName()).arg(model.size()).arg(model.lastModified().toSecsSinceEpoch());
+}
+
+/**
+ * @name capabilities
+ * @brief Returns the limits of local transcription
+ * @details Any length is accepted. Only one request runs at a time, since
+ * each already uses every core.
+ * @return Capabilities of the backend
+ * @author Callum Thompson
+ */
+BackendCapabilities LocalWhisperBackend::capabilities() const
+{
+    BackendCapabilities caps;
+    caps.requiresNetwork = false;
+    caps.acceptsFlac = true;
+    caps.requiresPcm16 = false;
+    caps.providesTimestamps = true;
+    caps.maxConcurrentRequests = 1;
+    return caps;
+}
+
+/**
+ * @name isAvailable
+ * @brief Returns whether the model and program are present
+ * @return True if local transcription can run
+ * @author Callum Thompson
+ */
+bool LocalWhisperBackend::isAvailable() const
+{
+    return !modelPath.isEmpty() && QFileInfo::exists(modelPath) && !resolveExecutable().isEmpty();
+}
+
+/**
+ * @name expectedLatencySecs
+ * @brief Estimates the time to transcribe audio of a given length
+ * @details Processing time scales with the number of cores available.
+ * @param[in] audioSecs: Length of the audio
+ * @return Expected seconds to produce the transcript
+ * @author Callum Thompson
+ */
+double LocalWhisperBackend::expectedLatencySecs(double audioSecs) const
+{
+    return modelLoadSecs + audioSecs * realTimeFactorPerCore / qMax(1, QThread::idealThreadCount());
+}
+
+/**
+ * @name start
+ * @brief Starts transcribing the audio in a whisper.cpp process
+ * @param[in] audioPath: Path to the audio file
+ * @param[in] flac: FLAC encoding of the audio file, or empty to read the WAV file
+ * @return Request in progress, or nullptr if it could not be started
+ * @author Callum Thompson
+ */
+TranscriptionRequest *LocalWhisperBackend::start(const QString &audioPath, const QByteArray &flac)
+{
+    QString program = resolveExecutable();
+    if (program.isEmpty() || modelPath.isEmpty())
+    {
+        qWarning() << "whisper.cpp is not configured";
+        return nullptr;
+    }
+
+    LocalTranscriptionRequest *request = new LocalTranscriptionRequest;
+    if (!request->begin(program, modelPath, audioPath, flac))
+    {
+        delete request;
+        return nullptr;
+    }
+    return request;
+}
+
+/**
+ * @name resolveExecutable
+ * @brief Finds the whisper.cpp program
+ * @return Path of the program, or an empty string if it cannot be found
+ * @author Callum Thompson
+ */
+QString LocalWhisperBackend::resolveExecutable() const
+{
+    if (!executable.isEmpty())
+    {
+        return QFileInfo(executable).isExecutable() ? executable : QString();
+    }
+    return QStandardPaths::findExecutable(defaultExecutable);
+}
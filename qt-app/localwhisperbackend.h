@@ -0,0 +1,45 @@
+/**
+ * @file localwhisperbackend.h
+ * @brief Declaration of LocalWhisperBackend class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#ifndef LOCALWHISPERBACKEND_H
+#define LOCALWHISPERBACKEND_H
+
+#include "transcriptionbackend.h"
+
+/**
+ * @class LocalWhisperBackend
+ * @brief Transcribes on this computer with whisper.cpp
+ * @details Runs the whisper.cpp command line program (`whisper-cli`) on a
+ * quantized GGML model using every CPU core. No audio leaves the computer,
+ * so transcription keeps working without a network connection and short
+ * recordings avoid the upload round trip. The backend is available once a
+ * model file has been configured and the program can be found.
+ * @author Callum Thompson
+ */
+class LocalWhisperBackend : public TranscriptionBackend
+{
+public:
+    LocalWhisperBackend() = default;
+
+    void setModel(const QString &executablePath, const QString &modelPath);
+
+    QString name() const override;
+    QString configuration() const override;
+    BackendCapabilities capabilities() const override;
+    bool isAvailable() const override;
+    double expectedLatencySecs(double audioSecs) const override;
+    TranscriptionRequest *start(const QString &audioPath, const QByteArray &flac) override;
+
+private:
+    QString executable;   // Path of whisper-cli, or empty to search PATH
+    QString modelPath;    // GGML model file, e.g. ggml-base.en-q5_1.bin
+
+    QString resolveExecutable() const;
+};
+
+#endif // LOCALWHISPERBACKEND_H
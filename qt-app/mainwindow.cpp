@@ -53,6 +53,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Connect the signal to process the generated summary when ready
     connect(summaryGenerator, &SummaryGenerator::summaryReady, this, &MainWindow::handleSummaryReady);
+    connect(summaryGenerator, &SummaryGenerator::sectionCompleted, this, &MainWindow::handleSummarySectionCompleted);
 
     // Configure API handlers
     AudioHandler *audioHandler = AudioHandler::getInstance();
@@ -99,59 +100,27 @@ MainWindow::MainWindow(QWidget *parent)
         optionDetailedLayout->setEnabled(false);
     }
 
-    // Connect "Record" button to start and stop recording
-    connect(btnRecord, &QPushButton::clicked, this, [audioHandler, this]()
+    // Connect "Record" button to start and stop recording a visit
+    visitQueue = new VisitQueue(this);
+    connect(btnRecord, &QPushButton::clicked, this, [this]()
     {
-        static bool isRecording = false;
-        if (isRecording) {  // If currently recording and button is pressed, stop recording
-            audioHandler->stopRecording();
-
-            QString projectDir = QDir(QCoreApplication::applicationDirPath()).absolutePath();
-            QString filePath = QDir(projectDir).filePath("output.wav");
-
+        if (visitQueue->isRecording()) {  // If currently recording and button is pressed, stop recording
+            // The visit is transcribed, saved and summarized in the background; only
+            // wait for the recording to be finalized before the next visit can start
+            visitQueue->stopVisit();
+            btnRecord->setEnabled(false);
+        }
+        else { // If not recording and button is pressed, start recording
             // If a patient is not selected to record for, do not let the user do this
             QVariant patientData = comboSelectPatient->currentData();
             if (!patientData.isValid()) {
                 QMessageBox::warning(this, "No Patient Selected", "Please select a patient before recording.");
                 return;
             }
-            int selectedPatientID = patientData.toInt();
-            patientID = selectedPatientID;
-
-            // Display non-modal loading dialog
-            loadingDialog->setModal(false);  // Temporarily change loading dialog to be non-modal
-            loadingDialog->show();
-
-            Transcript currentTranscription = audioHandler->transcribe(filePath);
-
-            //  Overwrite 'transcript_raw.txt' for summarizer
-            FileHandler::getInstance()->saveTranscript(selectedPatientID, currentTranscription.getContent());
-
-            //  Append to timestamped raw log
-            FileHandler::getInstance()->saveOrAppendRawTranscript(selectedPatientID, currentTranscription);
-
-            btnRecord->setText("Start Recording");
-
-            // Re-enable ADD, DELETE, ARCHIVE, SUMMARIZE, VIEW ARCHIVED
-            // PATIENTS, SETTINGS, SELECT PATIENT buttons
-            btnAddPatient->setEnabled(true);
-            btnDeletePatient->setEnabled(false);
-            btnArchivePatient->setEnabled(false);
-            btnSummarize->setEnabled(true);
-            toggleSwitch->setEnabled(true);
-            btnSettings->setEnabled(true);
-            comboSelectPatient->setEnabled(true);
-            btnAddPatient->setStyleSheet(WindowBuilder::blueButtonStyle);
-            btnDeletePatient->setStyleSheet(WindowBuilder::redButtonStyle);
-            btnArchivePatient->setStyleSheet(WindowBuilder::orangeButtonStyle);
-            btnSummarize->setStyleSheet(WindowBuilder::orangeButtonStyle);
-            toggleSwitch->setStyleSheet(WindowBuilder::blueButtonStyle);
-
-            loadingDialog->hide(); // Hide loading dialog after recording is finished
-            loadingDialog->setModal(true);  // Set loading dialog as modal for next use
-        }
-        else { // If not recording and button is pressed, start recording
-            audioHandler->startRecording("output.wav");
+            if (!visitQueue->startVisit(patientData.toInt())) {
+                QMessageBox::warning(this, "Recording Failed", "Could not start recording. Please check that a microphone is connected.");
+                return;
+            }
             btnRecord->setText("Stop Recording");
 
             // Disable ADD, DELETE, ARCHIVE, SUMMARIZE, VIEW ARCHIVED
@@ -169,12 +138,35 @@ MainWindow::MainWindow(QWidget *parent)
             btnSummarize->setStyleSheet(WindowBuilder::disabledButtonStyle);
             toggleSwitch->setStyleSheet(WindowBuilder::disabledButtonStyle);
         }
-        isRecording = !isRecording; // Toggle recording mode
     });
-
-    // Connect mainWindow functions to their associated actions
-    connect(audioHandler, &AudioHandler::transcriptionCompleted, this, &MainWindow::handleSummarizeButtonClicked);
-    connect(llmClient, &LLMClient::responseReceived, this, &MainWindow::handleLLMResponse);
+    connect(visitQueue, &VisitQueue::recordingStopped, this, &MainWindow::handleRecordingStopped);
+    connect(visitQueue, &VisitQueue::visitTranscribed, this, &MainWindow::handleVisitTranscribed);
+    connect(visitQueue, &VisitQueue::transcriptionFailed, this, [this](int patientID, const QString &errorMessage)
+    {
+        QMessageBox::warning(this, "Transcription Failed",
+                             QString("The visit of patient %1 could not be transcribed: %2. "
+                                     "The saved transcript was left unchanged.").arg(patientID).arg(errorMessage));
+    });
+    connect(visitQueue, &VisitQueue::summaryReady, this, &MainWindow::handleVisitSummarized);
+    connect(visitQueue, &VisitQueue::summaryProgress, this, [this](int patientID, const QString &textSoFar)
+    {
+        if (comboSelectPatient->currentData().toInt() == patientID)
+        {
+            summaryGenerator->setPartialSummaryText(textSoFar);
+        }
+    });
+    connect(visitQueue, &VisitQueue::summaryFailed, this, [this](int patientID)
+    {
+        if (comboSelectPatient->currentData().toInt() == patientID)
+        {
+            loadingDialog->hide();
+            if (summaryInProgress)
+            {
+                summaryInProgress = false; // Show what was generated as it stands
+                displaySummary(summaryGenerator->getSummary());
+            }
+        }
+    });
 
     // Connect mainWindow buttons to their associated actions
     connect(btnAddPatient, &QPushButton::clicked, this, &MainWindow::on_addPatientButton_clicked);
@@ -244,43 +236,74 @@ void MainWindow::endLoading(QNetworkReply *reply) {
 }
 
 /**
- * @name handleLLMResponse
- * @brief Handler function called when the LLM returns a response
- * @details Sets the plan text transcription displayed in the main window and
- * saves the transcript to a file.
- * @param[in] response: Response returned by the LLM
+ * @name handleRecordingStopped
+ * @brief Handler function called when the recording of a visit has been finalized
+ * @details Restores the UI so the next patient can be selected and recorded
+ * while the stopped visit is transcribed and summarized in the background.
+ * @author Andres Pedreros Castro
  * @author Callum Thompson
  */
-void MainWindow::handleLLMResponse(const QString &response)
+void MainWindow::handleRecordingStopped()
 {
-    // Get selected patient ID
-    QVariant patientData = comboSelectPatient->currentData();
-    if (!patientData.isValid())
+    btnRecord->setText("Start Recording");
+    btnRecord->setEnabled(true);
+
+    // Re-enable ADD, DELETE, ARCHIVE, SUMMARIZE, VIEW ARCHIVED
+    // PATIENTS, SETTINGS, SELECT PATIENT buttons
+    btnAddPatient->setEnabled(true);
+    btnDeletePatient->setEnabled(false);
+    btnArchivePatient->setEnabled(false);
+    btnSummarize->setEnabled(true);
+    toggleSwitch->setEnabled(true);
+    btnSettings->setEnabled(true);
+    comboSelectPatient->setEnabled(true);
+    btnAddPatient->setStyleSheet(WindowBuilder::blueButtonStyle);
+    btnDeletePatient->setStyleSheet(WindowBuilder::redButtonStyle);
+    btnArchivePatient->setStyleSheet(WindowBuilder::orangeButtonStyle);
+    btnSummarize->setStyleSheet(WindowBuilder::orangeButtonStyle);
+    toggleSwitch->setStyleSheet(WindowBuilder::blueButtonStyle);
+}
+
+/**
+ * @name handleVisitTranscribed
+ * @brief Handler function called when the transcript of a visit has been saved
+ * @details Refreshes the plain text transcript if the patient is displayed.
+ * @param[in] patientID: Patient the visit was recorded for
+ * @author Callum Thompson
+ */
+void MainWindow::handleVisitTranscribed(int patientID)
+{
+    if (comboSelectPatient->currentData().toInt() == patientID)
     {
-        qWarning() << "No patient selected, cannot save transcript!";
-        return;
+        currentTranscriptText = FileHandler::getInstance()->loadTranscript(patientID).trimmed();
     }
-    int patientID = patientData.toInt(); // Get patient ID
+}
 
-    // Ensure the patient's folder exists
-    QDir patientDir("Patients/" + QString::number(patientID));
-    if (!patientDir.exists())
+/**
+ * @name handleVisitSummarized
+ * @brief Handler function called when the summary of a patient has been saved
+ * @details Displays the summary if the patient is still selected; otherwise
+ * it is shown the next time the patient is selected. The summary is read
+ * from the record VisitQueue saved, and parsed only if there is none.
+ * @param[in] patientID: Patient the summary was generated for
+ * @param[in] summaryText: Response returned by the LLM
+ * @author Callum Thompson
+ */
+void MainWindow::handleVisitSummarized(int patientID, const QString &summaryText)
+{
+    if (comboSelectPatient->currentData().toInt() != patientID)
     {
-        patientDir.mkpath(".");
+        return;
     }
 
-    // Save the transcript to file
-    QString transcriptPath = patientDir.filePath("summary.txt");
-    QFile file(transcriptPath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+    Summary savedSummary;
+    if (FileHandler::getInstance()->loadSummaryRecord(patientID, savedSummary))
     {
-        QTextStream out(&file);
-        out << response;
-        file.close();
+        summaryGenerator->setSummary(savedSummary);
     }
     else
     {
-        qInfo() << "Failed to save transcript!";
+        summaryGenerator->setSummaryText(summaryText);
     }
 }
 
@@ -345,7 +368,9 @@ void MainWindow::handleSummaryLayoutChanged(SummaryFormatter *summaryFormatter)
 /**
  * @name handleSummarizeButtonClicked
  * @brief Handler function called when summarize button is clicked
- * @details Starts a new summary generation process via the LLM client.
+ * @details Queues a new summary generation for the selected patient. A
+ * stored summary of the same transcript is reused unless the button is
+ * regenerating the displayed one.
  * @author Callum Thompson
  */
 void MainWindow::handleSummarizeButtonClicked()
@@ -359,76 +384,54 @@ void MainWindow::handleSummarizeButtonClicked()
     }
     int patientID = patientData.toInt();
 
-    // Construct file path for the transcript
-    QString transcriptPath = "Patients/" + QString::number(patientID) + "/transcript_raw.txt";
-
-    // Open and read the transcript
-    QFile file(transcriptPath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    // Read the saved transcript
+    currentTranscriptText = FileHandler::getInstance()->loadTranscript(patientID).trimmed();
+    if (currentTranscriptText.isEmpty())
     {
         qWarning() << "Failed to open transcript. Request aborted.";
         return;
     }
 
-    currentTranscriptText = QTextStream(&file).readAll().trimmed();
-    file.close();
-
-    // Create a transcript object
-    Transcript *transcript = new Transcript(QTime::currentTime(), currentTranscriptText);
-
     loadingDialog->show();
 
-    // Send transcript to the LLM
-    summaryGenerator->sendRequest(*transcript);
-
+    // A displayed summary is regenerated rather than returned from the cache
+    visitQueue->summarize(patientID, hasSavedSummary);
 }
 
 /**
  * @name handleSummaryReady
- * @brief Processes and displays the structured summary after LLM response
- * @details Hides the loading dialog, retrieves the summary from the
- * SummaryGenerator, and saves it to a file.
+ * @brief Displays the structured summary after LLM response
+ * @details Hides the loading dialog and retrieves the summary from the
+ * SummaryGenerator. The summary has already been saved by VisitQueue for the
+ * patient it was generated for.
  * @author Callum Thompson
  * @author Kalundi Serumaga
  */
 void MainWindow::handleSummaryReady()
 {
     loadingDialog->hide(); // Hide loading dialog once summary is ready
+    summaryInProgress = false;
 
     // Retrieve structured summary from SummaryGenerator
     Summary summary = summaryGenerator->getSummary();
 
-    // Get selected patient ID
-    QVariant patientData = comboSelectPatient->currentData();
-    if (!patientData.isValid())
-    {
-        qWarning() << "No patient selected, cannot save summary!";
-        return;
-    }
-    int patientID = patientData.toInt();
-
-    // Construct summary file path
-    QString summaryPath = "Patients/" + QString::number(patientID) + "/summary.txt";
-
-    // Save summary to file
-    QFile file(summaryPath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        QTextStream out(&file);
-        out << summary.getText();
-        file.close();
-    }
-    else
-    {
-        qInfo() << "Failed to save summary!";
-    }
-
     // Update the UI with the summary
     displaySummary(summary);
+    hasSavedSummary = true;
     btnSummarize->setText("Regenerate Summary");
+}
 
-    //  Ensure transcript_raw.txt is restored with actual transcript (not summary)
-
+/**
+ * @name handleSummarySectionCompleted
+ * @brief Displays a summary while its later sections are still being generated
+ * @details Hides the loading dialog as soon as the first section is complete.
+ * @author Callum Thompson
+ */
+void MainWindow::handleSummarySectionCompleted()
+{
+    loadingDialog->hide();
+    summaryInProgress = true;
+    displaySummary(summaryGenerator->getSummary());
 }
 
 /**
@@ -514,6 +517,7 @@ void MainWindow::setSummaryFormatter(SummaryFormatter *newSummaryFormatter)
  * @name displaySummary
  * @brief Display summary using the configured layout
  * @details Uses the summaryFormatter to generate the layout for the summary. 
+ * Empty sections are shown as pending only while a summary is streamed.
  * @param[in] summary: Summary to display
  * @author Joelene Hales
  * @author Callum Thompson
@@ -525,6 +529,7 @@ void MainWindow::displaySummary(const Summary &summary)
         return;
     }
 
+    summaryFormatter->setGenerating(summaryInProgress);
     summaryFormatter->generateLayout(summary, summarySection);
 }
 
@@ -867,6 +872,7 @@ void MainWindow::on_patientSelected(int index)
         return;
 
     patientID = comboSelectPatient->currentData().toInt();
+    summaryInProgress = false;
 
     viewPatient(); // Update current patient information section
 
@@ -881,8 +887,11 @@ void MainWindow::on_patientSelected(int index)
         currentTranscriptText.clear();
     }
 
-    // Load the structured summary according to default summary layout preference
-    QString savedSummaryText = FileHandler::getInstance()->loadSummaryText(patientID);
+    // Load the structured summary according to default summary layout preference.
+    // Summaries saved before records were kept are parsed from their text.
+    Summary savedSummary;
+    bool hasSummaryRecord = FileHandler::getInstance()->loadSummaryRecord(patientID, savedSummary);
+    QString savedSummaryText = hasSummaryRecord ? QString() : FileHandler::getInstance()->loadSummaryText(patientID);
 
     QString defaultLayout = settings->getSummaryPreference();
 
@@ -922,13 +931,22 @@ void MainWindow::on_patientSelected(int index)
         layoutAction->setEnabled(layoutAction->text() != currentLayout);
     }
 
-    if (!savedSummaryText.isEmpty())
+    if (hasSummaryRecord || !savedSummaryText.isEmpty())
     {
-        summaryGenerator->setSummaryText(savedSummaryText);
+        if (hasSummaryRecord)
+        {
+            summaryGenerator->setSummary(savedSummary);
+        }
+        else
+        {
+            summaryGenerator->setSummaryText(savedSummaryText);
+            FileHandler::getInstance()->saveSummaryRecord(patientID, summaryGenerator->getSummary(), QString(), QString());
+        }
 
         Summary summary = summaryGenerator->getSummary();
 
         displaySummary(summary);
+        hasSavedSummary = true;
         btnSummarize->setText("Regenerate Summary");
     }
     else
@@ -943,6 +961,7 @@ void MainWindow::on_patientSelected(int index)
             }
             delete child; // Free the layout item
         }
+        hasSavedSummary = false;
         btnSummarize->setText("Summarize");
     }
 }
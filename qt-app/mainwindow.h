@@ -37,6 +37,7 @@
 #include "summaryformatter.h"
 #include "summarygenerator.h"
 #include "settings.h"
+#include "visitqueue.h"
 
 /**
  * @class MainWindow
@@ -96,8 +97,11 @@ private:
     // Summarization
     SummaryFormatter *summaryFormatter;
     SummaryGenerator *summaryGenerator;
+    VisitQueue *visitQueue; // Transcribes and summarizes recorded visits in the background
 
     QString currentTranscriptText;
+    bool summaryInProgress = false; // The displayed summary is still being streamed
+    bool hasSavedSummary = false;   // The selected patient has a summary, so summarizing regenerates it
 
     int patientID;
     bool archiveMode;
@@ -108,11 +112,15 @@ private slots:
     void handleSummaryLayoutChanged(SummaryFormatter *summaryFormatter);
     void handleSummarizeButtonClicked();
     void handleSummaryReady();
+    void handleSummarySectionCompleted();
     void on_addPatientButton_clicked();
     void on_editPatientButton_clicked();
     void handleArchiveToggled();
     void checkDropdownEmpty();
     void endLoading(QNetworkReply *reply);
+    void handleRecordingStopped();
+    void handleVisitTranscribed(int patientID);
+    void handleVisitSummarized(int patientID, const QString &summaryText);
 
 public slots:
     void on_patientSelected(int index);
@@ -120,7 +128,6 @@ public slots:
     void on_archivePatientButton_clicked();
     bool loadPatientsIntoDropdown();
     bool loadArchivedPatientsIntoDropdown();
-    void handleLLMResponse(const QString &response);
 };
 
 #endif // MAINWINDOW_H
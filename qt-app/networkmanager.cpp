@@ -0,0 +1,272 @@
+/**
+ * @file networkmanager.cpp
+ * @brief Definition of NetworkManager class
+ *
+ * Shared connection pool, connection prewarming and setup timing.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 24, 2025
+ */
+
+#include <QDateTime>
+#include <QDebug>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+#include "networkmanager.h"
+
+NetworkManager *NetworkManager::instance = nullptr;
+
+namespace
+{
+const int keepAliveIntervalMs = 60 * 1000;       // How often idle connections are reopened
+const qint64 keepAliveIdleMs = 30 * 60 * 1000;   // Stop keeping connections open after this long unused
+}
+
+/**
+ * @name NetworkManager (constructor)
+ * @brief Creates the shared network access manager
+ * @author Callum Thompson
+ */
+NetworkManager::NetworkManager()
+    : QObject(nullptr), accessManager(new QNetworkAccessManager(this))
+{
+    keepAliveTimer.setInterval(keepAliveIntervalMs);
+    connect(&keepAliveTimer, &QTimer::timeout, this, &NetworkManager::keepAlive);
+}
+
+/**
+ * @name getInstance
+ * @brief Returns the singleton instance of NetworkManager
+ * @return Singleton instance of NetworkManager
+ * @author Callum Thompson
+ */
+NetworkManager *NetworkManager::getInstance()
+{
+    if (!instance)
+    {
+        instance = new NetworkManager();
+    }
+    return instance;
+}
+
+/**
+ * @name post
+ * @brief Sends a POST request over the shared connections
+ * @param[in] request: Request to send
+ * @param[in] body: Body, read while uploading
+ * @return Reply, owned by the caller
+ * @author Callum Thompson
+ */
+QNetworkReply *NetworkManager::post(const QNetworkRequest &request, QIODevice *body)
+{
+    return track(accessManager->post(prepare(request), body));
+}
+
+/**
+ * @name post
+ * @brief Sends a POST request over the shared connections
+ * @param[in] request: Request to send
+ * @param[in] body: Body
+ * @return Reply, owned by the caller
+ * @author Callum Thompson
+ */
+QNetworkReply *NetworkManager::post(const QNetworkRequest &request, const QByteArray &body)
+{
+    return track(accessManager->post(prepare(request), body));
+}
+
+/**
+ * @name post
+ * @brief Sends a multipart POST request over the shared connections
+ * @param[in] request: Request to send
+ * @param[in] body: Multipart body
+ * @return Reply, owned by the caller
+ * @author Callum Thompson
+ */
+QNetworkReply *NetworkManager::post(const QNetworkRequest &request, QHttpMultiPart *body)
+{
+    return track(accessManager->post(prepare(request), body));
+}
+
+/**
+ * @name addHost
+ * @brief Registers a host that requests will be sent to
+ * @details Connections to the host are opened once control returns to the
+ * event loop, together with any other host registered meanwhile.
+ * @param[in] url: Any address on the host
+ * @author Callum Thompson
+ */
+void NetworkManager::addHost(const QUrl &url)
+{
+    if (!url.isValid() || url.host().isEmpty())
+    {
+        return;
+    }
+
+    QUrl origin;
+    origin.setScheme(url.scheme());
+    origin.setHost(url.host());
+    origin.setPort(url.port());
+    if (hosts.contains(origin))
+    {
+        return;
+    }
+    hosts.append(origin);
+
+    if (!prewarmScheduled)
+    {
+        prewarmScheduled = true;
+        QTimer::singleShot(0, this, &NetworkManager::prewarm);
+    }
+}
+
+/**
+ * @name prewarm
+ * @brief Opens connections to every registered host
+ * @details Hosts already connected keep their connection. The connections
+ * are then kept open while requests continue to be made.
+ * @author Callum Thompson
+ */
+void NetworkManager::prewarm()
+{
+    prewarmScheduled = false;
+    lastActivity = QDateTime::currentMSecsSinceEpoch();
+    for (const QUrl &host : std::as_const(hosts))
+    {
+        connectToHost(host);
+    }
+    if (!keepAliveTimer.isActive())
+    {
+        keepAliveTimer.start();
+    }
+}
+
+/**
+ * @name statistics
+ * @brief Returns how often requests to a host opened a new connection
+ * @param[in] host: Host name
+ * @return Statistics of the host's requests so far
+ * @author Callum Thompson
+ */
+NetworkManager::Statistics NetworkManager::statistics(const QString &host) const
+{
+    return hostStatistics.value(host);
+}
+
+/**
+ * @name prepare
+ * @brief Allows a request to share an HTTP/2 connection
+ * @param[in] request: Request as built by the client
+ * @return Request to send
+ * @author Callum Thompson
+ */
+QNetworkRequest NetworkManager::prepare(const QNetworkRequest &request)
+{
+    QNetworkRequest prepared(request);
+    prepared.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    return prepared;
+}
+
+/**
+ * @name track
+ * @brief Records when a request opens a connection
+ * @details A reply that reuses a connection never starts connecting.
+ * @param[in] reply: Reply of a request just sent
+ * @return The reply
+ * @author Callum Thompson
+ */
+QNetworkReply *NetworkManager::track(QNetworkReply *reply)
+{
+    lastActivity = QDateTime::currentMSecsSinceEpoch();
+    if (!keepAliveTimer.isActive())
+    {
+        keepAliveTimer.start();
+    }
+
+    timings[reply].sentAt = lastActivity;
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [this, reply]()
+            { timings[reply].connectingAt = QDateTime::currentMSecsSinceEpoch(); });
+    connect(reply, &QNetworkReply::encrypted, this, [this, reply]()
+            { timings[reply].connectedAt = QDateTime::currentMSecsSinceEpoch(); });
+    connect(reply, &QNetworkReply::requestSent, this, [this, reply]()
+            {
+                // Plain connections are ready once the request goes out
+                ReplyTiming &timing = timings[reply];
+                if (timing.connectingAt != -1 && timing.connectedAt == -1)
+                {
+                    timing.connectedAt = QDateTime::currentMSecsSinceEpoch();
+                }
+            });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]()
+            { handleFinished(reply); });
+    return reply;
+}
+
+/**
+ * @name handleFinished
+ * @brief Logs the connection setup time of a finished request
+ * @param[in] reply: Finished reply
+ * @author Callum Thompson
+ */
+void NetworkManager::handleFinished(QNetworkReply *reply)
+{
+    ReplyTiming timing = timings.take(reply);
+    QString host = reply->url().host();
+    Statistics &stats = hostStatistics[host];
+    ++stats.requests;
+
+    QString connection = "reused a connection";
+    if (timing.connectingAt != -1)
+    {
+        qint64 connectedAt = timing.connectedAt != -1 ? timing.connectedAt : QDateTime::currentMSecsSinceEpoch();
+        qint64 setupMs = connectedAt - timing.connectingAt;
+        ++stats.newConnections;
+        stats.setupMs += setupMs;
+        connection = QString("opened a connection in %1 ms").arg(setupMs);
+    }
+    bool http2 = reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+    qInfo().noquote() << "Request to" << host << connection << (http2 ? "over HTTP/2;" : "over HTTP/1.1;")
+                      << stats.newConnections << "of" << stats.requests << "requests opened one, averaging"
+                      << (stats.newConnections > 0 ? stats.setupMs / stats.newConnections : 0) << "ms";
+}
+
+/**
+ * @name connectToHost
+ * @brief Opens a connection to a host, offering HTTP/2
+ * @param[in] host: Scheme, host and port
+ * @author Callum Thompson
+ */
+void NetworkManager::connectToHost(const QUrl &host)
+{
+    if (host.scheme() == "https")
+    {
+#if QT_CONFIG(ssl)
+        QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+        ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+        accessManager->connectToHostEncrypted(host.host(), host.port(443), ssl);
+#endif
+        return;
+    }
+    accessManager->connectToHost(host.host(), host.port(80));
+}
+
+/**
+ * @name keepAlive
+ * @brief Reopens connections the servers have closed
+ * @details Stops once no request has been made for a while; the next
+ * recording or request starts it again.
+ * @author Callum Thompson
+ */
+void NetworkManager::keepAlive()
+{
+    if (QDateTime::currentMSecsSinceEpoch() - lastActivity > keepAliveIdleMs)
+    {
+        keepAliveTimer.stop();
+        return;
+    }
+    for (const QUrl &host : std::as_const(hosts))
+    {
+        connectToHost(host);
+    }
+}
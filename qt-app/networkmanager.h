@@ -0,0 +1,93 @@
+/**
+ * @file networkmanager.h
+ * @brief Declaration of NetworkManager class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 24, 2025
+ */
+
+#ifndef NETWORKMANAGER_H
+#define NETWORKMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QUrl>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+#include <QtNetwork/QHttpMultiPart>
+
+/**
+ * @class NetworkManager
+ * @brief Connection pool shared by every API client
+ * @details Transcription and summary requests are sent through one
+ * QNetworkAccessManager, so requests to the same host share its connections
+ * and run concurrently as streams of one HTTP/2 connection. Connections to
+ * the hosts the clients use are opened ahead of time, at startup and when a
+ * recording starts, so the first request after a pause does not wait for
+ * DNS, TCP and TLS. While requests are being made, the connections are
+ * reopened periodically in case the server closed them. The time each
+ * request spent setting up a connection is logged.
+ * @author Callum Thompson
+ */
+class NetworkManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @struct Statistics
+     * @brief Connection reuse of the requests to one host
+     */
+    struct Statistics
+    {
+        int requests = 0;       // Requests sent
+        int newConnections = 0; // Requests that had to open a connection
+        qint64 setupMs = 0;     // Total time spent opening connections
+    };
+
+    static NetworkManager *getInstance();
+
+    QNetworkReply *post(const QNetworkRequest &request, QIODevice *body);
+    QNetworkReply *post(const QNetworkRequest &request, const QByteArray &body);
+    QNetworkReply *post(const QNetworkRequest &request, QHttpMultiPart *body);
+
+    void addHost(const QUrl &url);
+    void prewarm();
+    Statistics statistics(const QString &host) const;
+
+private:
+    /**
+     * @struct ReplyTiming
+     * @brief Progress of a request through connection setup
+     */
+    struct ReplyTiming
+    {
+        qint64 sentAt = 0;        // Milliseconds since epoch when queued
+        qint64 connectingAt = -1; // When a new connection started, if one was needed
+        qint64 connectedAt = -1;  // When the new connection was ready
+    };
+
+    static NetworkManager *instance; // Singleton instance
+    explicit NetworkManager();
+    NetworkManager(const NetworkManager &) = delete;
+    NetworkManager &operator=(const NetworkManager &) = delete;
+
+    QNetworkAccessManager *accessManager;
+    QList<QUrl> hosts;                      // Scheme, host and port of each API
+    QHash<QNetworkReply *, ReplyTiming> timings; // Requests in flight
+    QHash<QString, Statistics> hostStatistics;
+    QTimer keepAliveTimer;
+    qint64 lastActivity = 0;                // Milliseconds since epoch of the last request or prewarm
+    bool prewarmScheduled = false;
+
+    static QNetworkRequest prepare(const QNetworkRequest &request);
+    QNetworkReply *track(QNetworkReply *reply);
+    void handleFinished(QNetworkReply *reply);
+    void connectToHost(const QUrl &host);
+    void keepAlive();
+};
+
+#endif // NETWORKMANAGER_H
@@ -0,0 +1,87 @@
+/**
+ * @file notesections.h
+ * @brief Declaration of the sections of a summary note
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 26, 2025
+ */
+
+#ifndef NOTESECTIONS_H
+#define NOTESECTIONS_H
+
+#include <QString>
+#include <QStringView>
+#include <iterator>
+
+/**
+ * @namespace NoteSections
+ * @brief Sections and subsections of the note the LLM writes
+ * @details A compile-time table following the structure in llmprompt.txt.
+ * Section titles are written in bold in a markdown note; subsections start
+ * a line with their title and a colon.
+ * @author Callum Thompson
+ */
+namespace NoteSections
+{
+/**
+ * @enum Section
+ * @brief Sections of a note, in the order they are written
+ */
+enum Section
+{
+    IntervalHistory,
+    PhysicalExamination,
+    CurrentStatus,
+    Plan,
+    FollowUpNote,
+    Count
+};
+
+/**
+ * @struct Schema
+ * @brief Title and subsection titles of a section
+ */
+struct Schema
+{
+    QStringView title;
+    const QStringView *subsections; // Titles of the subsections, in order
+    int subsectionCount;
+};
+
+inline constexpr QStringView intervalHistorySubsections[] = {
+    u"GENERAL", u"ARTHRITIS", u"CARDIAC", u"RESPIRATORY", u"OCULAR", u"GASTROINTESTINAL",
+    u"GLANDULAR ENLARGEMENT", u"SKIN", u"CNS", u"CANCER", u"MEDICATIONS", u"BLOODWORK", u"SEROLOGY",
+    u"IMAGING", u"INFECTION", u"HEALTH CHANGES", u"LIFE CHANGES", u"BONE HEALTH", u"LIVING/FAMILY SITUATION",
+    u"WORK/EDUCATION"};
+inline constexpr QStringView physicalExaminationSubsections[] = {
+    u"VITAL SIGNS", u"HEAD & NECK", u"SKIN", u"CARDIAC", u"RESPIRATORY", u"ABDOMEN", u"NEUROLOGIC",
+    u"JOINT EXAM"};
+inline constexpr QStringView currentStatusSubsections[] = {u"CLINICAL IMPRESSION"};
+inline constexpr QStringView planSubsections[] = {u"TREATMENT", u"PATIENT EDUCATION", u"FOLLOW-UP"};
+
+inline constexpr Schema schema[Count] = {
+    {u"INTERVAL HISTORY", intervalHistorySubsections, int(std::size(intervalHistorySubsections))},
+    {u"PHYSICAL EXAMINATION", physicalExaminationSubsections, int(std::size(physicalExaminationSubsections))},
+    {u"CURRENT STATUS", currentStatusSubsections, int(std::size(currentStatusSubsections))},
+    {u"PLAN", planSubsections, int(std::size(planSubsections))},
+    {u"PATIENT FOLLOW-UP NOTE", nullptr, 0}};
+
+/**
+ * @brief Returns the title of a section, e.g. "PLAN"
+ */
+constexpr QStringView title(Section section)
+{
+    return schema[section].title;
+}
+
+/**
+ * @brief Returns the text shown for a section missing from a note, e.g.
+ * "No plan found."
+ */
+inline QString notFoundText(Section section)
+{
+    return "No " + title(section).toString().toLower() + " found.";
+}
+}
+
+#endif // NOTESECTIONS_H
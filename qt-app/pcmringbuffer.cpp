@@ -0,0 +1,137 @@
+/**
+ * @file pcmringbuffer.cpp
+ * @brief Definition of PcmRingBuffer class
+ *
+ * The producer and consumer each own one position counter. Positions only
+ * grow, so the fill level is their difference and no slot is wasted to
+ * tell a full buffer from an empty one.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 10, 2025
+ */
+
+#include <algorithm>
+#include "pcmringbuffer.h"
+
+/**
+ * @name PcmRingBuffer (constructor)
+ * @brief Allocates the buffer
+ * @param[in] minimumCapacity: Samples the buffer must hold, rounded up to a power of two
+ * @author Callum Thompson
+ */
+PcmRingBuffer::PcmRingBuffer(qint64 minimumCapacity)
+{
+    qint64 size = 1024;
+    while (size < minimumCapacity)
+    {
+        size *= 2;
+    }
+    buffer.resize(size);
+    mask = size - 1;
+}
+
+/**
+ * @name write
+ * @brief Appends samples to the buffer
+ * @details Called only by the producer. If the samples do not all fit, none
+ * are written, so the consumer never sees a partial frame.
+ * @param[in] samples: Samples to append
+ * @param[in] count: Number of samples
+ * @return True if the samples were written, false if they were dropped
+ * @author Callum Thompson
+ */
+bool PcmRingBuffer::write(const qint16 *samples, qint64 count)
+{
+    qint64 head = writePosition.load(std::memory_order_relaxed);
+    qint64 tail = readPosition.load(std::memory_order_acquire);
+    qint64 used = head - tail;
+    if (count > buffer.size() - used)
+    {
+        dropped.fetch_add(count, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Copy in up to two pieces around the end of the buffer
+    qint64 start = head & mask;
+    qint64 first = std::min<qint64>(count, buffer.size() - start);
+    std::copy(samples, samples + first, buffer.data() + start);
+    std::copy(samples + first, samples + count, buffer.data());
+    writePosition.store(head + count, std::memory_order_release);
+
+    if (used + count > highWater.load(std::memory_order_relaxed))
+    {
+        highWater.store(used + count, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * @name read
+ * @brief Removes samples from the buffer
+ * @details Called only by the consumer.
+ * @param[out] samples: Receives the samples
+ * @param[in] maximum: Largest number of samples to read
+ * @return Number of samples read
+ * @author Callum Thompson
+ */
+qint64 PcmRingBuffer::read(qint16 *samples, qint64 maximum)
+{
+    qint64 tail = readPosition.load(std::memory_order_relaxed);
+    qint64 head = writePosition.load(std::memory_order_acquire);
+    qint64 count = std::min<qint64>(maximum, head - tail);
+    if (count <= 0)
+    {
+        return 0;
+    }
+
+    qint64 start = tail & mask;
+    qint64 first = std::min<qint64>(count, buffer.size() - start);
+    std::copy(buffer.constData() + start, buffer.constData() + start + first, samples);
+    std::copy(buffer.constData(), buffer.constData() + (count - first), samples + first);
+    readPosition.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+/**
+ * @name available
+ * @brief Returns the number of samples waiting to be read
+ * @return Samples in the buffer
+ * @author Callum Thompson
+ */
+qint64 PcmRingBuffer::available() const
+{
+    return writePosition.load(std::memory_order_acquire) - readPosition.load(std::memory_order_acquire);
+}
+
+/**
+ * @name capacity
+ * @brief Returns the number of samples the buffer holds
+ * @return Capacity in samples
+ * @author Callum Thompson
+ */
+qint64 PcmRingBuffer::capacity() const
+{
+    return buffer.size();
+}
+
+/**
+ * @name droppedSamples
+ * @brief Returns the number of samples discarded because the buffer was full
+ * @return Dropped samples since construction
+ * @author Callum Thompson
+ */
+qint64 PcmRingBuffer::droppedSamples() const
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * @name highWaterMark
+ * @brief Returns the highest fill level the buffer has reached
+ * @return Largest number of samples held at once
+ * @author Callum Thompson
+ */
+qint64 PcmRingBuffer::highWaterMark() const
+{
+    return highWater.load(std::memory_order_relaxed);
+}
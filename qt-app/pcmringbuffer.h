@@ -0,0 +1,48 @@
+/**
+ * @file pcmringbuffer.h
+ * @brief Declaration of PcmRingBuffer class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 10, 2025
+ */
+
+#ifndef PCMRINGBUFFER_H
+#define PCMRINGBUFFER_H
+
+#include <atomic>
+#include <QVector>
+
+/**
+ * @class PcmRingBuffer
+ * @brief Lock-free single-producer, single-consumer queue of 16-bit samples
+ * @details Hands audio from the capture callback to the processing thread.
+ * Writing never blocks or allocates: a block that does not fit is dropped
+ * whole and counted, so a stalled consumer costs audio but never stalls
+ * capture. Exactly one thread may write and one other thread may read.
+ * The fill level reached is tracked so the buffer can be sized from
+ * real sessions.
+ * @author Callum Thompson
+ */
+class PcmRingBuffer
+{
+public:
+    explicit PcmRingBuffer(qint64 minimumCapacity);
+
+    bool write(const qint16 *samples, qint64 count);
+    qint64 read(qint16 *samples, qint64 maximum);
+
+    qint64 available() const;
+    qint64 capacity() const;
+    qint64 droppedSamples() const;
+    qint64 highWaterMark() const;
+
+private:
+    QVector<qint16> buffer;
+    qint64 mask;                            // Capacity - 1, capacity being a power of two
+    alignas(64) std::atomic<qint64> writePosition{0}; // Samples ever written, advanced by the producer
+    alignas(64) std::atomic<qint64> readPosition{0};  // Samples ever read, advanced by the consumer
+    alignas(64) std::atomic<qint64> dropped{0};       // Samples discarded because the buffer was full
+    std::atomic<qint64> highWater{0};                 // Largest fill level seen by the producer
+};
+
+#endif // PCMRINGBUFFER_H
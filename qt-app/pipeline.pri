@@ -0,0 +1,80 @@
+# Recording, transcription and summarization pipeline without any user
+# interface. Included by qt-app.pro and batch/batch.pro.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/filehandler.cpp \
+    $$PWD/llmclient.cpp \
+    $$PWD/llmrequest.cpp \
+    $$PWD/chunkedsummary.cpp \
+    $$PWD/sectionedsummary.cpp \
+    $$PWD/incrementalsummary.cpp \
+    $$PWD/patientrecord.cpp \
+    $$PWD/transcript.cpp \
+    $$PWD/summary.cpp \
+    $$PWD/audiohandler.cpp \
+    $$PWD/summarygenerator.cpp \
+    $$PWD/summaryschema.cpp \
+    $$PWD/sectionindex.cpp \
+    $$PWD/segmentedrecorder.cpp \
+    $$PWD/transcriptstitcher.cpp \
+    $$PWD/transcriptionjob.cpp \
+    $$PWD/streamingbodydevice.cpp \
+    $$PWD/networkmanager.cpp \
+    $$PWD/audiometadata.cpp \
+    $$PWD/audioresampler.cpp \
+    $$PWD/chunkedtranscription.cpp \
+    $$PWD/flacencoder.cpp \
+    $$PWD/voiceactivitydetector.cpp \
+    $$PWD/pcmringbuffer.cpp \
+    $$PWD/streamingcapture.cpp \
+    $$PWD/transcriptionbackend.cpp \
+    $$PWD/whisperbackend.cpp \
+    $$PWD/googlespeechbackend.cpp \
+    $$PWD/localwhisperbackend.cpp \
+    $$PWD/latencyhistory.cpp \
+    $$PWD/hedgedtranscription.cpp \
+    $$PWD/diskcache.cpp \
+    $$PWD/transcriptcache.cpp \
+    $$PWD/responsecache.cpp \
+    $$PWD/visitqueue.cpp
+
+HEADERS += \
+    $$PWD/filehandler.h \
+    $$PWD/llmclient.h \
+    $$PWD/llmrequest.h \
+    $$PWD/chunkedsummary.h \
+    $$PWD/sectionedsummary.h \
+    $$PWD/incrementalsummary.h \
+    $$PWD/patientrecord.h \
+    $$PWD/transcript.h \
+    $$PWD/summary.h \
+    $$PWD/audiohandler.h \
+    $$PWD/summarygenerator.h \
+    $$PWD/summaryschema.h \
+    $$PWD/sectionindex.h \
+    $$PWD/notesections.h \
+    $$PWD/segmentedrecorder.h \
+    $$PWD/transcriptstitcher.h \
+    $$PWD/transcriptionjob.h \
+    $$PWD/streamingbodydevice.h \
+    $$PWD/networkmanager.h \
+    $$PWD/audiometadata.h \
+    $$PWD/audioresampler.h \
+    $$PWD/captureprofile.h \
+    $$PWD/chunkedtranscription.h \
+    $$PWD/flacencoder.h \
+    $$PWD/voiceactivitydetector.h \
+    $$PWD/pcmringbuffer.h \
+    $$PWD/streamingcapture.h \
+    $$PWD/transcriptionbackend.h \
+    $$PWD/whisperbackend.h \
+    $$PWD/googlespeechbackend.h \
+    $$PWD/localwhisperbackend.h \
+    $$PWD/latencyhistory.h \
+    $$PWD/hedgedtranscription.h \
+    $$PWD/diskcache.h \
+    $$PWD/transcriptcache.h \
+    $$PWD/responsecache.h \
+    $$PWD/visitqueue.h
@@ -14,20 +14,16 @@ mac {
 }
 
 
+# Recording, transcription and summarization, shared with the batch tool
+include(pipeline.pri)
+
 SOURCES += \
     addpatientdialog.cpp \
     editpatientinfo.cpp \
-    filehandler.cpp \
-    llmclient.cpp \
     main.cpp \
     mainwindow.cpp \
-    patientrecord.cpp \
     settings.cpp \
     windowbuilder.cpp \
-    transcript.cpp \
-    summary.cpp \
-    audiohandler.cpp \
-    summarygenerator.cpp \
     summaryformatter.cpp \
     detailedsummaryformatter.cpp \
     concisesummaryformatter.cpp
@@ -35,16 +31,9 @@ SOURCES += \
 HEADERS += \
     addpatientdialog.h \
     editpatientinfo.h \
-    filehandler.h \
-    llmclient.h \
     mainwindow.h \
-    patientrecord.h \
     settings.h \
     windowbuilder.h \
-    transcript.h \
-    summary.h \
-    audiohandler.h \
-    summarygenerator.h \
     summaryformatter.h \
     detailedsummaryformatter.h \
     concisesummaryformatter.h
@@ -0,0 +1,63 @@
+/**
+ * @file responsecache.cpp
+ * @brief Definition of ResponseCache class
+ *
+ * Responses are stored by DiskCache under a key combining the request's
+ * model, generation settings, initial prompt version and input.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 16, 2025
+ */
+
+#include "responsecache.h"
+
+ResponseCache *ResponseCache::instance = nullptr;
+
+namespace
+{
+const char *const cacheDirectory = "Cache/Summaries";
+const qint64 defaultMaximumBytes = 5 * 1024 * 1024;
+}
+
+/**
+ * @name ResponseCache (constructor)
+ * @brief Initializes a cache stored in a directory
+ * @details The directory is only read when the cache is first used.
+ * @param[in] directory: Directory holding the response files
+ * @author Callum Thompson
+ */
+ResponseCache::ResponseCache(const QString &directory) : DiskCache(directory, defaultMaximumBytes)
+{
+    // No logic body
+}
+
+/**
+ * @name getInstance
+ * @brief Returns the singleton instance of ResponseCache
+ * @return Shared response cache
+ * @author Callum Thompson
+ */
+ResponseCache *ResponseCache::getInstance()
+{
+    if (!instance)
+    {
+        instance = new ResponseCache(cacheDirectory);
+    }
+    return instance;
+}
+
+/**
+ * @name key
+ * @brief Identifies a request by the inputs that determine its response
+ * @details The key is digested into a file name, so the input may be long.
+ * @param[in] model: Model the request is sent to
+ * @param[in] generationConfig: Serialized generation settings
+ * @param[in] promptVersion: Digest of the initial prompt
+ * @param[in] input: Input prompt, such as the transcript
+ * @return Key of the response
+ * @author Callum Thompson
+ */
+QString ResponseCache::key(const QString &model, const QByteArray &generationConfig, const QString &promptVersion, const QString &input)
+{
+    return model + '\n' + QString::fromUtf8(generationConfig) + '\n' + promptVersion + '\n' + input;
+}
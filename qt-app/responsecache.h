@@ -0,0 +1,40 @@
+/**
+ * @file responsecache.h
+ * @brief Declaration of ResponseCache class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 16, 2025
+ */
+
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include "diskcache.h"
+
+/**
+ * @class ResponseCache
+ * @brief Keeps the LLM's responses on disk, keyed by everything that
+ * determines them
+ * @details Summaries are generated at temperature 0, so the same model,
+ * generation settings, initial prompt and transcript give the same
+ * summary. Regenerating a summary or reopening a patient then returns the
+ * stored response instead of calling the API again. Changing any of the
+ * inputs, including editing the prompt, misses the cache.
+ * @author Callum Thompson
+ */
+class ResponseCache : public DiskCache
+{
+public:
+    static ResponseCache *getInstance();
+
+    static QString key(const QString &model, const QByteArray &generationConfig, const QString &promptVersion, const QString &input);
+
+private:
+    explicit ResponseCache(const QString &directory);
+
+    static ResponseCache *instance;
+};
+
+#endif // RESPONSECACHE_H
@@ -0,0 +1,232 @@
+/**
+ * @file sectionedsummary.cpp
+ * @brief Definition of SectionedSummary class
+ *
+ * Writes the sections of a note concurrently from section-specific prompts.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 21, 2025
+ */
+
+#include <QRegularExpression>
+#include <QDebug>
+#include "sectionedsummary.h"
+#include "llmclient.h"
+#include "notesections.h"
+
+namespace
+{
+// Lines of llmprompt.txt that start each section, in the order of sectionNames()
+const QStringList sectionHeaders = {"INTERVAL HISTORY", "PHYSICAL EXAMINATION", "CURRENT STATUS", "PLAN",
+                                    "# Patient Follow-up Note"};
+
+/**
+ * @brief Appends a block of the initial prompt if it applies to a section
+ * @details Blocks of other sections are left out; shared instructions and
+ * separators are kept. An introduction line is always kept, and the example
+ * that follows it is part of the first section, as examples without a title
+ * start with the interval history.
+ */
+void appendBlock(QString &prompt, QStringView block, const QString &header, int section)
+{
+    if (header.startsWith("Here"))
+    {
+        qsizetype lineEnd = block.indexOf(u'\n') + 1;
+        if (lineEnd == 0)
+        {
+            lineEnd = block.size();
+        }
+        prompt += block.first(lineEnd);
+        if (section == 0)
+        {
+            prompt += block.sliced(lineEnd);
+        }
+        return;
+    }
+
+    int owner = sectionHeaders.indexOf(header);
+    if (owner == -1 || owner == section)
+    {
+        prompt += block;
+    }
+}
+}
+
+/**
+ * @name SectionedSummary (constructor)
+ * @brief Prepares the summary of a transcript
+ * @param[in] transcript: Transcript to summarize
+ * @param[in] refresh: True to generate new sections even if some are stored
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+SectionedSummary::SectionedSummary(const QString &transcript, bool refresh, QObject *parent)
+    : QObject(parent), transcript(transcript), refresh(refresh), sectionTexts(sectionNames().size()),
+      remaining(sectionNames().size())
+{
+    // No logic body
+}
+
+/**
+ * @name sectionNames
+ * @brief Returns the sections written by separate requests
+ * @return Section titles, in the order they appear in the note
+ * @author Callum Thompson
+ */
+const QStringList &SectionedSummary::sectionNames()
+{
+    static const QStringList names = []()
+    {
+        QStringList titles;
+        for (const NoteSections::Schema &section : NoteSections::schema)
+        {
+            titles.append(section.title.toString());
+        }
+        return titles;
+    }();
+    return names;
+}
+
+/**
+ * @name start
+ * @brief Sends the requests of all sections
+ * @details Every request carries the same transcript; LLMClient pairs it
+ * with the prompt of the section.
+ * @author Callum Thompson
+ */
+void SectionedSummary::start()
+{
+    const QStringList &names = sectionNames();
+    for (int index = 0; index < names.size(); ++index)
+    {
+        LLMRequest *request = LLMClient::getInstance()->sendRequest(transcript, index, refresh, names[index]);
+        connect(request, &LLMRequest::finished, this, [this, index](const QString &sectionText)
+                { handleSection(index, sectionText); });
+        connect(request, &LLMRequest::failed, this, [this, index](const QString &errorMessage)
+                { fail(QString("The %1 section could not be written: %2").arg(sectionNames()[index].toLower(), errorMessage)); });
+    }
+}
+
+/**
+ * @name sectionPrompt
+ * @brief Derives the prompt of one section from the initial prompt
+ * @details Keeps the steps ahead of the structure, the section's part of the
+ * structure and of the examples, and the instructions shared by all
+ * sections, then asks for that section alone. If the initial prompt does not
+ * have the expected layout it is used whole.
+ * @param[in] initialPrompt: Contents of llmprompt.txt
+ * @param[in] section: One of sectionNames()
+ * @return Prompt sent ahead of the transcript
+ * @author Callum Thompson
+ */
+QString SectionedSummary::sectionPrompt(const QString &initialPrompt, const QString &section)
+{
+    QString instruction = QString("\n\nWrite only the %1 section of the note, starting with its title in bold. "
+                                  "Do not write any other section.")
+                              .arg(section);
+    int target = sectionNames().indexOf(section);
+    qsizetype structureStart = initialPrompt.indexOf("**Here is the structure");
+    if (target == -1 || structureStart == -1)
+    {
+        return initialPrompt + instruction;
+    }
+
+    // Each block runs from one of these lines to the next
+    static const QRegularExpression boundary(
+        "^(INTERVAL HISTORY|PHYSICAL EXAMINATION|CURRENT STATUS|PLAN|# Patient Follow-up Note|Here (?:is|are) |Other instructions|—)",
+        QRegularExpression::MultilineOption);
+
+    QString prompt = initialPrompt.left(structureStart);
+    QStringView text(initialPrompt);
+    qsizetype blockStart = structureStart;
+    QString header = "Here"; // The structure is introduced like the examples
+    QRegularExpressionMatchIterator matches = boundary.globalMatch(initialPrompt, structureStart);
+    while (matches.hasNext())
+    {
+        QRegularExpressionMatch match = matches.next();
+        appendBlock(prompt, text.sliced(blockStart, match.capturedStart() - blockStart), header, target);
+        blockStart = match.capturedStart();
+        header = match.captured(1);
+    }
+    appendBlock(prompt, text.sliced(blockStart), header, target);
+
+    return prompt.trimmed() + instruction;
+}
+
+/**
+ * @name handleSection
+ * @brief Records a written section and reports the summary so far
+ * @param[in] index: Section that was written
+ * @param[in] sectionText: Response of the section's request
+ * @author Callum Thompson
+ */
+void SectionedSummary::handleSection(int index, const QString &sectionText)
+{
+    if (ended)
+    {
+        return;
+    }
+    sectionTexts[index] = stripTitle(sectionText, sectionNames()[index]);
+    if (--remaining > 0)
+    {
+        emit partialResponse(assemble());
+        return;
+    }
+    ended = true;
+    emit finished(assemble());
+}
+
+/**
+ * @name assemble
+ * @brief Joins the sections in the format of a single response
+ * @details Every title is present, so SummaryGenerator treats each written
+ * section as complete, whatever order the sections finish in.
+ * @return Summary text with a bold title ahead of each section
+ * @author Callum Thompson
+ */
+QString SectionedSummary::assemble() const
+{
+    const QStringList &names = sectionNames();
+    QString text;
+    for (int index = 0; index < names.size(); ++index)
+    {
+        text += "**" + names[index] + "**\n\n" + sectionTexts[index] + "\n\n";
+    }
+    return text.trimmed();
+}
+
+/**
+ * @name stripTitle
+ * @brief Removes the title a response starts with
+ * @param[in] sectionText: Response of a section's request
+ * @param[in] section: Title of the section
+ * @return Body of the section
+ * @author Callum Thompson
+ */
+QString SectionedSummary::stripTitle(const QString &sectionText, const QString &section)
+{
+    QRegularExpression title("^[\\s#*]*" + QRegularExpression::escape(section) + "[ \\t*:]*",
+                             QRegularExpression::CaseInsensitiveOption);
+    QString body = sectionText;
+    body.remove(title);
+    return body.trimmed();
+}
+
+/**
+ * @name fail
+ * @brief Fails the summary once
+ * @details Requests still in flight finish on their own; their responses
+ * are ignored but stored for the next attempt.
+ * @param[in] errorMessage: Description of the failure
+ * @author Callum Thompson
+ */
+void SectionedSummary::fail(const QString &errorMessage)
+{
+    if (ended)
+    {
+        return;
+    }
+    ended = true;
+    qWarning() << "Sectioned summary failed:" << errorMessage;
+    emit failed(errorMessage);
+}
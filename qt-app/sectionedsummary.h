@@ -0,0 +1,58 @@
+/**
+ * @file sectionedsummary.h
+ * @brief Declaration of SectionedSummary class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 21, 2025
+ */
+
+#ifndef SECTIONEDSUMMARY_H
+#define SECTIONEDSUMMARY_H
+
+#include <QObject>
+#include <QStringList>
+
+/**
+ * @class SectionedSummary
+ * @brief Summarizes a transcript as one request per section of the note,
+ * all sent at once
+ * @details Each section, and the patient follow-up note, is written by its
+ * own request from the same transcript, using a shorter prompt that keeps
+ * only that section's part of the structure and examples. The requests run
+ * concurrently, so the summary takes about as long as its longest section
+ * rather than all of them in turn. Finished sections are reported in the
+ * usual order and format, with the sections still being written left empty.
+ * The first failed section fails the whole summary.
+ * @author Callum Thompson
+ */
+class SectionedSummary : public QObject
+{
+    Q_OBJECT
+
+public:
+    SectionedSummary(const QString &transcript, bool refresh, QObject *parent);
+
+    void start();
+
+    static const QStringList &sectionNames();
+    static QString sectionPrompt(const QString &initialPrompt, const QString &section);
+
+signals:
+    void partialResponse(const QString &textSoFar); // Finished sections, with the others empty
+    void finished(const QString &summaryText);      // All sections
+    void failed(const QString &errorMessage);       // A section could not be written
+
+private:
+    QString transcript;
+    bool refresh;
+    QStringList sectionTexts;
+    int remaining;             // Sections not yet written
+    bool ended = false;
+
+    void handleSection(int index, const QString &sectionText);
+    QString assemble() const;
+    void fail(const QString &errorMessage);
+    static QString stripTitle(const QString &sectionText, const QString &section);
+};
+
+#endif // SECTIONEDSUMMARY_H
@@ -0,0 +1,179 @@
+/**
+ * @file sectionindex.cpp
+ * @brief Definition of SectionIndex class
+ *
+ * Single-pass search for the section titles of a note.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 26, 2025
+ */
+
+#include <QList>
+#include <algorithm>
+#include "sectionindex.h"
+
+using NoteSections::Section;
+
+/**
+ * @name SectionIndex (constructor)
+ * @brief Indexes the sections of a note
+ * @param[in] text: Note, or the part of it received so far
+ * @author Callum Thompson
+ */
+SectionIndex::SectionIndex(const QString &text)
+    : text(text)
+{
+    scan();
+}
+
+/**
+ * @name contains
+ * @brief Returns whether a section's title was found
+ * @param[in] section: Section to look for
+ * @return True if the note has the section
+ * @author Callum Thompson
+ */
+bool SectionIndex::contains(Section section) const
+{
+    return headers[section].start != -1;
+}
+
+/**
+ * @name isComplete
+ * @brief Returns whether a section is followed by another
+ * @details While a note is streamed, a section is only complete once the
+ * title of a later section has arrived.
+ * @param[in] section: Section to check
+ * @return True if the note has the section and a title after it
+ * @author Callum Thompson
+ */
+bool SectionIndex::isComplete(Section section) const
+{
+    return contains(section) && headers[section].bodyEnd < text.size();
+}
+
+/**
+ * @name section
+ * @brief Returns the text of a section
+ * @param[in] section: Section to return
+ * @return View of the text between the section's title and the next
+ * section title, untrimmed; a null view if the note lacks the section
+ * @author Callum Thompson
+ */
+QStringView SectionIndex::section(Section section) const
+{
+    if (!contains(section))
+    {
+        return QStringView();
+    }
+    const Header &header = headers[section];
+    return QStringView(text).sliced(header.bodyStart, header.bodyEnd - header.bodyStart);
+}
+
+/**
+ * @name sections
+ * @brief Returns the text from one section through a later one
+ * @details Titles of the sections in between are included.
+ * @param[in] first: First section
+ * @param[in] last: Last section; ignored if missing or ahead of the first
+ * @return View of the text, or a null view if the note lacks the first section
+ * @author Callum Thompson
+ */
+QStringView SectionIndex::sections(Section first, Section last) const
+{
+    if (!contains(first) || !contains(last) || headers[last].start < headers[first].start)
+    {
+        return section(first);
+    }
+    qsizetype start = headers[first].bodyStart;
+    return QStringView(text).sliced(start, headers[last].bodyEnd - start);
+}
+
+/**
+ * @name scan
+ * @brief Finds every section title in one pass
+ * @details Section titles can only start at "**", so most characters are
+ * passed over after a single comparison. Each body then ends at the next
+ * title found.
+ * @author Callum Thompson
+ */
+void SectionIndex::scan()
+{
+    const qsizetype size = text.size();
+    const QChar *data = text.constData();
+
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        if (data[i] == u'*' && i + 1 < size && data[i + 1] == u'*')
+        {
+            Section section;
+            qsizetype length = matchSectionTitle(i, section);
+            if (length > 0)
+            {
+                if (!contains(section))
+                {
+                    headers[section].start = i;
+                    headers[section].bodyStart = i + length;
+                }
+                i += length - 1;
+            }
+        }
+    }
+
+    // Each section ends where the next section title starts
+    QList<qsizetype> starts;
+    for (const Header &header : headers)
+    {
+        if (header.start != -1)
+        {
+            starts.append(header.start);
+        }
+    }
+    std::sort(starts.begin(), starts.end());
+    for (Header &header : headers)
+    {
+        if (header.start != -1)
+        {
+            auto next = std::upper_bound(starts.begin(), starts.end(), header.start);
+            header.bodyEnd = next != starts.end() ? *next : size;
+        }
+    }
+}
+
+/**
+ * @name matchSectionTitle
+ * @brief Matches a bold section title
+ * @param[in] position: Offset of a "**"
+ * @param[out] section: Receives the section whose title was matched
+ * @return Length of the title including its markers, or 0 if there is none
+ * @author Callum Thompson
+ */
+qsizetype SectionIndex::matchSectionTitle(qsizetype position, Section &section) const
+{
+    QStringView rest = QStringView(text).sliced(position + 2);
+    if (rest.isEmpty())
+    {
+        return 0;
+    }
+
+    QChar first = rest.front().toUpper();
+    for (int index = 0; index < NoteSections::Count; ++index)
+    {
+        QStringView title = NoteSections::schema[index].title;
+        if (title.front() != first || !rest.startsWith(title, Qt::CaseInsensitive))
+        {
+            continue;
+        }
+        qsizetype end = title.size();
+        if (end < rest.size() && rest[end] == u':')
+        {
+            ++end;
+        }
+        if (rest.sliced(end).startsWith(u"**"))
+        {
+            section = Section(index);
+            return 2 + end + 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file sectionindex.h
+ * @brief Declaration of SectionIndex class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 26, 2025
+ */
+
+#ifndef SECTIONINDEX_H
+#define SECTIONINDEX_H
+
+#include <QString>
+#include <QStringView>
+#include "notesections.h"
+
+/**
+ * @class SectionIndex
+ * @brief Locates the sections of a markdown note in one pass
+ * @details The text is scanned once. At each "**" the section titles of
+ * NoteSections are tried and the offsets found are recorded. Sections are
+ * then returned as views of the text, which the index shares rather than
+ * copies. A section title counts where it first appears, in bold, with or
+ * without a trailing colon.
+ * @author Callum Thompson
+ */
+class SectionIndex
+{
+public:
+    explicit SectionIndex(const QString &text);
+
+    bool contains(NoteSections::Section section) const;
+    bool isComplete(NoteSections::Section section) const;
+    QStringView section(NoteSections::Section section) const;
+    QStringView sections(NoteSections::Section first, NoteSections::Section last) const;
+
+private:
+    /**
+     * @struct Header
+     * @brief Offsets of a section title and its text
+     */
+    struct Header
+    {
+        qsizetype start = -1;    // Offset of the title, or -1 if not found
+        qsizetype bodyStart = -1; // Offset just past the title
+        qsizetype bodyEnd = -1;   // Offset of the next title, or the end of the text
+    };
+
+    QString text; // Shared with the caller's string; views point into it
+    Header headers[NoteSections::Count];
+
+    void scan();
+    qsizetype matchSectionTitle(qsizetype position, NoteSections::Section &section) const;
+};
+
+#endif // SECTIONINDEX_H
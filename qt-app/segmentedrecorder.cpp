@@ -0,0 +1,327 @@
+/**
+ * @file segmentedrecorder.cpp
+ * @brief Definition of SegmentedRecorder class
+ *
+ * Records audio as rolling, overlapping segment files so that transcription of
+ * earlier segments can run while recording continues.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 2, 2025
+ */
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMediaFormat>
+#include <QUrl>
+#include <QDebug>
+#include "segmentedrecorder.h"
+
+/**
+ * @name SegmentedRecorder (constructor)
+ * @brief Initializes the recorder and its segment rotation timer
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+SegmentedRecorder::SegmentedRecorder(QObject *parent)
+    : QObject(parent)
+{
+    rotationTimer.setSingleShot(true);
+    connect(&rotationTimer, &QTimer::timeout, this, &SegmentedRecorder::rotateSegment);
+}
+
+/**
+ * @name ~SegmentedRecorder (destructor)
+ * @brief Releases the capture objects of any segments still recording
+ * @author Callum Thompson
+ */
+SegmentedRecorder::~SegmentedRecorder()
+{
+    for (Segment *segment : activeSegments)
+    {
+        delete segment->recorder;
+        delete segment->session;
+        delete segment->input;
+        delete segment;
+    }
+}
+
+/**
+ * @name setSegmentLength
+ * @brief Configures the segment length and the overlap between segments
+ * @details Takes effect from the next recording.
+ * @param[in] newSegmentSecs: Seconds recorded before the next segment starts
+ * @param[in] newOverlapSecs: Seconds both segments record at each boundary
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::setSegmentLength(int newSegmentSecs, int newOverlapSecs)
+{
+    segmentSecs = qMax(1, newSegmentSecs);
+    overlapSecs = qBound(0, newOverlapSecs, segmentSecs - 1);
+}
+
+/**
+ * @name setAudioFormat
+ * @brief Configures the format requested for the segment files
+ * @details Takes effect from the next segment. Backends may not honour the
+ * request, so the format of each file should be checked after it is finalized.
+ * @param[in] newSampleRate: Sample rate in Hz
+ * @param[in] newChannelCount: Number of channels
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::setAudioFormat(int newSampleRate, int newChannelCount)
+{
+    sampleRate = newSampleRate;
+    channelCount = newChannelCount;
+}
+
+/**
+ * @name start
+ * @brief Starts recording the first segment
+ * @details Segment files are written next to `basePath`, named after it with
+ * the segment index appended (e.g. `output_seg000.wav`). If the first
+ * segment fails to start, it is closed and recordingFinished() is emitted.
+ * @param[in] newDevice: Microphone to record from
+ * @param[in] newBasePath: Output path that segment file names are derived from
+ * @return True if recording started
+ * @author Callum Thompson
+ */
+bool SegmentedRecorder::start(const QAudioDevice &newDevice, const QString &newBasePath)
+{
+    if (recording)
+    {
+        qWarning() << "Segmented recording already in progress.";
+        return false;
+    }
+
+    device = newDevice;
+    basePath = newBasePath;
+    nextIndex = 0;
+    recording = true;
+    stopping = false;
+
+    startSegment();
+    if (activeSegments.last()->recorder->error() != QMediaRecorder::NoError)
+    {
+        qWarning() << "Could not start segmented recording:" << activeSegments.last()->recorder->errorString();
+        stop(); // recordingFinished() follows once the segment is closed
+        return false;
+    }
+    rotationTimer.start(segmentSecs * 1000);
+    return true;
+}
+
+/**
+ * @name stop
+ * @brief Stops all segments currently recording
+ * @details recordingFinished() is emitted once every segment file has been
+ * finalized.
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::stop()
+{
+    if (!recording || stopping)
+    {
+        return;
+    }
+
+    stopping = true;
+    rotationTimer.stop();
+
+    // Copy the list, since stopping a segment may remove it from activeSegments
+    const QList<Segment *> segments = activeSegments;
+    for (Segment *segment : segments)
+    {
+        stopSegment(segment);
+    }
+}
+
+/**
+ * @name pause
+ * @brief Pauses all segments currently recording
+ * @details The time left in the current segment is kept so the segment
+ * continues to its full length after resuming.
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::pause()
+{
+    if (!recording || stopping)
+    {
+        return;
+    }
+
+    int remaining = rotationTimer.remainingTime();
+    rotationTimer.stop();
+    rotationTimer.setInterval(qMax(0, remaining));
+
+    for (Segment *segment : activeSegments)
+    {
+        segment->recorder->pause();
+    }
+}
+
+/**
+ * @name resume
+ * @brief Resumes all paused segments
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::resume()
+{
+    if (!recording || stopping)
+    {
+        return;
+    }
+
+    for (Segment *segment : activeSegments)
+    {
+        segment->recorder->record();
+    }
+    rotationTimer.start();
+}
+
+/**
+ * @name isRecording
+ * @brief Returns whether a segmented recording is in progress
+ * @return True from start() until recordingFinished() is emitted
+ * @author Callum Thompson
+ */
+bool SegmentedRecorder::isRecording() const
+{
+    return recording;
+}
+
+/**
+ * @name rotateSegment
+ * @brief Starts the next segment and schedules the current one to stop
+ * @details The current segment keeps recording for the configured overlap so
+ * speech spanning the boundary is captured completely by at least one segment.
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::rotateSegment()
+{
+    if (!recording || stopping || activeSegments.isEmpty())
+    {
+        return;
+    }
+
+    int previousIndex = activeSegments.last()->index;
+    startSegment();
+    rotationTimer.start(segmentSecs * 1000);
+
+    // Stop the previous segment once the overlap has been recorded
+    QTimer::singleShot(overlapSecs * 1000, this, [this, previousIndex]()
+    {
+        for (Segment *segment : activeSegments)
+        {
+            if (segment->index == previousIndex)
+            {
+                stopSegment(segment);
+                return;
+            }
+        }
+    });
+}
+
+/**
+ * @name startSegment
+ * @brief Creates the capture objects for a new segment and starts recording
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::startSegment()
+{
+    Segment *segment = new Segment;
+    segment->index = nextIndex++;
+    segment->filePath = segmentPath(segment->index);
+    segment->input = new QAudioInput(device);
+    segment->session = new QMediaCaptureSession;
+    segment->recorder = new QMediaRecorder;
+
+    segment->session->setAudioInput(segment->input);
+    segment->session->setRecorder(segment->recorder);
+
+    // Record each segment as a standalone WAV file
+    QMediaFormat mediaFormat;
+    mediaFormat.setFileFormat(QMediaFormat::Wave);
+    segment->recorder->setMediaFormat(mediaFormat);
+    segment->recorder->setAudioSampleRate(sampleRate);
+    segment->recorder->setAudioChannelCount(channelCount);
+    segment->recorder->setOutputLocation(QUrl::fromLocalFile(segment->filePath));
+
+    connect(segment->recorder, &QMediaRecorder::recorderStateChanged, this, [this, segment](QMediaRecorder::RecorderState state)
+    {
+        if (state == QMediaRecorder::StoppedState)
+        {
+            handleRecorderStopped(segment);
+        }
+    });
+    connect(segment->recorder, &QMediaRecorder::errorOccurred, this, [segment](QMediaRecorder::Error, const QString &errorString)
+    {
+        qWarning() << "Segment" << segment->index << "recording error:" << errorString;
+    });
+
+    activeSegments.append(segment);
+    segment->recorder->record();
+}
+
+/**
+ * @name stopSegment
+ * @brief Stops recording a segment
+ * @details The segment is finalized asynchronously; handleRecorderStopped()
+ * runs once the recorder has closed the file.
+ * @param[in] segment: Segment to stop
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::stopSegment(Segment *segment)
+{
+    if (segment->recorder->recorderState() == QMediaRecorder::StoppedState)
+    {
+        handleRecorderStopped(segment); // Recorder never started, nothing to wait for
+        return;
+    }
+    segment->recorder->stop();
+}
+
+/**
+ * @name handleRecorderStopped
+ * @brief Releases a finalized segment and reports its file
+ * @param[in] segment: Segment whose recorder has stopped
+ * @author Callum Thompson
+ */
+void SegmentedRecorder::handleRecorderStopped(Segment *segment)
+{
+    if (!activeSegments.removeOne(segment))
+    {
+        return; // Already handled
+    }
+
+    emit segmentFinished(segment->index, segment->filePath);
+
+    segment->recorder->deleteLater();
+    segment->session->deleteLater();
+    segment->input->deleteLater();
+    delete segment;
+
+    // The recording is complete once the last segment has been finalized
+    if (stopping && activeSegments.isEmpty())
+    {
+        recording = false;
+        stopping = false;
+        emit recordingFinished(nextIndex);
+    }
+}
+
+/**
+ * @name segmentPath
+ * @brief Builds the file path for a segment
+ * @param[in] index: Segment index
+ * @return Path of the segment file
+ * @author Callum Thompson
+ */
+QString SegmentedRecorder::segmentPath(int index) const
+{
+    QFileInfo baseInfo(basePath);
+    QString fileName = QString("%1_seg%2.%3")
+                           .arg(baseInfo.completeBaseName())
+                           .arg(index, 3, 10, QChar('0'))
+                           .arg(baseInfo.suffix().isEmpty() ? "wav" : baseInfo.suffix());
+    return baseInfo.dir().filePath(fileName);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file segmentedrecorder.h
+ * @brief Declaration of SegmentedRecorder class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 2, 2025
+ */
+
+#ifndef SEGMENTEDRECORDER_H
+#define SEGMENTEDRECORDER_H
+
+#include <QObject>
+#include <QList>
+#include <QTimer>
+#include <QAudioDevice>
+#include <QAudioInput>
+#include <QMediaCaptureSession>
+#include <QMediaRecorder>
+
+/**
+ * @class SegmentedRecorder
+ * @brief Records audio as a sequence of short, overlapping WAV files
+ * @details Recording is split into rolling segments so each finished segment
+ * can be transcribed while capture continues. When a segment reaches its
+ * length, the next segment starts recording and the previous one keeps running
+ * for a short overlap before it is stopped, so no speech is lost at the
+ * boundary. A signal is emitted once each segment file has been finalized.
+ * @author Callum Thompson
+ */
+class SegmentedRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentedRecorder(QObject *parent = nullptr);
+    ~SegmentedRecorder();
+
+    void setSegmentLength(int segmentSecs, int overlapSecs);
+    void setAudioFormat(int sampleRate, int channelCount);
+    bool start(const QAudioDevice &device, const QString &basePath);
+    void stop();
+    void pause();
+    void resume();
+    bool isRecording() const;
+
+signals:
+    void segmentFinished(int index, const QString &filePath); // Segment file has been finalized
+    void recordingFinished(int segmentCount);                 // All segments have been finalized after stop()
+
+private slots:
+    void rotateSegment();
+
+private:
+    /**
+     * @brief Capture objects that record a single segment
+     */
+    struct Segment
+    {
+        int index;
+        QString filePath;
+        QMediaCaptureSession *session;
+        QAudioInput *input;
+        QMediaRecorder *recorder;
+    };
+
+    QList<Segment *> activeSegments; // Segments currently recording or finalizing
+    QTimer rotationTimer;            // Fires when the current segment reaches its length
+    QAudioDevice device;             // Microphone used for every segment
+    QString basePath;                // Output path that segment file names are derived from
+    int segmentSecs = 45;            // Length of each segment before the next starts
+    int overlapSecs = 2;             // Time both segments record at a boundary
+    int sampleRate = 16000;          // Sample rate requested from the recorder
+    int channelCount = 1;            // Channel count requested from the recorder
+    int nextIndex = 0;               // Index assigned to the next segment
+    bool recording = false;
+    bool stopping = false;
+
+    void startSegment();
+    void stopSegment(Segment *segment);
+    void handleRecorderStopped(Segment *segment);
+    QString segmentPath(int index) const;
+};
+
+#endif // SEGMENTEDRECORDER_H
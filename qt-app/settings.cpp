@@ -31,6 +31,21 @@ QString Settings::keyFilename = "keyFile.txt";
  *      OPENAI_AUDIO_API_KEY: OpenAI Whisper API key
  *      SUMMARY_LAYOUT_PREFERENCE: Summary layout preference. One of 
  *                                  {"Detailed Format", "Concise Format"}
+ *      CAPTURE_PROFILE: Recording format. One of {"Speech", "High Fidelity"}
+ *      CAPTURE_BACKEND: Recorder used for live transcription. One of
+ *                       {"Media Recorder", "Streaming"}
+ *      WHISPER_CPP_MODEL: GGML model file for offline transcription
+ *      WHISPER_CPP_PATH: whisper.cpp program; searched for on PATH if absent
+ *      HEDGED_TRANSCRIPTION: Race a second service against slow answers. One of {"On", "Off"}
+ *      TRANSCRIPT_CACHE_MB: Disk space for cached transcripts; 0 disables the cache
+ *      LLM_STREAMING: Show summary sections as they are generated. One of {"On", "Off"}
+ *      LLM_CONTEXT_CACHE: Cache the summary instructions on the server. One of {"On", "Off"}
+ *      LLM_BASE_URL: Address of the Gemini API, e.g. a local stand-in server
+ *      SUMMARY_CACHE_MB: Disk space for stored summaries; 0 disables the cache
+ *      SUMMARY_PART_TOKENS: Longer transcripts are summarized in parts; 0 (default) never splits
+ *      SUMMARY_SECTIONS: Write each summary section with its own request, all at once. One of {"On", "Off"}
+ *      SUMMARY_FORMAT: Format the LLM returns summaries in. One of {"Markdown", "JSON"}
+ *      SUMMARY_UPDATES: Amend the saved summary with new transcript. One of {"Incremental", "Full"}
  * @note The API keys are expected to be in the format "KEY_NAME:KEY_VALUE".
  * @param parent - MainWindow
  * @author Thomas Llamzon
@@ -67,12 +82,91 @@ Settings::Settings(QObject *p) : QObject(p), mainWindow(p)
         else if (line.startsWith("SUMMARY_LAYOUT_PREFERENCE:")) {
             summaryLayoutPreference = line.mid(QString("SUMMARY_LAYOUT_PREFERENCE:").length()).trimmed();
         }
+        // Recording format
+        else if (line.startsWith("CAPTURE_PROFILE:")) {
+            captureProfileName = line.mid(QString("CAPTURE_PROFILE:").length()).trimmed();
+        }
+        // Recorder used for live transcription
+        else if (line.startsWith("CAPTURE_BACKEND:")) {
+            QString backend = line.mid(QString("CAPTURE_BACKEND:").length()).trimmed();
+            AudioHandler::getInstance()->setStreamingCapture(backend == "Streaming");
+        }
+        // Offline transcription model and program
+        else if (line.startsWith("WHISPER_CPP_MODEL:")) {
+            localModelPath = line.mid(QString("WHISPER_CPP_MODEL:").length()).trimmed();
+        }
+        else if (line.startsWith("WHISPER_CPP_PATH:")) {
+            localExecutablePath = line.mid(QString("WHISPER_CPP_PATH:").length()).trimmed();
+        }
+        // Hedged transcription of short recordings
+        else if (line.startsWith("HEDGED_TRANSCRIPTION:")) {
+            QString hedging = line.mid(QString("HEDGED_TRANSCRIPTION:").length()).trimmed();
+            AudioHandler::getInstance()->setHedging(hedging == "On");
+        }
+        // Disk space for cached transcripts
+        else if (line.startsWith("TRANSCRIPT_CACHE_MB:")) {
+            bool ok = false;
+            int megabytes = line.mid(QString("TRANSCRIPT_CACHE_MB:").length()).trimmed().toInt(&ok);
+            if (ok) {
+                AudioHandler::getInstance()->setTranscriptCacheSize(qint64(megabytes) * 1024 * 1024);
+            }
+        }
+        // Streamed summaries
+        else if (line.startsWith("LLM_STREAMING:")) {
+            QString streaming = line.mid(QString("LLM_STREAMING:").length()).trimmed();
+            LLMClient::getInstance()->setStreaming(streaming != "Off");
+        }
+        // Server-side cache of the summary instructions
+        else if (line.startsWith("LLM_CONTEXT_CACHE:")) {
+            QString caching = line.mid(QString("LLM_CONTEXT_CACHE:").length()).trimmed();
+            LLMClient::getInstance()->setContextCaching(caching == "On");
+        }
+        else if (line.startsWith("LLM_BASE_URL:")) {
+            LLMClient::getInstance()->setBaseUrl(line.mid(QString("LLM_BASE_URL:").length()));
+        }
+        // Disk space for stored summaries
+        else if (line.startsWith("SUMMARY_CACHE_MB:")) {
+            bool ok = false;
+            int megabytes = line.mid(QString("SUMMARY_CACHE_MB:").length()).trimmed().toInt(&ok);
+            if (ok) {
+                LLMClient::getInstance()->setResponseCacheSize(qint64(megabytes) * 1024 * 1024);
+            }
+        }
+        // Size of the parts long transcripts are summarized in
+        else if (line.startsWith("SUMMARY_PART_TOKENS:")) {
+            bool ok = false;
+            int tokens = line.mid(QString("SUMMARY_PART_TOKENS:").length()).trimmed().toInt(&ok);
+            if (ok) {
+                LLMClient::getInstance()->setSummaryPartSize(tokens);
+            }
+        }
+        // Summary sections written concurrently
+        else if (line.startsWith("SUMMARY_SECTIONS:")) {
+            QString sections = line.mid(QString("SUMMARY_SECTIONS:").length()).trimmed();
+            LLMClient::getInstance()->setSectionedSummaries(sections == "On");
+        }
+        // Summaries returned as JSON rather than markdown
+        else if (line.startsWith("SUMMARY_FORMAT:")) {
+            QString format = line.mid(QString("SUMMARY_FORMAT:").length()).trimmed();
+            LLMClient::getInstance()->setStructuredOutput(format == "JSON");
+        }
+        // Saved summaries amended with the transcript added since
+        else if (line.startsWith("SUMMARY_UPDATES:")) {
+            QString updates = line.mid(QString("SUMMARY_UPDATES:").length()).trimmed();
+            LLMClient::getInstance()->setIncrementalSummaries(updates == "Incremental");
+        }
     }
 
     // Set API keys from keyFile
     LLMClient::getInstance()->setApiKey(llmKey);
     AudioHandler::getInstance()->setGoogleApiKey(googleSpeechApiKey);
     AudioHandler::getInstance()->setOpenAIApiKey(openAIAudioKey);
+    AudioHandler::getInstance()->setLocalTranscription(localExecutablePath, localModelPath);
+
+    // Apply recording format, defaulting to the speech profile
+    CaptureProfile profile = CaptureProfile::fromName(captureProfileName);
+    captureProfileName = profile.name;
+    AudioHandler::getInstance()->setCaptureProfile(profile);
 }
 
 /**
@@ -145,6 +239,34 @@ void Settings::showSettings()
         selectLayoutButton->setText(summaryLayoutPreference);
     });
 
+    // ========== Recording Format ==========
+    QVBoxLayout *captureLayout = new QVBoxLayout();
+
+    QLabel *rLabel = new QLabel("Recording Format:", settingsWindow);
+    captureLayout->addWidget(rLabel);
+
+    // Construct recording format drop down menu
+    QPushButton *selectCaptureButton = new QPushButton(settingsWindow);
+    QMenu *captureProfileOptions = new QMenu();
+    captureLayout->addWidget(selectCaptureButton);
+
+    QAction *optionSpeechProfile = captureProfileOptions->addAction(CaptureProfile::speech().name);
+    QAction *optionHighFidelityProfile = captureProfileOptions->addAction(CaptureProfile::highFidelity().name);
+
+    selectCaptureButton->setMenu(captureProfileOptions);
+    selectCaptureButton->setText(captureProfileName);
+    mainLayout->addLayout(captureLayout);
+
+    // Connect selected recording format to storage in keyFile
+    connect(optionSpeechProfile, &QAction::triggered, this, [=]() {
+        setCaptureProfile(CaptureProfile::speech().name);
+        selectCaptureButton->setText(captureProfileName);
+    });
+    connect(optionHighFidelityProfile, &QAction::triggered, this, [=]() {
+        setCaptureProfile(CaptureProfile::highFidelity().name);
+        selectCaptureButton->setText(captureProfileName);
+    });
+
     // ========== Connected Peripherals ==========
     QVBoxLayout *peripheralsLayout = new QVBoxLayout();
     QLabel *cpLabel = new QLabel("Connected Peripherals:", settingsWindow);
@@ -387,6 +509,22 @@ void Settings::setSummaryPreference(QString pref) {
     storeConfig("SUMM", pref);
 }
 
+/**
+ * @name setCaptureProfile
+ * @brief Sets the recording format and stores it in the keyFile
+ * @details Speech (16 kHz mono) is what the transcription services process
+ * and keeps uploads small; High Fidelity (48 kHz stereo) keeps the
+ * microphone's native quality.
+ * @param[in] profileName: Capture profile name (Speech/High Fidelity)
+ * @author Callum Thompson
+ */
+void Settings::setCaptureProfile(QString profileName) {
+    CaptureProfile profile = CaptureProfile::fromName(profileName);
+    captureProfileName = profile.name;
+    AudioHandler::getInstance()->setCaptureProfile(profile);
+    storeConfig("CAPTURE", profile.name);
+}
+
 /**
  * @name getLLMKey
  * @brief Get Google Gemini API key
@@ -435,6 +573,17 @@ QString Settings::getSummaryPreference() const
     return summaryLayoutPreference;
 }
 
+/**
+ * @name getCaptureProfile
+ * @brief Get the recording format
+ * @return Capture profile name (Speech/High Fidelity)
+ * @author Callum Thompson
+ */
+QString Settings::getCaptureProfile() const
+{
+    return captureProfileName;
+}
+
 /**
  * @name storeConfig
  * @brief Writes to hidden file storing user settings configurations.
@@ -456,6 +605,8 @@ void Settings::storeConfig(const QString &config, const QString &value)
         prefix = "OPENAI_AUDIO_API_KEY:";
     } else if (config == "SUMM") {
         prefix = "SUMMARY_LAYOUT_PREFERENCE:";
+    } else if (config == "CAPTURE") {
+        prefix = "CAPTURE_PROFILE:";
     } else {
         qWarning() << "Unknown keyClient:" << config;
         return;
@@ -53,11 +53,13 @@ public:
     void setGoogleSpeechApiKey(const QString newKey);
     void setOpenAIAudioKey(QString newKey);
     void setSummaryPreference(const QString pref);
+    void setCaptureProfile(const QString profileName);
 
     QString getLLMKey() const;
     QString getGoogleSpeechApiKey() const;
     QString getOpenAIAudioKey() const;
     QString getSummaryPreference() const;
+    QString getCaptureProfile() const;
 
 private:
     Settings(QObject *parent);
@@ -70,6 +72,9 @@ private:
     QString googleSpeechApiKey;
     QString openAIAudioKey;
     QString summaryLayoutPreference;
+    QString captureProfileName;
+    QString localModelPath;
+    QString localExecutablePath;
 
     static QString keyFilename;
     static Settings *instance;
@@ -0,0 +1,440 @@
+/**
+ * @file streamingbodydevice.cpp
+ * @brief Definition of StreamingBodyDevice class
+ *
+ * Produces JSON request bodies for the transcription and summarization APIs
+ * without building the whole payload in memory. Audio files are memory-mapped
+ * and base64-encoded in blocks as the request is sent.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 4, 2025
+ */
+
+#include <cstring>
+#include <QDebug>
+#include "streamingbodydevice.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define STREAMINGBODY_HAVE_SSSE3 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * @name encodeBase64Scalar
+ * @brief Encodes complete 3-byte groups, one group per iteration
+ * @param[in] input: Bytes to encode
+ * @param[in] groups: Number of 3-byte groups to encode
+ * @param[out] output: Destination for 4 characters per group
+ * @author Callum Thompson
+ */
+void encodeBase64Scalar(const uchar *input, qint64 groups, char *output)
+{
+    for (qint64 i = 0; i < groups; ++i)
+    {
+        quint32 triple = (quint32(input[0]) << 16) | (quint32(input[1]) << 8) | input[2];
+        output[0] = base64Alphabet[(triple >> 18) & 0x3F];
+        output[1] = base64Alphabet[(triple >> 12) & 0x3F];
+        output[2] = base64Alphabet[(triple >> 6) & 0x3F];
+        output[3] = base64Alphabet[triple & 0x3F];
+        input += 3;
+        output += 4;
+    }
+}
+
+#ifdef STREAMINGBODY_HAVE_SSSE3
+/**
+ * @name encodeBase64Ssse3
+ * @brief Encodes 3-byte groups 12 input bytes at a time using SSSE3
+ * @details Each iteration loads 16 bytes, of which 12 are consumed, splits
+ * them into sixteen 6-bit indices with a byte shuffle and two multiplies, and
+ * translates the indices to ASCII with a second shuffle. The loop stops while
+ * at least 4 spare input bytes remain so the 16-byte load never reads past the
+ * end of the input; the caller encodes the remaining groups.
+ * @param[in] input: Bytes to encode
+ * @param[in] groups: Number of 3-byte groups available
+ * @param[out] output: Destination for 4 characters per group
+ * @return Number of groups encoded
+ * @author Callum Thompson
+ */
+__attribute__((target("ssse3"))) qint64 encodeBase64Ssse3(const uchar *input, qint64 groups, char *output)
+{
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i translate = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+    qint64 encoded = 0;
+    while (groups - encoded >= 6) // 4 groups consumed, 2 more keep the 16-byte load in bounds
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+        in = _mm_shuffle_epi8(in, shuffle);
+
+        // Move each 6-bit field into its own byte
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        // Translate 0..63 to the base64 alphabet by range offsets
+        __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        offsets = _mm_sub_epi8(offsets, _mm_cmpgt_epi8(indices, _mm_set1_epi8(25)));
+        const __m128i ascii = _mm_add_epi8(indices, _mm_shuffle_epi8(translate, offsets));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output), ascii);
+        input += 12;
+        output += 16;
+        encoded += 4;
+    }
+    return encoded;
+}
+
+/**
+ * @name cpuHasSsse3
+ * @brief Returns whether the running CPU supports SSSE3
+ * @author Callum Thompson
+ */
+bool cpuHasSsse3()
+{
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+#endif
+}
+
+/**
+ * @name StreamingBodyDevice (constructor)
+ * @brief Initializes an empty request body
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+StreamingBodyDevice::StreamingBodyDevice(QObject *parent)
+    : QIODevice(parent)
+{
+    // No logic body
+}
+
+/**
+ * @name appendRaw
+ * @brief Appends bytes to the body unchanged
+ * @details Used for the JSON envelope around the payload.
+ * @param[in] bytes: Bytes to append
+ * @author Callum Thompson
+ */
+void StreamingBodyDevice::appendRaw(const QByteArray &bytes)
+{
+    appendPart({bytes, nullptr, 0, 0, bytes.size()});
+}
+
+/**
+ * @name appendJsonString
+ * @brief Appends text to the body as a quoted, escaped JSON string
+ * @details The text is converted directly to escaped UTF-8 in one pass.
+ * @param[in] text: Text to append
+ * @author Callum Thompson
+ */
+void StreamingBodyDevice::appendJsonString(QStringView text)
+{
+    QByteArray escaped;
+    escaped.reserve(text.size() + text.size() / 8 + 2);
+    escaped.append('"');
+    appendEscapedJson(escaped, text);
+    escaped.append('"');
+    appendRaw(escaped);
+}
+
+/**
+ * @name appendBase64File
+ * @brief Appends the base64 encoding of a file to the body
+ * @details The file is memory-mapped and stays open for the lifetime of the
+ * device. Nothing is read or encoded until the body is read.
+ * @param[in] filePath: Path to the file
+ * @return True if the file could be mapped
+ * @author Callum Thompson
+ */
+bool StreamingBodyDevice::appendBase64File(const QString &filePath)
+{
+    QFile *file = new QFile(filePath, this);
+    if (!file->open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Could not open file for streaming:" << filePath;
+        delete file;
+        return false;
+    }
+
+    qint64 length = file->size();
+    const uchar *mapped = nullptr;
+    if (length > 0)
+    {
+        mapped = file->map(0, length);
+        if (!mapped)
+        {
+            qWarning() << "Could not map file for streaming:" << filePath;
+            delete file;
+            return false;
+        }
+    }
+
+    appendPart({QByteArray(), mapped, length, 0, (length + 2) / 3 * 4});
+    return true;
+}
+
+/**
+ * @name appendBase64Data
+ * @brief Appends the base64 encoding of in-memory data to the body
+ * @details The data is shared, not copied, and encoded as the body is read.
+ * @param[in] bytes: Data to encode
+ * @author Callum Thompson
+ */
+void StreamingBodyDevice::appendBase64Data(const QByteArray &bytes)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+    appendPart({bytes, bytes.isEmpty() ? nullptr : data, bytes.size(), 0, (bytes.size() + 2) / 3 * 4});
+}
+
+/**
+ * @name open
+ * @brief Opens the device for reading
+ * @details The body is read-only.
+ * @param[in] mode: Open mode; must be read-only
+ * @return True if the device was opened
+ * @author Callum Thompson
+ */
+bool StreamingBodyDevice::open(OpenMode mode)
+{
+    if (mode & QIODevice::WriteOnly)
+    {
+        qWarning() << "StreamingBodyDevice is read-only.";
+        return false;
+    }
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+/**
+ * @name isSequential
+ * @brief Reports that the device supports random access
+ * @details Allows the network stack to rewind the body if it has to resend it.
+ * @return Always false
+ * @author Callum Thompson
+ */
+bool StreamingBodyDevice::isSequential() const
+{
+    return false;
+}
+
+/**
+ * @name size
+ * @brief Returns the total size of the body
+ * @return Body size in bytes
+ * @author Callum Thompson
+ */
+qint64 StreamingBodyDevice::size() const
+{
+    return totalSize;
+}
+
+/**
+ * @name readData
+ * @brief Produces the next block of the body
+ * @details Copies raw parts and encodes mapped files on the fly, starting at
+ * the current position of the device.
+ * @param[out] data: Destination buffer
+ * @param[in] maxSize: Maximum number of bytes to produce
+ * @return Number of bytes produced, or 0 at the end of the body
+ * @author Callum Thompson
+ */
+qint64 StreamingBodyDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 position = pos();
+    qint64 produced = 0;
+
+    for (const Part &part : parts)
+    {
+        if (produced == maxSize)
+        {
+            break;
+        }
+
+        qint64 partEnd = part.outputOffset + part.outputLength;
+        if (position >= partEnd)
+        {
+            continue; // Already read past this part
+        }
+
+        qint64 offset = position - part.outputOffset;
+        qint64 count = qMin(maxSize - produced, part.outputLength - offset);
+        if (part.mapped)
+        {
+            count = readBase64(part, offset, data + produced, count);
+        }
+        else
+        {
+            std::memcpy(data + produced, part.bytes.constData() + offset, count);
+        }
+
+        produced += count;
+        position += count;
+    }
+
+    return produced;
+}
+
+/**
+ * @name writeData
+ * @brief Rejects writes, since the body is read-only
+ * @return Always -1
+ * @author Callum Thompson
+ */
+qint64 StreamingBodyDevice::writeData(const char *, qint64)
+{
+    return -1;
+}
+
+/**
+ * @name appendEscapedJson
+ * @brief Appends text as escaped UTF-8 suitable for a JSON string literal
+ * @details Quotes, backslashes and control characters are escaped; all other
+ * characters are encoded as UTF-8.
+ * @param[in,out] out: Buffer to append to
+ * @param[in] text: Text to escape
+ * @author Callum Thompson
+ */
+void StreamingBodyDevice::appendEscapedJson(QByteArray &out, QStringView text)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    qsizetype runStart = 0;
+    for (qsizetype i = 0; i < text.size(); ++i)
+    {
+        char16_t c = text[i].unicode();
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue; // Part of a run copied as UTF-8 below
+        }
+
+        out.append(text.mid(runStart, i - runStart).toUtf8());
+        runStart = i + 1;
+
+        switch (c)
+        {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            out.append("\\u00");
+            out.append(hexDigits[(c >> 4) & 0xF]);
+            out.append(hexDigits[c & 0xF]);
+            break;
+        }
+    }
+    out.append(text.mid(runStart).toUtf8());
+}
+
+/**
+ * @name encodeBase64
+ * @brief Encodes bytes as padded base64
+ * @details Complete groups are encoded with SSSE3 when the CPU supports it,
+ * falling back to the scalar encoder for the remainder and on other CPUs.
+ * @param[in] input: Bytes to encode
+ * @param[in] length: Number of bytes to encode
+ * @param[out] output: Destination; must hold (length + 2) / 3 * 4 bytes
+ * @return Number of characters written
+ * @author Callum Thompson
+ */
+qint64 StreamingBodyDevice::encodeBase64(const uchar *input, qint64 length, char *output)
+{
+    qint64 groups = length / 3;
+    qint64 encoded = 0;
+
+#ifdef STREAMINGBODY_HAVE_SSSE3
+    if (cpuHasSsse3())
+    {
+        encoded = encodeBase64Ssse3(input, groups, output);
+    }
+#endif
+    encodeBase64Scalar(input + encoded * 3, groups - encoded, output + encoded * 4);
+
+    // Pad the final partial group
+    qint64 remaining = length - groups * 3;
+    char *tail = output + groups * 4;
+    if (remaining > 0)
+    {
+        const uchar *last = input + groups * 3;
+        quint32 triple = quint32(last[0]) << 16;
+        if (remaining == 2)
+        {
+            triple |= quint32(last[1]) << 8;
+        }
+        tail[0] = base64Alphabet[(triple >> 18) & 0x3F];
+        tail[1] = base64Alphabet[(triple >> 12) & 0x3F];
+        tail[2] = remaining == 2 ? base64Alphabet[(triple >> 6) & 0x3F] : '=';
+        tail[3] = '=';
+        return groups * 4 + 4;
+    }
+    return groups * 4;
+}
+
+/**
+ * @name appendPart
+ * @brief Adds a part to the end of the body
+ * @param[in] part: Part to add
+ * @author Callum Thompson
+ */
+void StreamingBodyDevice::appendPart(const Part &part)
+{
+    Part positioned = part;
+    positioned.outputOffset = totalSize;
+    totalSize += positioned.outputLength;
+    parts.append(positioned);
+}
+
+/**
+ * @name readBase64
+ * @brief Encodes part of a mapped file starting at an output offset
+ * @details Whole groups are encoded straight into the destination. A group
+ * split by the start or end of the requested range is encoded into a small
+ * scratch buffer and the needed characters copied out.
+ * @param[in] part: Mapped file part
+ * @param[in] offset: Offset within the part's base64 output
+ * @param[out] data: Destination buffer
+ * @param[in] maxSize: Number of characters to produce
+ * @return Number of characters produced
+ * @author Callum Thompson
+ */
+qint64 StreamingBodyDevice::readBase64(const Part &part, qint64 offset, char *data, qint64 maxSize) const
+{
+    qint64 produced = 0;
+    char scratch[4];
+
+    while (produced < maxSize)
+    {
+        qint64 group = offset / 4;
+        qint64 within = offset % 4;
+        qint64 inputOffset = group * 3;
+        qint64 inputRemaining = part.inputLength - inputOffset;
+
+        if (within == 0 && maxSize - produced >= 4)
+        {
+            // Encode as many whole groups as fit directly into the destination
+            qint64 groups = qMin((maxSize - produced) / 4, (inputRemaining + 2) / 3);
+            qint64 inputLength = qMin(groups * 3, inputRemaining);
+            qint64 written = encodeBase64(part.mapped + inputOffset, inputLength, data + produced);
+            produced += written;
+            offset += written;
+            continue;
+        }
+
+        // Encode a single group and copy the part of it that was requested
+        encodeBase64(part.mapped + inputOffset, qMin<qint64>(3, inputRemaining), scratch);
+        qint64 count = qMin(4 - within, maxSize - produced);
+        std::memcpy(data + produced, scratch + within, count);
+        produced += count;
+        offset += count;
+    }
+
+    return produced;
+}
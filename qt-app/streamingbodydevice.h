@@ -0,0 +1,72 @@
+/**
+ * @file streamingbodydevice.h
+ * @brief Declaration of StreamingBodyDevice class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 4, 2025
+ */
+
+#ifndef STREAMINGBODYDEVICE_H
+#define STREAMINGBODYDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QList>
+#include <QFile>
+#include <QStringView>
+
+/**
+ * @class StreamingBodyDevice
+ * @brief Read-only device that produces a JSON request body on demand
+ * @details The body is described as a sequence of parts: raw bytes (the JSON
+ * envelope), JSON string literals, and files that are base64-encoded. Files are
+ * memory-mapped and encoded block by block as the network stack reads from the
+ * device, so an audio recording is never held in memory as a whole, let alone
+ * as base64 text. The total size is known up front, so the request is sent
+ * with a Content-Length and the device can be rewound if Qt needs to resend it.
+ * @author Callum Thompson
+ */
+class StreamingBodyDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit StreamingBodyDevice(QObject *parent = nullptr);
+
+    void appendRaw(const QByteArray &bytes);
+    void appendJsonString(QStringView text);
+    bool appendBase64File(const QString &filePath);
+    void appendBase64Data(const QByteArray &bytes);
+
+    bool open(OpenMode mode) override;
+    bool isSequential() const override;
+    qint64 size() const override;
+
+    static void appendEscapedJson(QByteArray &out, QStringView text);
+    static qint64 encodeBase64(const uchar *input, qint64 length, char *output);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    /**
+     * @brief A contiguous piece of the request body
+     */
+    struct Part
+    {
+        QByteArray bytes;            // Raw bytes, or the owner of the data mapped points into
+        const uchar *mapped;         // Contents to base64-encode, null for raw bytes
+        qint64 inputLength;          // Length of the mapped file contents
+        qint64 outputOffset;         // Offset of this part within the body
+        qint64 outputLength;         // Number of body bytes produced by this part
+    };
+
+    QList<Part> parts;
+    qint64 totalSize = 0;
+
+    void appendPart(const Part &part);
+    qint64 readBase64(const Part &part, qint64 offset, char *data, qint64 maxSize) const;
+};
+
+#endif // STREAMINGBODYDEVICE_H
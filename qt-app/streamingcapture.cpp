@@ -0,0 +1,604 @@
+/**
+ * @file streamingcapture.cpp
+ * @brief Definition of StreamingCapture class
+ *
+ * Captures raw PCM with QAudioSource. Nothing on the capture path touches
+ * the disk, the network or a lock; all file writing happens on a separate
+ * processing thread fed through a ring buffer.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 10, 2025
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+#include "streamingcapture.h"
+#include "audiometadata.h"
+#include "audioresampler.h"
+#include "flacencoder.h"
+#include "voiceactivitydetector.h"
+
+namespace
+{
+const int bufferSecs = 4;          // Audio the ring buffer can hold while the processing thread is busy
+const int blockFrames = 1024;      // Frames drained from the ring buffer at once
+const int idleSleepMs = 10;        // Wait when the ring buffer is empty
+const int pauseWindowMs = 2000;    // Recent audio searched for a pause
+const int maxBoundaryDelaySecs = 5; // Longest a segment waits past its length for a pause
+
+/**
+ * @class RingBufferSink
+ * @brief Write-only device that QAudioSource pushes captured audio into
+ * @details Copies whole frames into the ring buffer through a scratch
+ * buffer allocated up front, holding back any partial frame until the rest
+ * arrives. Never blocks.
+ */
+class RingBufferSink : public QIODevice
+{
+public:
+    RingBufferSink(PcmRingBuffer *ringBuffer, int frameBytes)
+        : ringBuffer(ringBuffer), frameBytes(frameBytes), scratch(blockFrames * frameBytes / 2)
+    {
+        partial.reserve(frameBytes);
+    }
+
+protected:
+    qint64 readData(char *, qint64) override
+    {
+        return -1;
+    }
+
+    qint64 writeData(const char *data, qint64 length) override
+    {
+        qint64 offset = 0;
+
+        // Complete a frame split across callbacks
+        if (!partial.isEmpty())
+        {
+            qint64 needed = qMin<qint64>(frameBytes - partial.size(), length);
+            partial.append(data, needed);
+            offset = needed;
+            if (partial.size() < frameBytes)
+            {
+                return length;
+            }
+            std::memcpy(scratch.data(), partial.constData(), frameBytes);
+            ringBuffer->write(scratch.constData(), frameBytes / 2);
+            partial.clear();
+        }
+
+        // Copy whole frames, via scratch so the samples are aligned
+        qint64 scratchBytes = qint64(scratch.size()) * 2;
+        while (length - offset >= frameBytes)
+        {
+            qint64 bytes = qMin(scratchBytes, (length - offset) / frameBytes * frameBytes);
+            std::memcpy(scratch.data(), data + offset, bytes);
+            ringBuffer->write(scratch.constData(), bytes / 2);
+            offset += bytes;
+        }
+        partial.append(data + offset, length - offset);
+        return length;
+    }
+
+private:
+    PcmRingBuffer *ringBuffer;
+    int frameBytes;
+    QVector<qint16> scratch;
+    QByteArray partial;
+};
+}
+
+/**
+ * @name StreamingCapture (constructor)
+ * @brief Creates an idle capture
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+StreamingCapture::StreamingCapture(QObject *parent)
+    : QObject(parent)
+{
+    // No logic body
+}
+
+/**
+ * @name ~StreamingCapture (destructor)
+ * @brief Stops any recording in progress and waits for its files to close
+ * @author Callum Thompson
+ */
+StreamingCapture::~StreamingCapture()
+{
+    if (processingThread)
+    {
+        source->stop();
+        stopRequested.store(true, std::memory_order_release);
+        processingThread->wait();
+        releaseCapture();
+    }
+    delete ringBuffer;
+}
+
+/**
+ * @name setSegmentLength
+ * @brief Configures the segment length and the overlap between segments
+ * @details Takes effect from the next recording.
+ * @param[in] newSegmentSecs: Seconds recorded before the next segment may start
+ * @param[in] newOverlapSecs: Seconds both segments record at each boundary
+ * @author Callum Thompson
+ */
+void StreamingCapture::setSegmentLength(int newSegmentSecs, int newOverlapSecs)
+{
+    segmentSecs = qMax(1, newSegmentSecs);
+    overlapSecs = qBound(0, newOverlapSecs, segmentSecs - 1);
+}
+
+/**
+ * @name setAudioFormat
+ * @brief Configures the format of the files written
+ * @details Takes effect from the next recording. The microphone is opened
+ * in its preferred format and converted, so the files always have exactly
+ * this format.
+ * @param[in] newSampleRate: Sample rate in Hz
+ * @param[in] newChannelCount: Number of channels
+ * @author Callum Thompson
+ */
+void StreamingCapture::setAudioFormat(int newSampleRate, int newChannelCount)
+{
+    sampleRate = newSampleRate;
+    channelCount = newChannelCount;
+}
+
+/**
+ * @name setCompressedCopy
+ * @brief Enables writing a FLAC copy of the recording next to the WAV file
+ * @details Takes effect from the next recording. The copy is encoded while
+ * recording, so it is complete as soon as the recording stops.
+ * @param[in] enabled: True to write the FLAC copy
+ * @author Callum Thompson
+ */
+void StreamingCapture::setCompressedCopy(bool enabled)
+{
+    compressedCopy = enabled;
+}
+
+/**
+ * @name start
+ * @brief Opens the microphone and starts recording
+ * @details The whole recording is written to `newRecordingPath`; segment
+ * files are written next to it, named after it with the segment index
+ * appended (e.g. `output_seg000.wav`). If the microphone opens but then
+ * fails to start, the files are still closed and recordingFinished() is
+ * emitted.
+ * @param[in] device: Microphone to record from
+ * @param[in] newRecordingPath: WAV file of the whole recording
+ * @return True if recording started
+ * @author Callum Thompson
+ */
+bool StreamingCapture::start(const QAudioDevice &device, const QString &newRecordingPath)
+{
+    if (recording)
+    {
+        qWarning() << "Streaming capture already in progress.";
+        return false;
+    }
+
+    // Capture 16-bit samples at the microphone's own rate and channel count
+    inputFormat = device.preferredFormat();
+    inputFormat.setSampleFormat(QAudioFormat::Int16);
+    if (!device.isFormatSupported(inputFormat))
+    {
+        inputFormat.setSampleRate(sampleRate);
+        inputFormat.setChannelCount(channelCount);
+        if (!device.isFormatSupported(inputFormat))
+        {
+            qWarning() << "Microphone does not support 16-bit capture:" << device.description();
+            return false;
+        }
+    }
+
+    // Open the output files before any audio arrives
+    recordingPath = newRecordingPath;
+    recordingOutput = openWav(recordingPath, -1);
+    if (!recordingOutput)
+    {
+        return false;
+    }
+    if (compressedCopy)
+    {
+        QFileInfo info(recordingPath);
+        flacFile.setFileName(info.dir().filePath(info.completeBaseName() + ".flac"));
+        if (flacFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            encoder = new FlacEncoder(sampleRate, channelCount);
+            flacFile.write(encoder->streamHeader()); // Rewritten once the totals are known
+        }
+        else
+        {
+            qWarning() << "Could not create compressed copy:" << flacFile.fileName();
+        }
+    }
+
+    resampler = new AudioResampler(inputFormat.sampleRate(), inputFormat.channelCount(), sampleRate, channelCount);
+    delete ringBuffer; // Kept after the previous recording for statistics()
+    ringBuffer = new PcmRingBuffer(qint64(inputFormat.sampleRate()) * inputFormat.channelCount() * bufferSecs);
+    recentAudio.clear();
+    nextIndex = 0;
+    if (WavOutput *first = openWav(segmentPath(nextIndex), nextIndex))
+    {
+        segments.append(first);
+    }
+    ++nextIndex;
+
+    stopRequested.store(false, std::memory_order_release);
+    recording = true;
+    stopping = false;
+
+    processingThread = QThread::create([this]() { processAudio(); });
+    connect(processingThread, &QThread::finished, this, &StreamingCapture::releaseCapture);
+    processingThread->start();
+
+    sink = new RingBufferSink(ringBuffer, inputFormat.bytesPerFrame());
+    sink->open(QIODevice::WriteOnly);
+    source = new QAudioSource(device, inputFormat, this);
+    source->start(sink);
+    if (source->error() != QAudio::NoError)
+    {
+        qWarning() << "Could not start audio capture, error" << source->error();
+        stop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @name stop
+ * @brief Stops capturing
+ * @details The processing thread writes the audio still buffered and closes
+ * every file; recordingFinished() is emitted once it has.
+ * @author Callum Thompson
+ */
+void StreamingCapture::stop()
+{
+    if (!recording || stopping)
+    {
+        return;
+    }
+
+    stopping = true;
+    source->stop(); // No more audio is written to the ring buffer after this
+    stopRequested.store(true, std::memory_order_release);
+}
+
+/**
+ * @name pause
+ * @brief Suspends capture
+ * @author Callum Thompson
+ */
+void StreamingCapture::pause()
+{
+    if (recording && !stopping)
+    {
+        source->suspend();
+    }
+}
+
+/**
+ * @name resume
+ * @brief Resumes capture after pause()
+ * @author Callum Thompson
+ */
+void StreamingCapture::resume()
+{
+    if (recording && !stopping)
+    {
+        source->resume();
+    }
+}
+
+/**
+ * @name isRecording
+ * @brief Returns whether a recording is in progress
+ * @return True from start() until recordingFinished() is emitted
+ * @author Callum Thompson
+ */
+bool StreamingCapture::isRecording() const
+{
+    return recording;
+}
+
+/**
+ * @name statistics
+ * @brief Returns the health counters of the current or last recording
+ * @details Safe to call while recording.
+ * @return Dropped frames and ring buffer usage
+ * @author Callum Thompson
+ */
+CaptureStatistics StreamingCapture::statistics() const
+{
+    CaptureStatistics stats;
+    if (ringBuffer)
+    {
+        int channels = qMax(1, inputFormat.channelCount());
+        stats.droppedFrames = ringBuffer->droppedSamples() / channels;
+        stats.highWaterFrames = ringBuffer->highWaterMark() / channels;
+        stats.capacityFrames = ringBuffer->capacity() / channels;
+    }
+    return stats;
+}
+
+/**
+ * @name processAudio
+ * @brief Body of the processing thread
+ * @details Drains the ring buffer until capture has stopped and everything
+ * captured has been written.
+ * @author Callum Thompson
+ */
+void StreamingCapture::processAudio()
+{
+    int inputChannels = inputFormat.channelCount();
+    QVector<qint16> input(blockFrames * inputChannels);
+    QVector<qint16> converted;
+
+    while (true)
+    {
+        // Checked before reading, so an empty read after a stop means fully drained
+        bool stopped = stopRequested.load(std::memory_order_acquire);
+        qint64 count = ringBuffer->read(input.data(), input.size());
+        if (count == 0)
+        {
+            if (stopped)
+            {
+                break;
+            }
+            QThread::msleep(idleSleepMs);
+            continue;
+        }
+
+        if (resampler->isPassthrough())
+        {
+            consume(input.constData(), count / inputChannels);
+            continue;
+        }
+        converted.clear();
+        resampler->process(input.constData(), count / inputChannels, converted);
+        consume(converted.constData(), converted.size() / channelCount);
+    }
+
+    converted.clear();
+    if (!resampler->isPassthrough())
+    {
+        resampler->flush(converted);
+    }
+    consume(converted.constData(), converted.size() / channelCount);
+    finishRecording();
+}
+
+/**
+ * @name consume
+ * @brief Passes converted audio to every consumer
+ * @param[in] samples: Interleaved samples in the output format
+ * @param[in] frames: Number of frames
+ * @author Callum Thompson
+ */
+void StreamingCapture::consume(const qint16 *samples, qint64 frames)
+{
+    if (frames <= 0)
+    {
+        return;
+    }
+    qint64 bytes = frames * channelCount * 2;
+
+    recordingOutput->file.write(reinterpret_cast<const char *>(samples), bytes);
+    recordingOutput->frames += frames;
+
+    if (encoder)
+    {
+        QByteArray encoded;
+        encoder->encode(samples, frames, encoded);
+        flacFile.write(encoded);
+    }
+
+    // Keep the most recent audio for finding pauses
+    qint64 windowSamples = qint64(sampleRate) * pauseWindowMs / 1000 * channelCount;
+    qsizetype end = recentAudio.size();
+    recentAudio.resize(end + frames * channelCount);
+    std::copy(samples, samples + frames * channelCount, recentAudio.begin() + end);
+    if (recentAudio.size() > windowSamples)
+    {
+        recentAudio.remove(0, recentAudio.size() - windowSamples);
+    }
+
+    writeSegments(samples, frames);
+}
+
+/**
+ * @name writeSegments
+ * @brief Writes audio to the open segments and moves to the next segment
+ * @details Once the current segment has reached its length, the next one
+ * starts at the first pause, or after a few seconds if the speaker does not
+ * pause. The previous segment then keeps recording for the overlap.
+ * @param[in] samples: Interleaved samples in the output format
+ * @param[in] frames: Number of frames
+ * @author Callum Thompson
+ */
+void StreamingCapture::writeSegments(const qint16 *samples, qint64 frames)
+{
+    // Copy the list, since closing a segment removes it from segments
+    const QList<WavOutput *> open = segments;
+    for (WavOutput *segment : open)
+    {
+        qint64 count = segment->remainingFrames < 0 ? frames : qMin(frames, segment->remainingFrames);
+        segment->file.write(reinterpret_cast<const char *>(samples), count * channelCount * 2);
+        segment->frames += count;
+        if (segment->remainingFrames >= 0)
+        {
+            segment->remainingFrames -= count;
+            if (segment->remainingFrames == 0)
+            {
+                closeWav(segment);
+            }
+        }
+    }
+
+    WavOutput *current = segments.isEmpty() ? nullptr : segments.last();
+    qint64 segmentFrames = qint64(segmentSecs) * sampleRate;
+    if (!current || current->remainingFrames >= 0 || current->frames < segmentFrames)
+    {
+        return;
+    }
+    if (current->frames < segmentFrames + qint64(maxBoundaryDelaySecs) * sampleRate && !atPause())
+    {
+        return;
+    }
+
+    current->remainingFrames = qint64(overlapSecs) * sampleRate;
+    if (current->remainingFrames == 0)
+    {
+        closeWav(current);
+    }
+    WavOutput *next = openWav(segmentPath(nextIndex), nextIndex);
+    ++nextIndex;
+    if (next)
+    {
+        segments.append(next);
+    }
+}
+
+/**
+ * @name atPause
+ * @brief Returns whether the speaker has just paused
+ * @return True if the most recent audio contains no speech
+ * @author Callum Thompson
+ */
+bool StreamingCapture::atPause() const
+{
+    VoiceActivityDetector detector(sampleRate, channelCount);
+    detector.setKeptSilence(0);
+    qint64 frames = recentAudio.size() / channelCount;
+    QList<VoiceActivityDetector::Span> speech = detector.detectSpeech(recentAudio.constData(), frames);
+
+    // Speech spans include a hangover, so a span ending early means a real pause
+    return speech.isEmpty() || speech.last().end < frames;
+}
+
+/**
+ * @name openWav
+ * @brief Creates a WAV file with a placeholder header
+ * @param[in] path: Path of the file
+ * @param[in] index: Segment index, or -1 for the whole recording
+ * @return Open output, or nullptr if the file could not be created
+ * @author Callum Thompson
+ */
+StreamingCapture::WavOutput *StreamingCapture::openWav(const QString &path, int index) const
+{
+    WavOutput *output = new WavOutput;
+    output->index = index;
+    output->file.setFileName(path);
+    if (!output->file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Could not create audio file:" << path;
+        delete output;
+        return nullptr;
+    }
+    output->file.write(AudioMetadata::wavHeader(sampleRate, channelCount, 0));
+    return output;
+}
+
+/**
+ * @name closeWav
+ * @brief Completes the header of a WAV file and closes it
+ * @details segmentFinished() is emitted for segment files.
+ * @param[in] output: Output to close; deleted by this function
+ * @author Callum Thompson
+ */
+void StreamingCapture::closeWav(WavOutput *output)
+{
+    segments.removeOne(output);
+    output->file.seek(0);
+    output->file.write(AudioMetadata::wavHeader(sampleRate, channelCount, output->frames * channelCount * 2));
+    output->file.close();
+
+    if (output->index >= 0)
+    {
+        emit segmentFinished(output->index, output->file.fileName());
+    }
+    delete output;
+}
+
+/**
+ * @name finishRecording
+ * @brief Closes every file once capture has stopped
+ * @details Runs on the processing thread.
+ * @author Callum Thompson
+ */
+void StreamingCapture::finishRecording()
+{
+    const QList<WavOutput *> open = segments;
+    for (WavOutput *segment : open)
+    {
+        closeWav(segment);
+    }
+    closeWav(recordingOutput);
+    recordingOutput = nullptr;
+
+    if (encoder)
+    {
+        QByteArray encoded;
+        encoder->finish(encoded);
+        flacFile.write(encoded);
+        flacFile.seek(0);
+        flacFile.write(encoder->streamHeader());
+        flacFile.close();
+    }
+}
+
+/**
+ * @name releaseCapture
+ * @brief Frees the capture objects after the processing thread has finished
+ * @details Runs on the main thread and emits recordingFinished(). The ring
+ * buffer is kept so statistics() still describes the last recording.
+ * @author Callum Thompson
+ */
+void StreamingCapture::releaseCapture()
+{
+    CaptureStatistics stats = statistics();
+    if (stats.droppedFrames > 0)
+    {
+        qWarning() << "Streaming capture dropped" << stats.droppedFrames << "frames";
+    }
+    qInfo() << "Capture buffer high-water mark:" << stats.highWaterFrames << "of" << stats.capacityFrames << "frames";
+
+    delete source;
+    source = nullptr;
+    delete sink;
+    sink = nullptr;
+    processingThread->deleteLater();
+    processingThread = nullptr;
+    delete resampler;
+    resampler = nullptr;
+    delete encoder;
+    encoder = nullptr;
+
+    recording = false;
+    stopping = false;
+    emit recordingFinished(nextIndex);
+}
+
+/**
+ * @name segmentPath
+ * @brief Builds the file path for a segment
+ * @param[in] index: Segment index
+ * @return Path of the segment file
+ * @author Callum Thompson
+ */
+QString StreamingCapture::segmentPath(int index) const
+{
+    QFileInfo baseInfo(recordingPath);
+    QString fileName = QString("%1_seg%2.%3")
+                           .arg(baseInfo.completeBaseName())
+                           .arg(index, 3, 10, QChar('0'))
+                           .arg(baseInfo.suffix().isEmpty() ? "wav" : baseInfo.suffix());
+    return baseInfo.dir().filePath(fileName);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file streamingcapture.h
+ * @brief Declaration of CaptureStatistics struct and StreamingCapture class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 10, 2025
+ */
+
+#ifndef STREAMINGCAPTURE_H
+#define STREAMINGCAPTURE_H
+
+#include <atomic>
+#include <QObject>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QAudioSource>
+#include <QFile>
+#include <QList>
+#include <QThread>
+#include <QVector>
+#include "pcmringbuffer.h"
+
+class AudioResampler;
+class FlacEncoder;
+
+/**
+ * @struct CaptureStatistics
+ * @brief Health counters of a streaming capture
+ * @details Frames are counted at the microphone's own format. Any dropped
+ * frames mean the processing thread fell behind for longer than the
+ * buffer could absorb.
+ * @author Callum Thompson
+ */
+struct CaptureStatistics
+{
+    qint64 droppedFrames = 0;    // Frames discarded because the buffer was full
+    qint64 highWaterFrames = 0;  // Most frames waiting in the buffer at once
+    qint64 capacityFrames = 0;   // Frames the buffer holds
+};
+
+/**
+ * @class StreamingCapture
+ * @brief Records from a microphone through QAudioSource and processes the
+ * audio while it is captured
+ * @details The capture callback only copies PCM frames into a lock-free
+ * ring buffer. A processing thread drains the buffer, converts the audio to
+ * the requested format and feeds every consumer from the same samples: the
+ * WAV file of the whole recording, an optional FLAC copy, and rolling
+ * segment files for live transcription. Segments overlap like those of
+ * SegmentedRecorder, but each boundary is placed at the first pause found
+ * by VoiceActivityDetector after the segment length, so words are rarely
+ * cut. The signals match SegmentedRecorder so either can drive live
+ * transcription.
+ * @author Callum Thompson
+ */
+class StreamingCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StreamingCapture(QObject *parent = nullptr);
+    ~StreamingCapture();
+
+    void setSegmentLength(int segmentSecs, int overlapSecs);
+    void setAudioFormat(int sampleRate, int channelCount);
+    void setCompressedCopy(bool enabled);
+    bool start(const QAudioDevice &device, const QString &recordingPath);
+    void stop();
+    void pause();
+    void resume();
+    bool isRecording() const;
+    CaptureStatistics statistics() const;
+
+signals:
+    void segmentFinished(int index, const QString &filePath); // Segment file has been finalized
+    void recordingFinished(int segmentCount);                 // All files have been finalized after stop()
+
+private:
+    /**
+     * @brief WAV file being written by the processing thread
+     */
+    struct WavOutput
+    {
+        int index;                  // Segment index, or -1 for the whole recording
+        QFile file;
+        qint64 frames = 0;          // Frames written so far
+        qint64 remainingFrames = -1; // Frames left before the file is closed, or -1 while open-ended
+    };
+
+    // Owned by the main thread
+    QAudioSource *source = nullptr;   // Delivers captured audio to sink
+    QIODevice *sink = nullptr;        // Copies captured audio into ringBuffer
+    QThread *processingThread = nullptr;
+    QString recordingPath;            // WAV file of the whole recording
+    int segmentSecs = 45;             // Length of each segment before the next starts
+    int overlapSecs = 2;              // Time both segments record at a boundary
+    int sampleRate = 16000;           // Sample rate of the files written
+    int channelCount = 1;             // Channel count of the files written
+    bool compressedCopy = false;      // Also write a FLAC copy of the recording
+    bool recording = false;
+    bool stopping = false;
+
+    // Shared between the capture callback and the processing thread
+    PcmRingBuffer *ringBuffer = nullptr;
+    QAudioFormat inputFormat;         // Format delivered by the microphone
+    std::atomic<bool> stopRequested{false};
+
+    // Owned by the processing thread while recording
+    AudioResampler *resampler = nullptr;
+    FlacEncoder *encoder = nullptr;
+    QFile flacFile;
+    WavOutput *recordingOutput = nullptr;
+    QList<WavOutput *> segments;      // Segments still being written, oldest first
+    QVector<qint16> recentAudio;      // Last few seconds, searched for pauses
+    int nextIndex = 0;                // Index assigned to the next segment
+
+    void processAudio();
+    void consume(const qint16 *samples, qint64 frames);
+    void writeSegments(const qint16 *samples, qint64 frames);
+    bool atPause() const;
+    WavOutput *openWav(const QString &path, int index) const;
+    void closeWav(WavOutput *output);
+    void finishRecording();
+    void releaseCapture();
+    QString segmentPath(int index) const;
+};
+
+#endif // STREAMINGCAPTURE_H
@@ -57,12 +57,25 @@ QString SummaryFormatter::formatBoldText(const QString &text) const
     return formattedText;
 }
 
+/**
+ * @name setGenerating
+ * @brief Sets whether the summary laid out next is still being generated
+ * @param[in] newGenerating: True while a streamed summary is incomplete
+ * @author Callum Thompson
+ */
+void SummaryFormatter::setGenerating(bool newGenerating)
+{
+    generating = newGenerating;
+}
+
 /**
  * @name addSection
  * @brief Adds a section to the summary layout
  * @param[in] section: Section content
  * @param[in, out] summaryLayout: Layout to add section to
  * @details Creates a label and text browser for the section, sets styling, and adds them to the layout.
+ * Empty sections of a summary still being generated are shown as pending;
+ * those of a completed summary are left empty.
  * @author Callum Thompson
  */
 void SummaryFormatter::addSection(const Section &section, QVBoxLayout *summaryLayout) const
@@ -72,7 +85,14 @@ void SummaryFormatter::addSection(const Section &section, QVBoxLayout *summaryLa
     QTextBrowser *sectionText = new QTextBrowser();
 
     // Set styling
-    sectionText->setHtml(formatBoldText(section.content)); // Use HTML formatting. Format any bold elements.
+    if (generating && section.content.isEmpty())
+    {
+        sectionText->setHtml("<i>Generating...</i>");
+    }
+    else
+    {
+        sectionText->setHtml(formatBoldText(section.content)); // Use HTML formatting. Format any bold elements.
+    }
     sectionText->setReadOnly(true);
     sectionText->setFixedHeight(150); // Adjust height as needed
 
@@ -27,6 +27,7 @@
  * The formatting of the summary is done using HTML tags.
  * The class is designed to be inherited by specific formatters that implement the generateLayout method.
  * The class uses the Strategy pattern to allow for different formatting strategies.
+ * While a summary is being generated, its empty sections are shown as pending.
  * @author Joelene Hales
  * @author Callum Thompson
  */
@@ -42,7 +43,11 @@ public:
     virtual void generateLayout(const Summary &summary, QVBoxLayout *summaryLayout) const = 0;
     virtual ~SummaryFormatter() = default; // Qt automatically manages memory of QObjects, no need for manual deletion
 
+    void setGenerating(bool generating);
+
 protected:
+    bool generating = false; // The summary is still being streamed; empty sections are pending
+
     QString formatBoldText(const QString &text) const;
     void clearLayout(QVBoxLayout *layout) const;
     void addSection(const Section &section, QVBoxLayout *summaryLayout) const;
@@ -9,57 +9,23 @@
  * @date Mar. 12, 2025
  */
 
+#include <algorithm>
 #include "summarygenerator.h"
+#include "summaryschema.h"
+#include "sectionindex.h"
 
 /**
  * @name SummaryGenerator
  * @brief Constructor for the SummaryGenerator class
- * @details Sends the transcript to the LLM and stores the structured response.
- * @param[in] transcript: Transcript to summarize
+ * @details The summary is filled in with setSummaryText() once the LLM has
+ * responded.
  * @param[in] parent: Parent object in Qt application
  * @author Joelene Hales
  */
 SummaryGenerator::SummaryGenerator(QObject *parent)
     : QObject(parent)
 {
-    // Create an LLMClient object
-    llmClient = LLMClient::getInstance();
-
-    // Connect the LLMClient signal to the handler
-    connect(llmClient, &LLMClient::responseReceived, this, &SummaryGenerator::handleLLMResponse, Qt::UniqueConnection);
-}
-
-/**
- * @name SendRequest
- * @brief Sends a request to the LLMClient
- * @param[in] prompt: Prompt to send to the LLMClient
- * @details Sends a request to the LLMClient with the given prompt
- * and stores the response in the summary object
- * @author Callum Thompson
- */
-void SummaryGenerator::sendRequest(Transcript &prompt)
-{
-    llmClient->sendRequest(prompt.getContent());
-}
-
-/**
- * @name handleLLMResponse
- * @brief Handles the LLM response and updates Summary object
- * @details This function is called when the LLMClient emits a responseReceived signal.
- * It extracts the relevant sections from the LLM response and updates the summary object.
- * The sections are extracted based on the expected format of the LLM response.
- * @param[in] response: Full LLM-generated summary
- * @author Callum Thompson
- */
-void SummaryGenerator::handleLLMResponse(const QString &response)
-{
-    // Create summaries for distinct summary sections.
-    summarizeIntervalHistory(response);
-    summarizePhysicalExamination(response);
-    summarizeCurrentStatus(response);
-    summarizePlan(response);
-
-    emit summaryReady(); // emit signal once all summary sections are ready to be shown to the user.
+    // No logic body
 }
 
 /**
@@ -88,7 +54,9 @@ void SummaryGenerator::setSummary(const Summary &newSummary)
  * @name setSummaryText
  * @brief Sets the summary object with the given text
  * @details Sets the summary object with the given text
- * The summary object is cleared before setting the new text.
+ * The summary object is cleared before setting the new text. A structured
+ * (JSON) response is read directly; any other text is searched for the
+ * markdown titles of the sections.
  * @param[in] summaryText: New summary text to set
  * @author Callum Thompson
  * @author Joelene Hales
@@ -103,121 +71,178 @@ void SummaryGenerator::setSummaryText(const QString &summaryText)
     summary.clear(); // Reset the current summary
 
     // Ensure LLM response follows expected structure
-    summarizeIntervalHistory(summaryText);
-    summarizePhysicalExamination(summaryText);
-    summarizeCurrentStatus(summaryText);
-    summarizePlan(summaryText);
+    if (!SummarySchema::parse(summaryText, summary))
+    {
+        const SectionIndex response(summaryText);
+        summarizeIntervalHistory(response);
+        summarizePhysicalExamination(response);
+        summarizeCurrentStatus(response);
+        summarizePlan(response);
+    }
 
     emit summaryReady(); // emit signal once all summary sections have been reset
 }
 
+/**
+ * @name setPartialSummaryText
+ * @brief Fills in the sections of a summary that has only partly been generated
+ * @details The LLM writes the sections in order, so a section is complete
+ * once the header of the next one has been received. Completed sections are
+ * extracted and the rest are left empty; sectionCompleted() is emitted for
+ * each section whose text changed. The plan is complete once the patient
+ * follow-up note has begun, and is otherwise only completed by
+ * setSummaryText(). A structured response is complete up to its last
+ * finished member.
+ * @param[in] partialText: Response of the LLM received so far
+ * @author Callum Thompson
+ */
+void SummaryGenerator::setPartialSummaryText(const QString &partialText)
+{
+    QStringList sections(NoteSections::FollowUpNote);
+    Summary structured;
+    if (SummarySchema::parsePartial(partialText, structured))
+    {
+        sections = {structured.getIntervalHistory(), structured.getPhysicalExamination(),
+                    structured.getCurrentStatus(), structured.getPlan()};
+    }
+    else
+    {
+        const SectionIndex response(partialText);
+        for (int i = 0; i < sections.size(); ++i)
+        {
+            NoteSections::Section section = NoteSections::Section(i);
+            if (!response.isComplete(section))
+            {
+                break;
+            }
+            sections[i] = extractSectionFromResponse(
+                response, section, section == NoteSections::Plan ? NoteSections::FollowUpNote : section);
+        }
+    }
+
+    QStringList previous = {summary.getIntervalHistory(), summary.getPhysicalExamination(),
+                            summary.getCurrentStatus(), summary.getPlan()};
+    summary.setIntervalHistory(sections[0]);
+    summary.setPhysicalExamination(sections[1]);
+    summary.setCurrentStatus(sections[2]);
+    summary.setPlan(sections[3]);
+
+    for (int i = 0; i < sections.size(); ++i)
+    {
+        if (!sections[i].isEmpty() && sections[i] != previous[i])
+        {
+            emit sectionCompleted(NoteSections::title(NoteSections::Section(i)).toString());
+        }
+    }
+}
+
 /**
  * @name summarizeIntervalHistory
  * @brief Extracts and stores the interval history section of the summary
  * @details This function extracts the interval history section from the LLM response
- * and stores it in the summary object. It uses a specific search pattern to find the
- * section header and extracts the text until the next section header.
- * @param[in] response: Full LLM-generated summary
+ * and stores it in the summary object. The section header is looked up in the index
+ * and the text is extracted until the next section header.
+ * @param[in] response: Index of the full LLM-generated summary
  * @author Callum Thompson
  * @author Joelene Hales
  */
-void SummaryGenerator::summarizeIntervalHistory(const QString &response)
+void SummaryGenerator::summarizeIntervalHistory(const SectionIndex &response)
 {
-    summary.setIntervalHistory(extractSectionFromResponse(response, "INTERVAL HISTORY", "PHYSICAL EXAMINATION"));
+    summary.setIntervalHistory(extractSectionFromResponse(response, NoteSections::IntervalHistory));
 }
 
 /**
  * @name summarizePhysicalExamination
  * @brief Extracts and stores the physical examination section of the summary
  * @details This function extracts the physical examination section from the LLM response
- * and stores it in the summary object. It uses a specific search pattern to find the
- * section header and extracts the text until the next section header.
- * @param[in] response: Full LLM-generated summary
+ * and stores it in the summary object. The section header is looked up in the index
+ * and the text is extracted until the next section header.
+ * @param[in] response: Index of the full LLM-generated summary
  * @author Callum Thompson
  * @author Joelene Hales
  */
-void SummaryGenerator::summarizePhysicalExamination(const QString &response)
+void SummaryGenerator::summarizePhysicalExamination(const SectionIndex &response)
 {
-    summary.setPhysicalExamination(extractSectionFromResponse(response, "PHYSICAL EXAMINATION", "CURRENT STATUS"));
+    summary.setPhysicalExamination(extractSectionFromResponse(response, NoteSections::PhysicalExamination));
 }
 
 /**
  * @name summarizeCurrentStatus
  * @brief Extracts and stores the current status section of the summary
  * @details This function extracts the current status section from the LLM response
- * and stores it in the summary object. It uses a specific search pattern to find the
- * section header and extracts the text until the next section header.
- * @param[in] response: Full LLM-generated summary
+ * and stores it in the summary object. The section header is looked up in the index
+ * and the text is extracted until the next section header.
+ * @param[in] response: Index of the full LLM-generated summary
  * @author Callum Thompson
  * @author Joelene Hales
  */
-void SummaryGenerator::summarizeCurrentStatus(const QString &response)
+void SummaryGenerator::summarizeCurrentStatus(const SectionIndex &response)
 {
-    summary.setCurrentStatus(extractSectionFromResponse(response, "CURRENT STATUS", "PLAN"));
+    summary.setCurrentStatus(extractSectionFromResponse(response, NoteSections::CurrentStatus));
 }
 
 /**
  * @name summarizePlan
  * @brief Extracts and stores the plan section of the summary
  * @details This function extracts the plan section from the LLM response
- * and stores it in the summary object. It uses a specific search pattern to find the
- * section header and extracts the text until the next section header.
- * @param[in] response: Full LLM-generated summary
+ * and stores it in the summary object. The section header is looked up in the index
+ * and the text is extracted through the patient follow-up note that closes the plan.
+ * @param[in] response: Index of the full LLM-generated summary
  * @author Callum Thompson
  * @author Joelene Hales
  */
-void SummaryGenerator::summarizePlan(const QString &response)
+void SummaryGenerator::summarizePlan(const SectionIndex &response)
 {
-    summary.setPlan(extractSectionFromResponse(response, "PLAN", "PHYSICAL EXAMINATION"));
+    summary.setPlan(extractSectionFromResponse(response, NoteSections::Plan, NoteSections::FollowUpNote));
 }
 
 /**
  * @name extractSectionFromResponse
  * @brief Extracts a specific section from the LLM response
- * @details This function extracts a specific section from the LLM response
- * based on the section name provided. It uses a specific search pattern to find the
- * section header and extracts the text until the next section header.
- * @param[in] response: Full text response from LLM
- * @param[in] sectionName: Section name to extract
- * @param[in] nextSectionName: Next section name to stop extraction
+ * @details This function returns the text of the section found by the
+ * index, up to the next section header. The text is copied only here, once
+ * it is trimmed.
+ * @param[in] response: Index of the text response from LLM
+ * @param[in] section: Section to extract
+ * @param[in] lastSection: Later section to extract through, e.g. the
+ * follow-up note that closes the plan; ignored if not found
  * @return Extracted text of the section
  * @author Callum Thompson
  * @author Joelene Hales
  */
-QString SummaryGenerator::extractSectionFromResponse(const QString &response, const QString &sectionName, const QString &nextSectionName)
+QString SummaryGenerator::extractSectionFromResponse(const SectionIndex &response, NoteSections::Section section,
+                                                     NoteSections::Section lastSection)
 {
-    // Define search parameters
-    QString searchPattern = "**" + sectionName + "**";
-    QString searchPatternAlt = "**" + sectionName + ":**";
-    int startIndex = response.indexOf(searchPattern, 0, Qt::CaseInsensitive);
-    int patternLength = searchPattern.length(); // Default to original pattern length
-
     // Handle case in which there was nothing returned by response
-    if (startIndex == -1)
+    if (!response.contains(section))
     {
-        startIndex = response.indexOf(searchPatternAlt, 0, Qt::CaseInsensitive);
-        if (startIndex == -1)
-        {
-            return "No " + sectionName.toLower() + " found.";
-        }
-        patternLength = searchPatternAlt.length(); // Use alt pattern length if matched
+        return NoteSections::notFoundText(section);
     }
 
-    // Look for the next section by name, allowing both **nextSection** and **nextSection:**
-    QString nextPattern = "**" + nextSectionName + "**";
-    QString nextPatternAlt = "**" + nextSectionName + ":**";
-
-    // Define end index for text returned by response
-    int endIndex = response.indexOf(nextPattern, startIndex + patternLength, Qt::CaseInsensitive);
-    if (endIndex == -1)
-        endIndex = response.indexOf(nextPatternAlt, startIndex + patternLength, Qt::CaseInsensitive);
-    if (endIndex == -1)
-        endIndex = response.length();
-
-    // Create a string representing the text returned by the response using the gathered indices
-    QString extractedSection = response.mid(startIndex + patternLength, endIndex - (startIndex + patternLength)).trimmed();
+    return response.sections(section, std::max(section, lastSection)).trimmed().toString();
+}
 
-    return extractedSection;
+/**
+ * @name sectionsFound
+ * @brief Returns how many sections the summary holds
+ * @details A section counts if it has text and is not reported as not found.
+ * @return Number of the interval history, physical examination, current
+ * status and plan sections found, from 0 to 4
+ * @author Callum Thompson
+ */
+int SummaryGenerator::sectionsFound() const
+{
+    const QString texts[] = {summary.getIntervalHistory(), summary.getPhysicalExamination(),
+                             summary.getCurrentStatus(), summary.getPlan()};
+    int found = 0;
+    for (int i = 0; i < NoteSections::FollowUpNote; ++i)
+    {
+        if (!texts[i].isEmpty() && texts[i] != NoteSections::notFoundText(NoteSections::Section(i)))
+        {
+            ++found;
+        }
+    }
+    return found;
 }
 
 /**
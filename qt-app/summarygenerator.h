@@ -18,14 +18,20 @@
 #include "transcript.h"
 #include "summary.h"
 #include "llmclient.h"
+#include "notesections.h"
+
+class SectionIndex;
 
 /**
  * @class SummaryGenerator
  * @brief Class to generate a summary from a transcript using LLM
- * @details This class is responsible for sending a transcript to the LLM and
- * receiving a structured summary in response. It extracts relevant sections from
- * the LLM response and stores them in a Summary object. The class also provides
- * a signal to notify when the summary is ready.
+ * @details This class turns the response of the LLM into a structured
+ * summary. It extracts relevant sections from the LLM response and stores
+ * them in a Summary object. Requests are sent by VisitQueue, so each
+ * response is attributed to the patient it was generated for. The class also provides
+ * a signal to notify when the summary is ready. While a summary is streamed,
+ * each section is reported as soon as the header of the next one arrives.
+ * Responses returned as JSON are read by SummarySchema instead.
  * @author Joelene Hales
  * @author Callum Thompson
  */
@@ -36,30 +42,29 @@ class SummaryGenerator : public QObject
 public:
    explicit SummaryGenerator(QObject *parent = nullptr);
    virtual ~SummaryGenerator() = default;
-   void sendRequest(Transcript &prompt);
 
    Summary getSummary();
+   int sectionsFound() const;
+   void setSummaryText(const QString &summaryText);
+   void setPartialSummaryText(const QString &partialText);
 
    friend class MainWindow;
 
 private:
-   LLMClient *llmClient;
    Summary summary;
 
-   QString extractSectionFromResponse(const QString &response, const QString &sectionName, const QString &nextSectionName);
+   QString extractSectionFromResponse(const SectionIndex &response, NoteSections::Section section,
+                                      NoteSections::Section lastSection = NoteSections::IntervalHistory);
 
-   void summarizeIntervalHistory(const QString &response);
-   void summarizePhysicalExamination(const QString &response);
-   void summarizeCurrentStatus(const QString &response);
-   void summarizePlan(const QString &response);
+   void summarizeIntervalHistory(const SectionIndex &response);
+   void summarizePhysicalExamination(const SectionIndex &response);
+   void summarizeCurrentStatus(const SectionIndex &response);
+   void summarizePlan(const SectionIndex &response);
    void setSummary(const Summary &summary);
-   void setSummaryText(const QString &summaryText);
-
-private slots:
-   void handleLLMResponse(const QString &response);
 
 signals:
    void summaryReady();
+   void sectionCompleted(const QString &sectionName); // Section of a partial summary is complete
 };
 
 #endif // SUMMARYGENERATOR_H
@@ -0,0 +1,255 @@
+/**
+ * @file summaryschema.cpp
+ * @brief Definition of SummarySchema class
+ *
+ * Response schema of a structured summary and the reading of its JSON.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 23, 2025
+ */
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QStringList>
+#include "summaryschema.h"
+
+using NoteSections::schema;
+
+/**
+ * @name responseSchema
+ * @brief Returns the schema of a structured summary
+ * @details Every section is required and keeps the order of the note, so
+ * a streamed response completes the sections in the usual order.
+ * Subsections are optional, as those not discussed are left out.
+ * @return Serialized responseSchema for the generation settings
+ * @author Callum Thompson
+ */
+const QByteArray &SummarySchema::responseSchema()
+{
+    static const QByteArray serialized = []()
+    {
+        QJsonObject properties;
+        QJsonArray order;
+        for (const NoteSections::Schema &section : schema)
+        {
+            QJsonObject property;
+            if (section.subsectionCount == 0)
+            {
+                property["type"] = "STRING";
+            }
+            else
+            {
+                QJsonObject subsectionProperties;
+                QJsonArray subsectionOrder;
+                for (int index = 0; index < section.subsectionCount; ++index)
+                {
+                    QStringView subsection = section.subsections[index];
+                    subsectionProperties[memberName(subsection)] = QJsonObject{{"type", "STRING"}};
+                    subsectionOrder.append(memberName(subsection));
+                }
+                property["type"] = "OBJECT";
+                property["properties"] = subsectionProperties;
+                property["propertyOrdering"] = subsectionOrder;
+            }
+            property["description"] = section.title.toString() + " section of the note";
+            properties[memberName(section.title)] = property;
+            order.append(memberName(section.title));
+        }
+
+        QJsonObject root;
+        root["type"] = "OBJECT";
+        root["properties"] = properties;
+        root["required"] = order;
+        root["propertyOrdering"] = order;
+        return QJsonDocument(root).toJson(QJsonDocument::Compact);
+    }();
+    return serialized;
+}
+
+/**
+ * @name parse
+ * @brief Reads a structured summary
+ * @details A section missing from the response is reported as not found,
+ * as it is when a markdown title is missing.
+ * @param[in] response: Full response of the LLM
+ * @param[out] summary: Receives the sections; unchanged if the response is
+ * not a structured summary
+ * @return True if the response is a JSON note
+ * @author Callum Thompson
+ */
+bool SummarySchema::parse(const QString &response, Summary &summary)
+{
+    QJsonDocument document = QJsonDocument::fromJson(response.toUtf8());
+    if (!document.isObject())
+    {
+        return false;
+    }
+
+    QJsonObject note = document.object();
+    bool hasSection = false;
+    for (const NoteSections::Schema &section : schema)
+    {
+        hasSection = hasSection || note.contains(memberName(section.title));
+    }
+    if (!hasSection)
+    {
+        return false;
+    }
+
+    fillSummary(note, summary, false);
+    return true;
+}
+
+/**
+ * @name parsePartial
+ * @brief Reads the sections of a structured summary that has only partly
+ * been received
+ * @details Scans the text once for the last comma between top-level
+ * members; everything ahead of it is complete and is read as an object.
+ * Sections still being written are left empty.
+ * @param[in] partialResponse: Response of the LLM received so far
+ * @param[out] summary: Receives the completed sections
+ * @return True if the response is JSON rather than markdown
+ * @author Callum Thompson
+ */
+bool SummarySchema::parsePartial(const QString &partialResponse, Summary &summary)
+{
+    QStringView text = QStringView(partialResponse).trimmed();
+    if (!text.startsWith(u'{'))
+    {
+        return false;
+    }
+
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    qsizetype end = -1; // End of the last complete member
+    for (qsizetype i = 0; i < text.size(); ++i)
+    {
+        QChar c = text[i];
+        if (inString)
+        {
+            if (escaped)
+            {
+                escaped = false;
+            }
+            else if (c == u'\\')
+            {
+                escaped = true;
+            }
+            else if (c == u'"')
+            {
+                inString = false;
+            }
+        }
+        else if (c == u'"')
+        {
+            inString = true;
+        }
+        else if (c == u'{' || c == u'[')
+        {
+            ++depth;
+        }
+        else if (c == u'}' || c == u']')
+        {
+            if (--depth == 0)
+            {
+                end = i; // The whole object has been received
+                break;
+            }
+        }
+        else if (c == u',' && depth == 1)
+        {
+            end = i;
+        }
+    }
+
+    QJsonObject note;
+    if (end != -1)
+    {
+        note = QJsonDocument::fromJson((text.first(end).toString() + u'}').toUtf8()).object();
+    }
+    fillSummary(note, summary, true);
+    return true;
+}
+
+/**
+ * @name fillSummary
+ * @brief Sets the sections of a summary from a JSON note
+ * @param[in] note: Response object, possibly holding only some sections
+ * @param[out] summary: Receives the sections
+ * @param[in] partial: True to leave missing sections empty rather than
+ * report them as not found
+ * @author Callum Thompson
+ */
+void SummarySchema::fillSummary(const QJsonObject &note, Summary &summary, bool partial)
+{
+    QStringList texts;
+    for (int index = 0; index < NoteSections::FollowUpNote; ++index)
+    {
+        QJsonValue value = note.value(memberName(schema[index].title));
+        if (value.isUndefined())
+        {
+            texts.append(partial ? QString() : NoteSections::notFoundText(NoteSections::Section(index)));
+        }
+        else
+        {
+            texts.append(sectionText(value, schema[index]));
+        }
+    }
+
+    QStringView followUpTitle = NoteSections::title(NoteSections::FollowUpNote);
+    QString followUp = note.value(memberName(followUpTitle)).toString().trimmed();
+    if (!followUp.isEmpty())
+    {
+        texts[NoteSections::Plan] += "\n\n" + followUpTitle.toString() + ":\n" + followUp;
+    }
+
+    summary.setIntervalHistory(texts[0]);
+    summary.setPhysicalExamination(texts[1]);
+    summary.setCurrentStatus(texts[2]);
+    summary.setPlan(texts[3]);
+}
+
+/**
+ * @name sectionText
+ * @brief Writes a section the way a markdown note does
+ * @param[in] section: Section member of the response
+ * @param[in] entry: Schema of the section, listing its subsections in order
+ * @return Subsections as "TITLE: text" paragraphs, or the section's text
+ * @author Callum Thompson
+ */
+QString SummarySchema::sectionText(const QJsonValue &section, const NoteSections::Schema &entry)
+{
+    if (!section.isObject())
+    {
+        return section.toString().trimmed();
+    }
+
+    QJsonObject members = section.toObject();
+    QStringList paragraphs;
+    for (int index = 0; index < entry.subsectionCount; ++index)
+    {
+        QStringView subsection = entry.subsections[index];
+        QString text = members.value(memberName(subsection)).toString().trimmed();
+        if (!text.isEmpty())
+        {
+            paragraphs.append(subsection.toString() + ": " + text);
+        }
+    }
+    return paragraphs.join("\n\n");
+}
+
+/**
+ * @name memberName
+ * @brief Returns the JSON member name of a section or subsection title
+ * @param[in] title: Title as written in the note, e.g. "HEAD & NECK"
+ * @return Lower-case name with words joined by underscores, e.g. "head_neck"
+ * @author Callum Thompson
+ */
+QString SummarySchema::memberName(QStringView title)
+{
+    static const QRegularExpression separators("[^a-z0-9]+");
+    return title.toString().toLower().replace(separators, "_");
+}
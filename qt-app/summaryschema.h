@@ -0,0 +1,42 @@
+/**
+ * @file summaryschema.h
+ * @brief Declaration of SummarySchema class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 23, 2025
+ */
+
+#ifndef SUMMARYSCHEMA_H
+#define SUMMARYSCHEMA_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include "summary.h"
+#include "notesections.h"
+
+/**
+ * @class SummarySchema
+ * @brief Structure of a summary returned as JSON
+ * @details Describes the sections and subsections of the note as a Gemini
+ * responseSchema, so the model returns them as named JSON members rather
+ * than markdown titles, and reads such a response into a Summary. Each
+ * subsection is written as "TITLE: text" in its section, as in the
+ * markdown notes; the patient follow-up note is added to the plan, where
+ * it also ends up in a markdown note.
+ * @author Callum Thompson
+ */
+class SummarySchema
+{
+public:
+    static const QByteArray &responseSchema();
+    static bool parse(const QString &response, Summary &summary);
+    static bool parsePartial(const QString &partialResponse, Summary &summary);
+
+private:
+    static void fillSummary(const QJsonObject &note, Summary &summary, bool partial);
+    static QString sectionText(const QJsonValue &section, const NoteSections::Schema &entry);
+    static QString memberName(QStringView title);
+};
+
+#endif // SUMMARYSCHEMA_H
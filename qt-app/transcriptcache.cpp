@@ -0,0 +1,147 @@
+/**
+ * @file transcriptcache.cpp
+ * @brief Definition of TranscriptCache class
+ *
+ * Transcripts are stored by DiskCache under a key built from a hash of the
+ * recording's samples.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 13, 2025
+ */
+
+#include <cstring>
+#include <QFile>
+#include <QDebug>
+#include "transcriptcache.h"
+#include "audiometadata.h"
+
+TranscriptCache *TranscriptCache::instance = nullptr;
+
+namespace
+{
+const char *const cacheDirectory = "Cache/Transcripts";
+const qint64 defaultMaximumBytes = 20 * 1024 * 1024;
+const quint64 hashPrime = 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * @name TranscriptCache (constructor)
+ * @brief Initializes a cache stored in a directory
+ * @details The directory is only read when the cache is first used.
+ * @param[in] directory: Directory holding the transcript files
+ * @author Callum Thompson
+ */
+TranscriptCache::TranscriptCache(const QString &directory) : DiskCache(directory, defaultMaximumBytes)
+{
+    // No logic body
+}
+
+/**
+ * @name getInstance
+ * @brief Returns the singleton instance of TranscriptCache
+ * @return Shared transcript cache
+ * @author Callum Thompson
+ */
+TranscriptCache *TranscriptCache::getInstance()
+{
+    if (!instance)
+    {
+        instance = new TranscriptCache(cacheDirectory);
+    }
+    return instance;
+}
+
+/**
+ * @name audioKey
+ * @brief Identifies the audio of a WAV file
+ * @details Hashes the samples of the data chunk only, so header changes
+ * that do not alter the audio still match. The format is part of the key.
+ * @param[in] audioPath: Path to the WAV file
+ * @param[in] settings: Settings the audio is prepared with before upload
+ * @return Key of the audio, or an empty string if the file cannot be read
+ * @author Callum Thompson
+ */
+QString TranscriptCache::audioKey(const QString &audioPath, const QString &settings)
+{
+    AudioMetadata metadata = AudioMetadataCache::getInstance()->lookup(audioPath);
+    if (!metadata.valid || metadata.dataSize == 0)
+    {
+        return QString();
+    }
+
+    QFile file(audioPath);
+    const uchar *data = file.open(QIODevice::ReadOnly) ? file.map(metadata.dataOffset, metadata.dataSize) : nullptr;
+    if (!data)
+    {
+        return QString();
+    }
+    quint64 hash = hashSamples(data, metadata.dataSize);
+    file.unmap(const_cast<uchar *>(data));
+
+    return QString("%1:%2:%3x%4:%5")
+        .arg(hash, 16, 16, QChar('0'))
+        .arg(metadata.dataSize)
+        .arg(metadata.sampleRate)
+        .arg(metadata.channels)
+        .arg(settings);
+}
+
+/**
+ * @name entryKey
+ * @brief Combines the audio key with the backend that transcribed it
+ * @param[in] audioKey: Key returned by audioKey()
+ * @param[in] backendName: Name of the backend
+ * @param[in] backendConfiguration: Model and settings of the backend
+ * @return Key of the transcript
+ * @author Callum Thompson
+ */
+QString TranscriptCache::entryKey(const QString &audioKey, const QString &backendName, const QString &backendConfiguration)
+{
+    return audioKey + '\n' + backendName + '\n' + backendConfiguration;
+}
+
+/**
+ * @name hashSamples
+ * @brief Hashes a block of audio
+ * @details Four independent multiply-xor lanes over 8-byte words, merged
+ * and finalized with the MurmurHash3 mixer. Runs at memory speed, so even
+ * a long recording is hashed in milliseconds. Not cryptographic; the key
+ * also holds the data size and format.
+ * @param[in] data: Bytes to hash
+ * @param[in] size: Number of bytes
+ * @return 64-bit hash
+ * @author Callum Thompson
+ */
+quint64 TranscriptCache::hashSamples(const uchar *data, qint64 size)
+{
+    quint64 lanes[4] = {hashPrime, hashPrime ^ 1, hashPrime ^ 2, hashPrime ^ 3};
+    qint64 offset = 0;
+    for (; offset + 32 <= size; offset += 32)
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            quint64 word;
+            std::memcpy(&word, data + offset + lane * 8, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * hashPrime;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+
+    quint64 hash = static_cast<quint64>(size) * hashPrime;
+    for (quint64 lane : lanes)
+    {
+        hash = (hash ^ lane) * hashPrime;
+        hash ^= hash >> 32;
+    }
+    for (; offset < size; ++offset)
+    {
+        hash = (hash ^ data[offset]) * 0x100000001B3ULL;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file transcriptcache.h
+ * @brief Declaration of TranscriptCache class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 13, 2025
+ */
+
+#ifndef TRANSCRIPTCACHE_H
+#define TRANSCRIPTCACHE_H
+
+#include <QString>
+#include "diskcache.h"
+
+/**
+ * @class TranscriptCache
+ * @brief Keeps the transcripts of recordings on disk, keyed by their audio
+ * @details A recording is identified by a hash of the samples in its WAV
+ * data chunk, so re-running, retrying or replaying the same audio finds
+ * the stored transcript even if the file was copied or renamed. Entries
+ * are also keyed by the backend, its model and the settings the audio was
+ * prepared with, so changing any of them transcribes the audio again.
+ * The least recently used entries are deleted once the cache grows past
+ * its size limit. Lookups are thread-safe so worker threads can check the
+ * cache before encoding.
+ * @author Callum Thompson
+ */
+class TranscriptCache : public DiskCache
+{
+public:
+    static TranscriptCache *getInstance();
+
+    static QString audioKey(const QString &audioPath, const QString &settings);
+    static QString entryKey(const QString &audioKey, const QString &backendName, const QString &backendConfiguration);
+
+private:
+    explicit TranscriptCache(const QString &directory);
+
+    static TranscriptCache *instance;
+
+    static quint64 hashSamples(const uchar *data, qint64 size);
+};
+
+#endif // TRANSCRIPTCACHE_H
@@ -0,0 +1,202 @@
+/**
+ * @file transcriptionbackend.cpp
+ * @brief Definition of TranscriptionRequest and NetworkTranscriptionRequest
+ * classes
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#include "transcriptionbackend.h"
+
+/**
+ * @name TranscriptionRequest (constructor)
+ * @brief Initializes a request that has not finished
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+TranscriptionRequest::TranscriptionRequest(QObject *parent)
+    : QObject(parent)
+{
+    // No logic body
+}
+
+/**
+ * @name networkReply
+ * @brief Returns the HTTP reply carrying the request, if any
+ * @return Reply, or nullptr for requests that do not use the network
+ * @author Callum Thompson
+ */
+QNetworkReply *TranscriptionRequest::networkReply() const
+{
+    return nullptr;
+}
+
+/**
+ * @name isSuccessful
+ * @brief Returns whether the audio was transcribed
+ * @return True if the request finished with a transcript
+ * @author Callum Thompson
+ */
+bool TranscriptionRequest::isSuccessful() const
+{
+    return successful;
+}
+
+/**
+ * @name isNetworkFailure
+ * @brief Returns whether the request failed because the service could not
+ * be reached
+ * @details Such failures are worth retrying with a backend that does not
+ * need the network.
+ * @return True if the service was unreachable
+ * @author Callum Thompson
+ */
+bool TranscriptionRequest::isNetworkFailure() const
+{
+    return networkFailure;
+}
+
+/**
+ * @name errorString
+ * @brief Returns the reason the request failed
+ * @return Error message, or an empty string if the request succeeded
+ * @author Callum Thompson
+ */
+const QString &TranscriptionRequest::errorString() const
+{
+    return error;
+}
+
+/**
+ * @name text
+ * @brief Returns the transcribed text
+ * @return Text of the whole audio
+ * @author Callum Thompson
+ */
+const QString &TranscriptionRequest::text() const
+{
+    return transcribedText;
+}
+
+/**
+ * @name segments
+ * @brief Returns the transcribed text split into timed segments
+ * @details Times are relative to the start of the audio sent. Backends
+ * without timestamps return the whole text as one segment at zero.
+ * @return Segments in order
+ * @author Callum Thompson
+ */
+const QList<TranscriptSegment> &TranscriptionRequest::segments() const
+{
+    return timedSegments;
+}
+
+/**
+ * @name succeed
+ * @brief Ends the request with a transcript
+ * @param[in] text: Text of the whole audio
+ * @param[in] segments: Timed segments; derived from the text if empty
+ * @author Callum Thompson
+ */
+void TranscriptionRequest::succeed(const QString &text, const QList<TranscriptSegment> &segments)
+{
+    successful = true;
+    transcribedText = text;
+    timedSegments = segments;
+    if (timedSegments.isEmpty() && !text.trimmed().isEmpty())
+    {
+        timedSegments.append({0.0, text.trimmed()});
+    }
+    emit finished();
+}
+
+/**
+ * @name fail
+ * @brief Ends the request with an error
+ * @param[in] errorMessage: Description of the failure
+ * @param[in] unreachable: True if the service could not be reached
+ * @author Callum Thompson
+ */
+void TranscriptionRequest::fail(const QString &errorMessage, bool unreachable)
+{
+    successful = false;
+    networkFailure = unreachable;
+    error = errorMessage;
+    emit finished();
+}
+
+/**
+ * @name NetworkTranscriptionRequest (constructor)
+ * @brief Wraps a sent HTTP request
+ * @param[in] reply: Reply of the request; ownership is taken
+ * @param[in] parser: Extracts the transcript from the response body
+ * @author Callum Thompson
+ */
+NetworkTranscriptionRequest::NetworkTranscriptionRequest(QNetworkReply *reply, Parser parser)
+    : reply(reply), parser(std::move(parser))
+{
+    reply->setParent(this);
+    connect(reply, &QNetworkReply::uploadProgress, this, &TranscriptionRequest::uploadProgress);
+    connect(reply, &QNetworkReply::finished, this, &NetworkTranscriptionRequest::handleFinished);
+}
+
+/**
+ * @name abort
+ * @brief Aborts the HTTP request
+ * @details finished() is still emitted, reporting the request as failed.
+ * @author Callum Thompson
+ */
+void NetworkTranscriptionRequest::abort()
+{
+    if (reply && reply->isRunning())
+    {
+        reply->abort();
+    }
+}
+
+/**
+ * @name networkReply
+ * @brief Returns the HTTP reply carrying the request
+ * @return Reply of the request
+ * @author Callum Thompson
+ */
+QNetworkReply *NetworkTranscriptionRequest::networkReply() const
+{
+    return reply;
+}
+
+/**
+ * @name handleFinished
+ * @brief Parses the response once the HTTP request has ended
+ * @author Callum Thompson
+ */
+void NetworkTranscriptionRequest::handleFinished()
+{
+    switch (reply->error())
+    {
+    case QNetworkReply::NoError:
+        break;
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+        fail(reply->errorString(), true);
+        return;
+    default:
+        fail(reply->errorString());
+        return;
+    }
+
+    QString text;
+    QList<TranscriptSegment> segments;
+    if (!parser(reply->readAll(), text, segments))
+    {
+        fail("Invalid response format");
+        return;
+    }
+    succeed(text, segments);
+}
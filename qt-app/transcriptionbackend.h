@@ -0,0 +1,137 @@
+/**
+ * @file transcriptionbackend.h
+ * @brief Declaration of TranscriptionBackend interface and the
+ * TranscriptionRequest classes its implementations return
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#ifndef TRANSCRIPTIONBACKEND_H
+#define TRANSCRIPTIONBACKEND_H
+
+#include <functional>
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QPointer>
+#include <QString>
+#include <QtNetwork/QNetworkReply>
+
+/**
+ * @struct TranscriptSegment
+ * @brief Transcribed text starting at a time in the audio that was sent
+ * @author Callum Thompson
+ */
+struct TranscriptSegment
+{
+    double startSecs;
+    QString text;
+};
+
+/**
+ * @struct BackendCapabilities
+ * @brief What a transcription backend accepts and how it may be used
+ * @details Limits of zero mean there is no limit.
+ * @author Callum Thompson
+ */
+struct BackendCapabilities
+{
+    bool requiresNetwork = true;     // Audio is sent to a remote service
+    bool acceptsFlac = true;         // Can be sent the FLAC encoding of a recording
+    bool requiresPcm16 = false;      // Can only read 16-bit PCM WAV files
+    bool providesTimestamps = false; // Reports when each segment starts
+    double maxDurationSecs = 0.0;    // Longest audio accepted in one request
+    qint64 maxUploadBytes = 0;       // Largest audio accepted in one request
+    int maxConcurrentRequests = 0;   // Requests worth running at once
+};
+
+/**
+ * @class TranscriptionRequest
+ * @brief Transcription of one piece of audio in progress
+ * @details Emits finished() exactly once, whether it succeeded, failed or
+ * was aborted. The owner deletes the request after handling finished().
+ * @author Callum Thompson
+ */
+class TranscriptionRequest : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TranscriptionRequest(QObject *parent = nullptr);
+
+    virtual void abort() = 0;
+    virtual QNetworkReply *networkReply() const;
+
+    bool isSuccessful() const;
+    bool isNetworkFailure() const;
+    const QString &errorString() const;
+    const QString &text() const;
+    const QList<TranscriptSegment> &segments() const;
+
+signals:
+    void uploadProgress(qint64 bytesSent, qint64 bytesTotal); // Audio sent so far
+    void finished();                                           // Request has ended
+
+protected:
+    void succeed(const QString &text, const QList<TranscriptSegment> &segments);
+    void fail(const QString &errorMessage, bool networkFailure = false);
+
+private:
+    bool successful = false;
+    bool networkFailure = false;
+    QString error;
+    QString transcribedText;
+    QList<TranscriptSegment> timedSegments;
+};
+
+/**
+ * @class NetworkTranscriptionRequest
+ * @brief TranscriptionRequest carried by a single HTTP request
+ * @details The response body is turned into text by the parser supplied by
+ * the backend. The reply is owned by the request.
+ * @author Callum Thompson
+ */
+class NetworkTranscriptionRequest : public TranscriptionRequest
+{
+    Q_OBJECT
+
+public:
+    using Parser = std::function<bool(const QByteArray &response, QString &text, QList<TranscriptSegment> &segments)>;
+
+    NetworkTranscriptionRequest(QNetworkReply *reply, Parser parser);
+
+    void abort() override;
+    QNetworkReply *networkReply() const override;
+
+private:
+    QPointer<QNetworkReply> reply;
+    Parser parser;
+
+    void handleFinished();
+};
+
+/**
+ * @class TranscriptionBackend
+ * @brief Speech-to-text engine that AudioHandler can send recordings to
+ * @details Describes its limits and expected latency so AudioHandler can
+ * pick the fastest backend that can process a recording, and starts
+ * requests without blocking. configuration() names the model and settings
+ * requests are sent with, so cached transcripts made under other settings
+ * are not reused.
+ * @author Callum Thompson
+ */
+class TranscriptionBackend
+{
+public:
+    virtual ~TranscriptionBackend() = default;
+
+    virtual QString name() const = 0;
+    virtual QString configuration() const = 0;
+    virtual BackendCapabilities capabilities() const = 0;
+    virtual bool isAvailable() const = 0;
+    virtual double expectedLatencySecs(double audioSecs) const = 0;
+    virtual TranscriptionRequest *start(const QString &audioPath, const QByteArray &flac) = 0;
+};
+
+#endif // TRANSCRIPTIONBACKEND_H
@@ -0,0 +1,189 @@
+/**
+ * @file transcriptionjob.cpp
+ * @brief Definition of TranscriptionJob class
+ *
+ * Tracks a transcription request running in the background, reporting its
+ * progress and result through signals.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 3, 2025
+ */
+
+#include "transcriptionjob.h"
+
+/**
+ * @name TranscriptionJob (constructor)
+ * @brief Initializes a new transcription job
+ * @details Jobs are only created by AudioHandler.
+ * @param[in] id: Unique job identifier
+ * @param[in] audioPath: Path to the audio file being transcribed
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+TranscriptionJob::TranscriptionJob(int id, const QString &audioPath, QObject *parent)
+    : QObject(parent), id(id), audioPath(audioPath)
+{
+    // No logic body
+}
+
+/**
+ * @name getId
+ * @brief Returns the unique identifier of the job
+ * @return Job identifier
+ * @author Callum Thompson
+ */
+int TranscriptionJob::getId() const
+{
+    return id;
+}
+
+/**
+ * @name getAudioPath
+ * @brief Returns the path of the audio file being transcribed
+ * @return Audio file path
+ * @author Callum Thompson
+ */
+const QString &TranscriptionJob::getAudioPath() const
+{
+    return audioPath;
+}
+
+/**
+ * @name isDone
+ * @brief Returns whether the job has finished, failed or been cancelled
+ * @return True once the job's final signal has been emitted
+ * @author Callum Thompson
+ */
+bool TranscriptionJob::isDone() const
+{
+    return done;
+}
+
+/**
+ * @name getTimeMap
+ * @brief Returns how the uploaded audio maps onto the original recording
+ * @details Silence is removed before upload, so times reported by the
+ * transcription service must be converted with this map to line up with
+ * the recording. The map is empty (the identity) until the upload starts.
+ * @return Map from uploaded to original audio times
+ * @author Callum Thompson
+ */
+const TrimmedAudioMap &TranscriptionJob::getTimeMap() const
+{
+    return timeMap;
+}
+
+/**
+ * @name cancel
+ * @brief Cancels the job
+ * @details Aborts any requests still in flight and emits cancelled(). Has no
+ * effect if the job has already ended.
+ * @author Callum Thompson
+ */
+void TranscriptionJob::cancel()
+{
+    if (done)
+    {
+        return;
+    }
+    done = true;
+
+    // Abort outstanding requests; their finished() handlers see the job is done
+    const QList<QPointer<TranscriptionRequest>> running = requests;
+    for (const QPointer<TranscriptionRequest> &request : running)
+    {
+        if (request)
+        {
+            request->abort();
+        }
+    }
+
+    emit cancelled();
+    deleteLater();
+}
+
+/**
+ * @name attachRequest
+ * @brief Registers a request sent on behalf of this job
+ * @details Reports the request's upload progress and allows the request to
+ * be aborted when the job is cancelled.
+ * @param[in] request: Request in flight
+ * @author Callum Thompson
+ */
+void TranscriptionJob::attachRequest(TranscriptionRequest *request)
+{
+    requests.append(request);
+    connect(request, &TranscriptionRequest::uploadProgress, this, [this, request](qint64 bytesSent, qint64 bytesTotal)
+            { updateProgress(request, bytesSent, bytesTotal); });
+}
+
+/**
+ * @name setExpectedUploadSize
+ * @brief Sets the combined size of all requests the job will send
+ * @details Used when a recording is uploaded in chunks that are not all
+ * sent at once, so progress does not jump back as each chunk starts.
+ * @param[in] bytes: Total bytes to upload
+ * @author Callum Thompson
+ */
+void TranscriptionJob::setExpectedUploadSize(qint64 bytes)
+{
+    expectedUploadBytes = bytes;
+}
+
+/**
+ * @name updateProgress
+ * @brief Emits the combined upload progress of all requests of the job
+ * @param[in] request: Request that reported progress
+ * @param[in] bytesSent: Bytes sent by that request
+ * @param[in] bytesTotal: Total bytes of that request
+ * @author Callum Thompson
+ */
+void TranscriptionJob::updateProgress(TranscriptionRequest *request, qint64 bytesSent, qint64 bytesTotal)
+{
+    uploads.insert(request, qMakePair(bytesSent, bytesTotal));
+
+    qint64 sent = 0;
+    qint64 total = 0;
+    for (const QPair<qint64, qint64> &upload : std::as_const(uploads))
+    {
+        sent += upload.first;
+        total += upload.second;
+    }
+    emit progress(sent, qMax(total, expectedUploadBytes));
+}
+
+/**
+ * @name complete
+ * @brief Ends the job successfully
+ * @param[in] transcript: Transcribed text of the audio file
+ * @author Callum Thompson
+ */
+void TranscriptionJob::complete(const Transcript &transcript)
+{
+    if (done)
+    {
+        return;
+    }
+    done = true;
+
+    emit finished(transcript);
+    deleteLater();
+}
+
+/**
+ * @name fail
+ * @brief Ends the job with an error
+ * @param[in] errorMessage: Description of the failure
+ * @author Callum Thompson
+ */
+void TranscriptionJob::fail(const QString &errorMessage)
+{
+    if (done)
+    {
+        return;
+    }
+    done = true;
+
+    emit failed(errorMessage);
+    deleteLater();
+}
@@ -0,0 +1,71 @@
+/**
+ * @file transcriptionjob.h
+ * @brief Declaration of TranscriptionJob class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 3, 2025
+ */
+
+#ifndef TRANSCRIPTIONJOB_H
+#define TRANSCRIPTIONJOB_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QPointer>
+#include "transcript.h"
+#include "transcriptionbackend.h"
+#include "voiceactivitydetector.h"
+
+/**
+ * @class TranscriptionJob
+ * @brief Handle to a single transcription running in the background
+ * @details Returned by AudioHandler::transcribe(). The job reports upload
+ * progress while its audio is sent and ends by emitting exactly one of
+ * finished(), failed() or cancelled(). Several jobs may be in flight at once;
+ * none of them block the event loop. The job deletes itself after its final
+ * signal has been emitted, so callers that keep the pointer should hold it in
+ * a QPointer.
+ * @author Callum Thompson
+ */
+class TranscriptionJob : public QObject
+{
+    Q_OBJECT
+
+    friend class AudioHandler;
+
+public:
+    int getId() const;
+    const QString &getAudioPath() const;
+    bool isDone() const;
+    const TrimmedAudioMap &getTimeMap() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(qint64 bytesSent, qint64 bytesTotal); // Upload progress of the audio
+    void finished(const Transcript &transcript);        // Transcription succeeded
+    void failed(const QString &errorMessage);           // Transcription could not be completed
+    void cancelled();                                   // Job was cancelled before completing
+
+private:
+    TranscriptionJob(int id, const QString &audioPath, QObject *parent);
+
+    int id;
+    QString audioPath;
+    bool done = false;
+    QList<QPointer<TranscriptionRequest>> requests; // Requests sent for this job
+    TrimmedAudioMap timeMap;                // Maps the uploaded audio back to the recording
+    QString cacheKey;                       // Key of the audio in TranscriptCache, or empty if not cached
+    QHash<TranscriptionRequest *, QPair<qint64, qint64>> uploads; // Bytes sent and total of each request
+    qint64 expectedUploadBytes = 0;         // Total of all requests, including those not yet sent
+
+    void attachRequest(TranscriptionRequest *request);
+    void setExpectedUploadSize(qint64 bytes);
+    void updateProgress(TranscriptionRequest *request, qint64 bytesSent, qint64 bytesTotal);
+    void complete(const Transcript &transcript);
+    void fail(const QString &errorMessage);
+};
+
+#endif // TRANSCRIPTIONJOB_H
@@ -0,0 +1,231 @@
+/**
+ * @file transcriptstitcher.cpp
+ * @brief Definition of TranscriptStitcher class
+ *
+ * Assembles the transcriptions of overlapping recording segments into a single
+ * transcript, removing the words duplicated by the overlap.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 2, 2025
+ */
+
+#include <QRegularExpression>
+#include <QVector>
+#include "transcriptstitcher.h"
+
+namespace
+{
+// Fastest speech expected, so the overlap holds at most this many words a second
+const int maximumWordsPerSecond = 4;
+
+// Words cut off at a boundary, which are searched along with the overlap
+const int boundaryWords = 2;
+
+// Slowest speech expected, so the overlap holds at least this many words a second
+const int minimumWordsPerSecond = 2;
+
+// Bounds on the run of matching words accepted as an overlap. Runs shorter
+// than the lower bound, such as "the patient", repeat too often in speech to
+// be told from the overlap; the upper bound is enough for any overlap.
+const int shortestOverlapWords = 3;
+const int longestOverlapWords = 6;
+}
+
+/**
+ * @name addSegment
+ * @brief Stores the transcription of a single segment
+ * @details Segments may be added in any order. Adding a segment with an index
+ * that already exists replaces the stored text.
+ * @param[in] index: Position of the segment in the recording
+ * @param[in] text: Transcribed text of the segment
+ * @author Callum Thompson
+ */
+void TranscriptStitcher::addSegment(int index, const QString &text)
+{
+    segments.insert(index, text.trimmed());
+}
+
+/**
+ * @name setOverlap
+ * @brief Sets the audio shared by consecutive segments
+ * @details Only the words that fit in the overlap are searched for it, so
+ * a phrase repeated further from the boundary is never taken for it.
+ * @param[in] newOverlapSecs: Seconds both segments record at each boundary
+ * @author Callum Thompson
+ */
+void TranscriptStitcher::setOverlap(int newOverlapSecs)
+{
+    overlapSecs = qMax(0, newOverlapSecs);
+}
+
+/**
+ * @name segmentCount
+ * @brief Returns the number of segments stored
+ * @return Number of segments added since the last clear
+ * @author Callum Thompson
+ */
+int TranscriptStitcher::segmentCount() const
+{
+    return segments.size();
+}
+
+/**
+ * @name clear
+ * @brief Removes all stored segments
+ * @author Callum Thompson
+ */
+void TranscriptStitcher::clear()
+{
+    segments.clear();
+}
+
+/**
+ * @name stitch
+ * @brief Joins the stored segments into one transcript
+ * @details Segments are joined in index order. At every boundary the overlap
+ * shared by the two segments is kept only once.
+ * @return Full transcript text
+ * @author Callum Thompson
+ */
+QString TranscriptStitcher::stitch() const
+{
+    static const QRegularExpression whitespace("\\s+");
+
+    QStringList words;
+    for (const QString &text : segments)
+    {
+        if (text.isEmpty())
+        {
+            continue; // Silent segments contribute nothing
+        }
+        appendWithoutOverlap(words, text.split(whitespace, Qt::SkipEmptyParts), searchWords(), minimumWords());
+    }
+
+    return words.join(' ');
+}
+
+/**
+ * @name searchWords
+ * @brief Returns the number of words at each side of a boundary searched
+ * for the overlap
+ * @return Most words that can be spoken in the overlap, plus those cut off
+ * @author Callum Thompson
+ */
+int TranscriptStitcher::searchWords() const
+{
+    return overlapSecs * maximumWordsPerSecond + boundaryWords;
+}
+
+/**
+ * @name minimumWords
+ * @brief Returns the shortest run of matching words accepted as the overlap
+ * @details Even slow speech fills the overlap with this many words, so a
+ * short overlap is still found while a long one needs a longer match.
+ * @return Fewest words slowly spoken in the overlap, within fixed bounds
+ * @author Callum Thompson
+ */
+int TranscriptStitcher::minimumWords() const
+{
+    return qMin(longestOverlapWords, qMax(shortestOverlapWords, overlapSecs * minimumWordsPerSecond));
+}
+
+/**
+ * @name normalizeWord
+ * @brief Reduces a word to a form suitable for comparison
+ * @details Lowercases the word and removes punctuation, since the two
+ * transcriptions of the overlap rarely punctuate it the same way.
+ * @param[in] word: Word to normalize
+ * @return Normalized word
+ * @author Callum Thompson
+ */
+QString TranscriptStitcher::normalizeWord(const QString &word)
+{
+    QString normalized;
+    normalized.reserve(word.size());
+    for (const QChar &c : word)
+    {
+        if (c.isLetterOrNumber())
+        {
+            normalized.append(c.toLower());
+        }
+    }
+    return normalized;
+}
+
+/**
+ * @name appendWithoutOverlap
+ * @brief Appends the words of the next segment, skipping the shared overlap
+ * @details Finds the longest run of matching words between the end of the
+ * transcript so far and the start of the next segment. Words after the run in
+ * the earlier segment (usually a word cut off by the segment boundary) and
+ * words before the run in the next segment are dropped. Unless the run is
+ * long enough to be the overlap with confidence, both segments are kept in
+ * full; a repeated phrase is better than lost speech.
+ * @param[in,out] words: Transcript words assembled so far
+ * @param[in] nextWords: Words of the next segment
+ * @param[in] searchLength: Words at each side of the boundary searched
+ * @param[in] minimumLength: Shortest run accepted as the overlap
+ * @author Callum Thompson
+ */
+void TranscriptStitcher::appendWithoutOverlap(QStringList &words, const QStringList &nextWords, int searchLength,
+                                              int minimumLength)
+{
+    if (searchLength < minimumLength)
+    {
+        words.append(nextWords); // The overlap is too short to be found
+        return;
+    }
+
+    const int tailStart = qMax(0, words.size() - searchLength);
+    const int tailLength = words.size() - tailStart;
+    const int headLength = qMin(nextWords.size(), searchLength);
+
+    QStringList tail;
+    for (int i = 0; i < tailLength; ++i)
+    {
+        tail.append(normalizeWord(words[tailStart + i]));
+    }
+    QStringList head;
+    for (int j = 0; j < headLength; ++j)
+    {
+        head.append(normalizeWord(nextWords[j]));
+    }
+
+    // Longest common run of words, computed one row at a time
+    int bestLength = 0;
+    int bestTailEnd = 0;
+    int bestHeadEnd = 0;
+    QVector<int> previousRow(headLength + 1, 0);
+    QVector<int> currentRow(headLength + 1, 0);
+    for (int i = 1; i <= tailLength; ++i)
+    {
+        for (int j = 1; j <= headLength; ++j)
+        {
+            if (!tail[i - 1].isEmpty() && tail[i - 1] == head[j - 1])
+            {
+                currentRow[j] = previousRow[j - 1] + 1;
+                if (currentRow[j] > bestLength)
+                {
+                    bestLength = currentRow[j];
+                    bestTailEnd = i;
+                    bestHeadEnd = j;
+                }
+            }
+            else
+            {
+                currentRow[j] = 0;
+            }
+        }
+        previousRow.swap(currentRow);
+    }
+
+    if (bestLength < minimumLength)
+    {
+        words.append(nextWords); // No confident overlap, keep both sides
+        return;
+    }
+
+    // Keep the earlier segment up to the end of the overlap, then continue after it
+    words.erase(words.begin() + tailStart + bestTailEnd, words.end());
+    words.append(nextWords.mid(bestHeadEnd));
+}
@@ -0,0 +1,51 @@
+/**
+ * @file transcriptstitcher.h
+ * @brief Declaration of TranscriptStitcher class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 2, 2025
+ */
+
+#ifndef TRANSCRIPTSTITCHER_H
+#define TRANSCRIPTSTITCHER_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class TranscriptStitcher
+ * @brief Joins per-segment transcriptions into one ordered transcript
+ * @details Segments of a recording are transcribed independently and may
+ * complete in any order. Each segment is stored by its index and the full text
+ * is assembled in index order. Consecutive segments overlap by a few seconds of
+ * audio, so the words spoken during the overlap appear at the end of one
+ * segment and the start of the next. The stitcher finds the longest run of
+ * matching words within the overlap at each boundary and keeps only one
+ * copy of it, if the run is long enough to be trusted.
+ * @author Callum Thompson
+ */
+class TranscriptStitcher
+{
+public:
+    TranscriptStitcher() = default;
+
+    void setOverlap(int overlapSecs);
+    void addSegment(int index, const QString &text);
+    int segmentCount() const;
+    void clear();
+
+    QString stitch() const;
+
+private:
+    QMap<int, QString> segments; // Segment text keyed by segment index
+    int overlapSecs = 2;         // Audio shared by consecutive segments
+
+    int searchWords() const;
+    int minimumWords() const;
+    static QString normalizeWord(const QString &word);
+    static void appendWithoutOverlap(QStringList &words, const QStringList &nextWords, int searchLength,
+                                     int minimumLength);
+};
+
+#endif // TRANSCRIPTSTITCHER_H
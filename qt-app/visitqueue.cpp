@@ -0,0 +1,274 @@
+/**
+ * @file visitqueue.cpp
+ * @brief Definition of VisitQueue class
+ *
+ * Pipelines the work of each visit (record, transcribe, save, summarize) so
+ * the clinician can record the next patient while earlier visits finish.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 14, 2025
+ */
+
+#include <QDebug>
+#include "visitqueue.h"
+#include "audiohandler.h"
+#include "filehandler.h"
+#include "llmclient.h"
+#include "summarygenerator.h"
+
+/**
+ * @name VisitQueue (constructor)
+ * @brief Connects the queue to the recorder
+ * @param[in] parent: Parent object in Qt application
+ * @author Callum Thompson
+ */
+VisitQueue::VisitQueue(QObject *parent) : QObject(parent)
+{
+    AudioHandler *audioHandler = AudioHandler::getInstance();
+    connect(audioHandler, &AudioHandler::segmentedRecordingStopped, this, &VisitQueue::handleRecordingStopped);
+    connect(audioHandler, &AudioHandler::segmentedTranscriptionCompleted, this, &VisitQueue::handleTranscribed);
+    connect(audioHandler, &AudioHandler::segmentedTranscriptionFailed, this, &VisitQueue::handleTranscriptionFailed);
+}
+
+/**
+ * @name startVisit
+ * @brief Starts recording a visit of a patient
+ * @details The visit is recorded to a new file in the patient's folder.
+ * @param[in] patientID: Patient being seen
+ * @return True if recording started, false if the previous visit is still
+ * being recorded
+ * @author Callum Thompson
+ */
+bool VisitQueue::startVisit(int patientID)
+{
+    if (activeRecording != 0)
+    {
+        return false;
+    }
+
+    QString audioPath = FileHandler::getInstance()->newVisitAudioPath(patientID);
+    int recordingId = AudioHandler::getInstance()->startSegmentedRecording(audioPath);
+    if (recordingId == 0)
+    {
+        return false;
+    }
+
+    qInfo() << "Recording visit of patient" << patientID << "to" << audioPath;
+    activeRecording = recordingId;
+    recordingPatients.insert(recordingId, patientID);
+    emit pendingVisitsChanged(pendingVisits());
+    return true;
+}
+
+/**
+ * @name stopVisit
+ * @brief Stops recording the current visit
+ * @details recordingStopped() is emitted once the recording has been
+ * finalized; its transcript and summary follow in the background.
+ * @author Callum Thompson
+ */
+void VisitQueue::stopVisit()
+{
+    if (activeRecording != 0)
+    {
+        AudioHandler::getInstance()->stopSegmentedRecording();
+    }
+}
+
+/**
+ * @name isRecording
+ * @brief Returns whether a visit is being recorded
+ * @return True from startVisit() until recordingStopped() is emitted
+ * @author Callum Thompson
+ */
+bool VisitQueue::isRecording() const
+{
+    return activeRecording != 0;
+}
+
+/**
+ * @name summarize
+ * @brief Summarizes a patient's saved transcript
+ * @details Requests sent earlier for the patient are superseded; their
+ * responses are ignored. An unchanged transcript shares the call of the
+ * earlier request, and a transcript summarized before returns the stored
+ * summary unless it is regenerated. A transcript that has grown since the
+ * saved summary was generated amends that summary, if LLMClient is set to;
+ * one that has not grown keeps it.
+ * @param[in] patientID: Patient to summarize
+ * @param[in] regenerate: True to generate a new summary even if one is stored
+ * @author Callum Thompson
+ */
+void VisitQueue::summarize(int patientID, bool regenerate)
+{
+    QString transcript = FileHandler::getInstance()->loadTranscript(patientID).trimmed();
+    if (transcript.isEmpty())
+    {
+        qWarning() << "No transcript to summarize for patient" << patientID;
+        emit summaryFailed(patientID);
+        return;
+    }
+
+    LLMRequest *request = nullptr;
+    qsizetype summarizedChars = regenerate ? 0 : FileHandler::getInstance()->loadSummaryMark(patientID, transcript);
+    if (summarizedChars > 0)
+    {
+        QString previousSummary = FileHandler::getInstance()->loadSummaryText(patientID);
+        request = LLMClient::getInstance()->amendSummary(previousSummary, transcript, summarizedChars, patientID);
+    }
+    else
+    {
+        request = LLMClient::getInstance()->summarize(transcript, patientID, regenerate);
+    }
+    connect(request, &LLMRequest::partialResponse, this, [this, request](const QString &textSoFar)
+            {
+                if (summaryRequests.value(request->getContext().toInt()) == request)
+                {
+                    emit summaryProgress(request->getContext().toInt(), textSoFar);
+                }
+            });
+    connect(request, &LLMRequest::finished, this, [this, request](const QString &summaryText)
+            { handleSummary(request, summaryText); });
+    connect(request, &LLMRequest::failed, this, [this, request](const QString &errorMessage)
+            { handleSummaryFailed(request, errorMessage); });
+    summaryRequests.insert(patientID, request);
+    summaryTranscripts.insert(patientID, transcript);
+    emit pendingVisitsChanged(pendingVisits());
+}
+
+/**
+ * @name pendingVisits
+ * @brief Returns the number of visits whose work has not finished
+ * @return Visits being recorded, transcribed or summarized
+ * @author Callum Thompson
+ */
+int VisitQueue::pendingVisits() const
+{
+    return recordingPatients.size() + summaryRequests.size();
+}
+
+/**
+ * @name handleRecordingStopped
+ * @brief Frees the recorder for the next visit
+ * @param[in] recordingId: Recording that was stopped
+ * @author Callum Thompson
+ */
+void VisitQueue::handleRecordingStopped(int recordingId)
+{
+    if (recordingId != activeRecording)
+    {
+        return;
+    }
+
+    activeRecording = 0;
+    emit recordingStopped(recordingPatients.value(recordingId));
+}
+
+/**
+ * @name handleTranscribed
+ * @brief Saves the transcript of a visit and queues its summary
+ * @details An empty transcript is not saved, so the patient's existing
+ * transcript is never overwritten with nothing.
+ * @param[in] recordingId: Recording that was transcribed
+ * @param[in] transcript: Stitched transcript of the recording
+ * @author Callum Thompson
+ */
+void VisitQueue::handleTranscribed(int recordingId, const Transcript &transcript)
+{
+    if (!recordingPatients.contains(recordingId))
+    {
+        return; // Not recorded through this queue
+    }
+    if (transcript.getContent().trimmed().isEmpty())
+    {
+        handleTranscriptionFailed(recordingId, "The recording has no speech");
+        return;
+    }
+    int patientID = recordingPatients.take(recordingId);
+
+    //  Overwrite 'transcript_raw.txt' for summarizer
+    FileHandler::getInstance()->saveTranscript(patientID, transcript.getContent());
+
+    //  Append to timestamped raw log
+    FileHandler::getInstance()->saveOrAppendRawTranscript(patientID, transcript);
+
+    emit visitTranscribed(patientID, transcript);
+    summarize(patientID);
+}
+
+/**
+ * @name handleTranscriptionFailed
+ * @brief Reports a visit that could not be transcribed in full
+ * @details Nothing is saved, so the patient's transcript and summary stay
+ * as they were.
+ * @param[in] recordingId: Recording that failed
+ * @param[in] errorMessage: Reason for the failure
+ * @author Callum Thompson
+ */
+void VisitQueue::handleTranscriptionFailed(int recordingId, const QString &errorMessage)
+{
+    if (!recordingPatients.contains(recordingId))
+    {
+        return; // Not recorded through this queue
+    }
+
+    int patientID = recordingPatients.take(recordingId);
+    qWarning() << "Transcription of the visit of patient" << patientID << "failed:" << errorMessage;
+    emit transcriptionFailed(patientID, errorMessage);
+    emit pendingVisitsChanged(pendingVisits());
+}
+
+/**
+ * @name handleSummary
+ * @brief Saves a summary for the patient it was generated for
+ * @details The text is saved along with its parsed record.
+ * @param[in] request: Request that finished
+ * @param[in] summaryText: Response of the LLM
+ * @author Callum Thompson
+ */
+void VisitQueue::handleSummary(LLMRequest *request, const QString &summaryText)
+{
+    int patientID = request->getContext().toInt();
+    if (summaryRequests.value(patientID) != request)
+    {
+        return; // Superseded by a newer summary
+    }
+
+    summaryRequests.remove(patientID);
+    QString transcript = summaryTranscripts.take(patientID);
+    if (FileHandler::getInstance()->saveSummaryText(patientID, summaryText))
+    {
+        FileHandler::getInstance()->saveSummaryMark(patientID, transcript);
+
+        // Parse once here so opening the patient reads the sections directly
+        SummaryGenerator generator;
+        generator.setSummaryText(summaryText);
+        FileHandler::getInstance()->saveSummaryRecord(patientID, generator.getSummary(),
+                                                      LLMClient::getInstance()->model(),
+                                                      LLMClient::getInstance()->promptVersion());
+    }
+    emit summaryReady(patientID, summaryText);
+    emit pendingVisitsChanged(pendingVisits());
+}
+
+/**
+ * @name handleSummaryFailed
+ * @brief Reports a summary that could not be generated
+ * @param[in] request: Request that failed
+ * @param[in] errorMessage: Reason for the failure
+ * @author Callum Thompson
+ */
+void VisitQueue::handleSummaryFailed(LLMRequest *request, const QString &errorMessage)
+{
+    int patientID = request->getContext().toInt();
+    if (summaryRequests.value(patientID) != request)
+    {
+        return; // Superseded by a newer summary
+    }
+
+    qWarning() << "Summary of patient" << patientID << "failed:" << errorMessage;
+    summaryRequests.remove(patientID);
+    summaryTranscripts.remove(patientID);
+    emit summaryFailed(patientID);
+    emit pendingVisitsChanged(pendingVisits());
+}
@@ -0,0 +1,68 @@
+/**
+ * @file visitqueue.h
+ * @brief Declaration of VisitQueue class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 14, 2025
+ */
+
+#ifndef VISITQUEUE_H
+#define VISITQUEUE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include "transcript.h"
+#include "llmrequest.h"
+
+/**
+ * @class VisitQueue
+ * @brief Records patient visits and finishes their paperwork in the
+ * background
+ * @details Each visit is recorded to its own file in the patient's folder.
+ * Once recording stops the microphone is free for the next visit, while the
+ * stopped visit is transcribed, its transcript saved and its summary
+ * generated and saved, all for the patient it was recorded for. Visits are
+ * transcribed and summarized concurrently; each summary request carries the
+ * patient it was sent for. Only the newest summary of a patient is kept,
+ * since it covers the whole day's transcript. The length of transcript each
+ * saved summary covers is recorded, so the summary can be amended with
+ * just the visits added since.
+ * @author Callum Thompson
+ */
+class VisitQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VisitQueue(QObject *parent = nullptr);
+
+    bool startVisit(int patientID);
+    void stopVisit();
+    bool isRecording() const;
+    void summarize(int patientID, bool regenerate = false);
+    int pendingVisits() const;
+
+signals:
+    void recordingStopped(int patientID);                               // The next visit may be recorded
+    void visitTranscribed(int patientID, const Transcript &transcript); // Transcript has been saved
+    void transcriptionFailed(int patientID, const QString &errorMessage); // Nothing was saved for the visit
+    void summaryProgress(int patientID, const QString &textSoFar);      // Summary is being streamed
+    void summaryReady(int patientID, const QString &summaryText);       // Summary has been saved
+    void summaryFailed(int patientID);                                  // No summary could be generated
+    void pendingVisitsChanged(int count);                               // Visits still being processed
+
+private:
+    QHash<int, int> recordingPatients; // Patient of each recording still being transcribed, by recording id
+    int activeRecording = 0;           // Recording the microphone is capturing, or 0
+    QHash<int, QPointer<LLMRequest>> summaryRequests; // Newest summary request of each patient
+    QHash<int, QString> summaryTranscripts;           // Transcript each patient's newest request summarizes
+
+    void handleRecordingStopped(int recordingId);
+    void handleTranscribed(int recordingId, const Transcript &transcript);
+    void handleTranscriptionFailed(int recordingId, const QString &errorMessage);
+    void handleSummary(LLMRequest *request, const QString &summaryText);
+    void handleSummaryFailed(LLMRequest *request, const QString &errorMessage);
+};
+
+#endif // VISITQUEUE_H
@@ -0,0 +1,450 @@
+/**
+ * @file voiceactivitydetector.cpp
+ * @brief Definition of VoiceActivityDetector and TrimmedAudioMap classes
+ *
+ * Removes the long silences of a visit recording (examinations, typing,
+ * the patient changing) before it is uploaded for transcription.
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 8, 2025
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "voiceactivitydetector.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VAD_SSE2
+#endif
+
+namespace
+{
+const int frameMs = 20;            // Length of an analysis frame
+const int hangoverMs = 300;        // Speech is held this long after the last speech frame
+const int preRollMs = 100;         // Speech starts this long before the first speech frame
+const float speechMarginDb = 9.0f; // Level above the noise floor that counts as speech
+const float quietMarginDb = 4.0f;  // Level above the noise floor for fricatives
+const float minimumSpeechDb = 30.0f; // Absolute level below which nothing is speech
+const float fricativeZcr = 0.3f;   // Zero-crossing rate of unvoiced consonants
+}
+
+/**
+ * @name setSampleRate
+ * @brief Sets the sample rate used to convert frames to seconds
+ * @param[in] newSampleRate: Sample rate in Hz
+ * @author Callum Thompson
+ */
+void TrimmedAudioMap::setSampleRate(int newSampleRate)
+{
+    sampleRate = newSampleRate;
+}
+
+/**
+ * @name setOriginalFrames
+ * @brief Sets the length of the original recording
+ * @param[in] frames: Number of frames in the original recording
+ * @author Callum Thompson
+ */
+void TrimmedAudioMap::setOriginalFrames(qint64 frames)
+{
+    originalFrames = frames;
+}
+
+/**
+ * @name appendSpan
+ * @brief Records that a span of the original follows the previous spans
+ * @param[in] originalStart: First frame of the span in the original
+ * @param[in] length: Number of frames in the span
+ * @author Callum Thompson
+ */
+void TrimmedAudioMap::appendSpan(qint64 originalStart, qint64 length)
+{
+    spans.append({keptFrames, originalStart, length});
+    keptFrames += length;
+}
+
+/**
+ * @name appendMap
+ * @brief Appends the spans of another map after the spans of this one
+ * @details Used to describe a recording uploaded as several chunks.
+ * @param[in] other: Map whose spans follow this map's spans
+ * @author Callum Thompson
+ */
+void TrimmedAudioMap::appendMap(const TrimmedAudioMap &other)
+{
+    for (const Span &span : other.spans)
+    {
+        appendSpan(span.originalStart, span.length);
+    }
+}
+
+/**
+ * @name toOriginalSecs
+ * @brief Converts a time in the trimmed audio to the original recording
+ * @param[in] trimmedSecs: Seconds from the start of the trimmed audio
+ * @return Seconds from the start of the original recording
+ * @author Callum Thompson
+ */
+double TrimmedAudioMap::toOriginalSecs(double trimmedSecs) const
+{
+    if (spans.isEmpty() || sampleRate <= 0)
+    {
+        return trimmedSecs;
+    }
+
+    qint64 frame = static_cast<qint64>(trimmedSecs * sampleRate);
+    auto span = std::upper_bound(spans.cbegin(), spans.cend(), frame,
+                                 [](qint64 value, const Span &s) { return value < s.trimmedStart; });
+    if (span != spans.cbegin())
+    {
+        --span;
+    }
+    qint64 offset = qBound<qint64>(0, frame - span->trimmedStart, span->length);
+    return static_cast<double>(span->originalStart + offset) / sampleRate;
+}
+
+/**
+ * @name keptSecs
+ * @brief Returns the length of the trimmed audio
+ * @return Seconds of audio kept
+ * @author Callum Thompson
+ */
+double TrimmedAudioMap::keptSecs() const
+{
+    return sampleRate > 0 ? static_cast<double>(keptFrames) / sampleRate : 0.0;
+}
+
+/**
+ * @name removedSecs
+ * @brief Returns how much of the original recording was removed
+ * @return Seconds of audio removed
+ * @author Callum Thompson
+ */
+double TrimmedAudioMap::removedSecs() const
+{
+    if (sampleRate <= 0 || spans.isEmpty())
+    {
+        return 0.0;
+    }
+    return static_cast<double>(qMax<qint64>(0, originalFrames - keptFrames)) / sampleRate;
+}
+
+/**
+ * @name VoiceActivityDetector (constructor)
+ * @brief Creates a detector for interleaved 16-bit audio
+ * @param[in] sampleRate: Sample rate in Hz
+ * @param[in] channels: Number of interleaved channels, averaged for analysis
+ * @author Callum Thompson
+ */
+VoiceActivityDetector::VoiceActivityDetector(int sampleRate, int channels)
+    : sampleRate(qMax(1, sampleRate)), channels(qMax(1, channels))
+{
+    frameLength = qMax(1, this->sampleRate * frameMs / 1000);
+}
+
+/**
+ * @name setMinimumSilence
+ * @brief Sets the shortest silence that is compressed
+ * @param[in] milliseconds: Minimum silence length
+ * @author Callum Thompson
+ */
+void VoiceActivityDetector::setMinimumSilence(int milliseconds)
+{
+    minimumSilenceMs = qMax(0, milliseconds);
+}
+
+/**
+ * @name setKeptSilence
+ * @brief Sets the length long silences are compressed to
+ * @param[in] milliseconds: Length of the pause left in place of a silence
+ * @author Callum Thompson
+ */
+void VoiceActivityDetector::setKeptSilence(int milliseconds)
+{
+    keptSilenceMs = qMax(0, milliseconds);
+}
+
+/**
+ * @name detectSpeech
+ * @brief Returns the spans of a recording to keep
+ * @details The noise floor is the 10th percentile of the frame levels, so
+ * the detector adapts to the room and microphone gain.
+ * @param[in] samples: Interleaved 16-bit samples
+ * @param[in] frames: Number of frames
+ * @return Spans to keep in order, or an empty list if no speech was found
+ * @author Callum Thompson
+ */
+QList<VoiceActivityDetector::Span> VoiceActivityDetector::detectSpeech(const qint16 *samples, qint64 frames) const
+{
+    QList<Span> kept;
+    qint64 frameCount = (frames + frameLength - 1) / frameLength;
+    if (frameCount == 0)
+    {
+        return kept;
+    }
+
+    // Level (dB re 1 LSB) and zero-crossing rate of each frame
+    QVector<float> levels(frameCount);
+    QVector<float> crossingRates(frameCount);
+    QVector<qint16> mono(channels > 1 ? frameLength : 0);
+    for (qint64 f = 0; f < frameCount; ++f)
+    {
+        qint64 start = f * frameLength;
+        int count = static_cast<int>(qMin<qint64>(frameLength, frames - start));
+        const qint16 *frame = samples + start * channels;
+
+        if (channels > 1)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                int sum = 0;
+                for (int c = 0; c < channels; ++c)
+                {
+                    sum += frame[i * channels + c];
+                }
+                mono[i] = static_cast<qint16>(sum / channels);
+            }
+            frame = mono.constData();
+        }
+
+        quint64 energy;
+        int crossings;
+        frameStatistics(frame, count, energy, crossings);
+        levels[f] = 10.0f * std::log10(static_cast<float>(energy) / count + 1.0f);
+        crossingRates[f] = count > 1 ? static_cast<float>(crossings) / (count - 1) : 0.0f;
+    }
+
+    QVector<float> sorted = levels;
+    std::nth_element(sorted.begin(), sorted.begin() + frameCount / 10, sorted.end());
+    float noiseFloor = sorted[frameCount / 10];
+    float speechLevel = qMax(noiseFloor + speechMarginDb, minimumSpeechDb);
+    float quietLevel = qMax(noiseFloor + quietMarginDb, minimumSpeechDb - 6.0f);
+
+    // Classify frames, holding each decision for the pre-roll and hangover
+    int preRoll = preRollMs / frameMs;
+    int hangover = hangoverMs / frameMs;
+    QVector<bool> active(frameCount, false);
+    bool anySpeech = false;
+    for (qint64 f = 0; f < frameCount; ++f)
+    {
+        bool speech = levels[f] > speechLevel || (levels[f] > quietLevel && crossingRates[f] > fricativeZcr);
+        if (!speech)
+        {
+            continue;
+        }
+        anySpeech = true;
+        qint64 last = qMin<qint64>(frameCount - 1, f + hangover);
+        for (qint64 g = qMax<qint64>(0, f - preRoll); g <= last; ++g)
+        {
+            active[g] = true;
+        }
+    }
+    if (!anySpeech)
+    {
+        return kept;
+    }
+
+    // Collect runs of active frames as sample spans, bridging short silences
+    qint64 minimumSilence = static_cast<qint64>(sampleRate) * minimumSilenceMs / 1000;
+    qint64 pad = static_cast<qint64>(sampleRate) * keptSilenceMs / 2000;
+    for (qint64 f = 0; f < frameCount;)
+    {
+        if (!active[f])
+        {
+            ++f;
+            continue;
+        }
+        qint64 runEnd = f;
+        while (runEnd < frameCount && active[runEnd])
+        {
+            ++runEnd;
+        }
+
+        qint64 start = f * frameLength;
+        qint64 end = qMin(frames, runEnd * frameLength);
+        if (!kept.isEmpty() && start - kept.last().end <= minimumSilence)
+        {
+            kept.last().end = end;
+        }
+        else
+        {
+            kept.append({start, end});
+        }
+        f = runEnd;
+    }
+
+    // Leave a short pause in place of each long silence
+    for (int i = 0; i < kept.size(); ++i)
+    {
+        qint64 lowest = i == 0 ? 0 : kept[i - 1].end;
+        qint64 highest = i + 1 < kept.size() ? kept[i + 1].start : frames;
+        kept[i].start = qMax(lowest, kept[i].start - pad);
+        kept[i].end = qMin(highest, kept[i].end + pad);
+    }
+    return kept;
+}
+
+/**
+ * @name splitIntoChunks
+ * @brief Groups the kept spans of a long recording into upload chunks
+ * @details A chunk is closed once it holds at least `targetFrames` and may
+ * grow to 25% beyond that. A chunk preferably ends at one of the silences
+ * between spans; a span too long to fit is cut at its quietest 20 ms
+ * frame within 10% of the target, so words are not split.
+ * @param[in] spans: Spans to keep, as returned by detectSpeech()
+ * @param[in] samples: Interleaved 16-bit samples of the whole recording
+ * @param[in] targetFrames: Preferred number of frames per chunk
+ * @return Spans of each chunk, in order
+ * @author Callum Thompson
+ */
+QList<QList<VoiceActivityDetector::Span>> VoiceActivityDetector::splitIntoChunks(const QList<Span> &spans, const qint16 *samples, qint64 targetFrames) const
+{
+    QList<QList<Span>> chunks;
+    QList<Span> current;
+    qint64 currentLength = 0;
+    qint64 maxFrames = targetFrames + targetFrames / 4;
+
+    auto closeChunk = [&]()
+    {
+        if (!current.isEmpty())
+        {
+            chunks.append(current);
+            current.clear();
+            currentLength = 0;
+        }
+    };
+
+    for (Span span : spans)
+    {
+        while (span.start < span.end)
+        {
+            qint64 length = span.end - span.start;
+            if (currentLength + length <= maxFrames)
+            {
+                current.append(span);
+                currentLength += length;
+                if (currentLength >= targetFrames)
+                {
+                    closeChunk();
+                }
+                break;
+            }
+
+            // End the chunk at the silence before this span if it is long enough
+            if (currentLength >= targetFrames / 2)
+            {
+                closeChunk();
+                continue;
+            }
+
+            // Otherwise cut the span at its quietest point near the target
+            qint64 wanted = targetFrames - currentLength;
+            qint64 window = targetFrames / 10;
+            qint64 cut = quietestPoint(samples, span.start + wanted - window,
+                                       span.start + qMin(wanted + window, maxFrames - currentLength));
+            current.append({span.start, cut});
+            closeChunk();
+            span.start = cut;
+        }
+    }
+    closeChunk();
+    return chunks;
+}
+
+/**
+ * @name quietestPoint
+ * @brief Finds the middle of the quietest analysis frame in a range
+ * @param[in] samples: Interleaved 16-bit samples of the whole recording
+ * @param[in] from: First frame of the range
+ * @param[in] to: End of the range (exclusive)
+ * @return Frame index to cut at
+ * @author Callum Thompson
+ */
+qint64 VoiceActivityDetector::quietestPoint(const qint16 *samples, qint64 from, qint64 to) const
+{
+    qint64 best = from;
+    quint64 bestEnergy = ~0ull;
+    for (qint64 f = from; f + frameLength <= to; f += frameLength)
+    {
+        quint64 energy;
+        int crossings;
+        frameStatistics(samples + f * channels, frameLength * channels, energy, crossings);
+        if (energy < bestEnergy)
+        {
+            bestEnergy = energy;
+            best = f + frameLength / 2;
+        }
+    }
+    return best;
+}
+
+/**
+ * @name frameStatistics
+ * @brief Computes the energy and zero crossings of a frame
+ * @details Uses SSE2 on x86 to square and sum eight samples at a time and
+ * to count sign changes between neighbouring samples.
+ * @param[in] samples: Mono 16-bit samples
+ * @param[in] count: Number of samples
+ * @param[out] energy: Sum of squared samples
+ * @param[out] crossings: Number of sign changes between consecutive samples
+ * @author Callum Thompson
+ */
+void VoiceActivityDetector::frameStatistics(const qint16 *samples, int count, quint64 &energy, int &crossings)
+{
+    energy = 0;
+    crossings = 0;
+    int i = 0;
+
+#ifdef VAD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i energySum = _mm_setzero_si128();   // Two 64-bit lanes
+    __m128i crossingSum = _mm_setzero_si128(); // Eight 16-bit lanes
+    int vectorCount = 0;
+    for (; i + 8 < count; i += 8)
+    {
+        __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i + 1));
+
+        // Pairwise sums of squares fit in 32 unsigned bits; widen to 64 before adding
+        __m128i squares = _mm_madd_epi16(current, current);
+        energySum = _mm_add_epi64(energySum, _mm_unpacklo_epi32(squares, zero));
+        energySum = _mm_add_epi64(energySum, _mm_unpackhi_epi32(squares, zero));
+
+        // A sign change sets the sign bit of the XOR; subtracting -1 counts it
+        crossingSum = _mm_sub_epi16(crossingSum, _mm_srai_epi16(_mm_xor_si128(current, next), 15));
+
+        // Flush the 16-bit counters before they can overflow
+        if (++vectorCount == 4096)
+        {
+            alignas(16) quint16 lanes[8];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), crossingSum);
+            for (quint16 lane : lanes)
+            {
+                crossings += lane;
+            }
+            crossingSum = _mm_setzero_si128();
+            vectorCount = 0;
+        }
+    }
+
+    alignas(16) quint64 energyLanes[2];
+    alignas(16) quint16 crossingLanes[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(energyLanes), energySum);
+    _mm_store_si128(reinterpret_cast<__m128i *>(crossingLanes), crossingSum);
+    energy = energyLanes[0] + energyLanes[1];
+    for (quint16 lane : crossingLanes)
+    {
+        crossings += lane;
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        energy += static_cast<quint64>(static_cast<qint64>(samples[i]) * samples[i]);
+        if (i + 1 < count && ((samples[i] ^ samples[i + 1]) < 0))
+        {
+            ++crossings;
+        }
+    }
+}
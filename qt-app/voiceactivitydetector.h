@@ -0,0 +1,95 @@
+/**
+ * @file voiceactivitydetector.h
+ * @brief Declaration of VoiceActivityDetector and TrimmedAudioMap classes
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 8, 2025
+ */
+
+#ifndef VOICEACTIVITYDETECTOR_H
+#define VOICEACTIVITYDETECTOR_H
+
+#include <QList>
+#include <QVector>
+
+/**
+ * @class TrimmedAudioMap
+ * @brief Maps positions in trimmed audio back to the original recording
+ * @details Records which spans of the original recording were kept, in
+ * order, so a timestamp reported for the trimmed audio (e.g. a transcript
+ * segment start) can be converted to the matching time in the recording.
+ * An empty map is the identity.
+ * @author Callum Thompson
+ */
+class TrimmedAudioMap
+{
+public:
+    void setSampleRate(int sampleRate);
+    void setOriginalFrames(qint64 frames);
+    void appendSpan(qint64 originalStart, qint64 length);
+    void appendMap(const TrimmedAudioMap &other);
+
+    double toOriginalSecs(double trimmedSecs) const;
+    double keptSecs() const;
+    double removedSecs() const;
+
+private:
+    /**
+     * @brief Run of frames copied unchanged from the original
+     */
+    struct Span
+    {
+        qint64 trimmedStart;
+        qint64 originalStart;
+        qint64 length;
+    };
+
+    QVector<Span> spans;
+    int sampleRate = 0;
+    qint64 originalFrames = 0;
+    qint64 keptFrames = 0;
+};
+
+/**
+ * @class VoiceActivityDetector
+ * @brief Finds the spans of a recording that contain speech
+ * @details The recording is cut into 20 ms frames and each frame is
+ * classified from its energy, relative to the recording's own noise floor,
+ * and its zero-crossing rate, which catches quiet fricatives. Speech
+ * decisions are held for a hangover period and start slightly early so
+ * word edges are not clipped. Silences longer than the minimum are
+ * compressed to a short pause rather than removed outright, keeping
+ * sentence boundaries audible to the recognizer.
+ * @author Callum Thompson
+ */
+class VoiceActivityDetector
+{
+public:
+    /**
+     * @brief Frame range [start, end) of the original recording to keep
+     */
+    struct Span
+    {
+        qint64 start;
+        qint64 end;
+    };
+
+    VoiceActivityDetector(int sampleRate, int channels);
+
+    void setMinimumSilence(int milliseconds);
+    void setKeptSilence(int milliseconds);
+    QList<Span> detectSpeech(const qint16 *samples, qint64 frames) const;
+    QList<QList<Span>> splitIntoChunks(const QList<Span> &spans, const qint16 *samples, qint64 targetFrames) const;
+
+private:
+    int sampleRate;
+    int channels;
+    int frameLength;             // Samples per analysis frame
+    int minimumSilenceMs = 1000; // Shorter silences are kept entirely
+    int keptSilenceMs = 300;     // Length a long silence is compressed to
+
+    qint64 quietestPoint(const qint16 *samples, qint64 from, qint64 to) const;
+    static void frameStatistics(const qint16 *samples, int count, quint64 &energy, int &crossings);
+};
+
+#endif // VOICEACTIVITYDETECTOR_H
@@ -0,0 +1,223 @@
+/**
+ * @file whisperbackend.cpp
+ * @brief Definition of WhisperBackend class
+ *
+ * @author Andres Pedreros Castro (apedrero@uwo.ca)
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHttpMultiPart>
+#include <QHttpPart>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QUrl>
+#include <QDebug>
+#include "whisperbackend.h"
+
+namespace
+{
+const double baseLatencySecs = 2.0;     // Upload setup and queueing on the service
+const double latencyPerAudioSec = 0.03; // Processing time per second of audio
+}
+
+/**
+ * @name WhisperBackend (constructor)
+ * @brief Initializes the backend without an API key
+ * @details Registers the OpenAI host so connections to it are opened ahead
+ * of the first upload.
+ * @param[in] networkManager: Network manager requests are sent with
+ * @author Callum Thompson
+ */
+WhisperBackend::WhisperBackend(NetworkManager *networkManager)
+    : networkManager(networkManager)
+{
+    networkManager->addHost(QUrl("https://api.openai.com"));
+}
+
+/**
+ * @name setApiKey
+ * @brief Sets the OpenAI API key
+ * @param[in] key: API key
+ * @author Callum Thompson
+ */
+void WhisperBackend::setApiKey(const QString &key)
+{
+    apiKey = key;
+}
+
+/**
+ * @name name
+ * @brief Returns the name of the backend
+ * @return "Whisper (OpenAI)"
+ * @author Callum Thompson
+ */
+QString WhisperBackend::name() const
+{
+    return "Whisper (OpenAI)";
+}
+
+/**
+ * @name configuration
+ * @brief Returns the model and response format requests use
+ * @return Configuration of the backend
+ * @author Callum Thompson
+ */
+QString WhisperBackend::configuration() const
+{
+    return "whisper-1;verbose_json";
+}
+
+/**
+ * @name capabilities
+ * @brief Returns the limits of the Whisper API
+ * @return Capabilities of the backend
+ * @author Callum Thompson
+ */
+BackendCapabilities WhisperBackend::capabilities() const
+{
+    BackendCapabilities caps;
+    caps.requiresNetwork = true;
+    caps.acceptsFlac = true;
+    caps.requiresPcm16 = false;
+    caps.providesTimestamps = true;
+    caps.maxUploadBytes = 25 * 1024 * 1024;
+    return caps;
+}
+
+/**
+ * @name isAvailable
+ * @brief Returns whether requests can be sent
+ * @return True if an API key has been set
+ * @author Callum Thompson
+ */
+bool WhisperBackend::isAvailable() const
+{
+    return !apiKey.isEmpty();
+}
+
+/**
+ * @name expectedLatencySecs
+ * @brief Estimates the time to transcribe audio of a given length
+ * @param[in] audioSecs: Length of the audio sent
+ * @return Expected seconds from sending to receiving the transcript
+ * @author Callum Thompson
+ */
+double WhisperBackend::expectedLatencySecs(double audioSecs) const
+{
+    return baseLatencySecs + latencyPerAudioSec * audioSecs;
+}
+
+/**
+ * @name start
+ * @brief Sends the audio file to the Whisper API for transcription
+ * @details This function prepares the audio file and sends it to the Whisper API for transcription.
+ * It sets the necessary headers and returns without waiting for the response.
+ * The FLAC encoding is sent if available, otherwise the WAV file is streamed.
+ * Segment timestamps are requested with the verbose_json response format.
+ * @param[in] audioPath: Path to the audio file
+ * @param[in] flac: FLAC encoding of the audio file, or empty to send the WAV file
+ * @return Request in flight, or nullptr if the request could not be sent
+ * @author Callum Thompson
+ */
+TranscriptionRequest *WhisperBackend::start(const QString &audioPath, const QByteArray &flac)
+{
+    // Abort if OpenAI API key is missing
+    if (apiKey.isEmpty())
+    {
+        qWarning() << "OpenAI API Key is empty!";
+        return nullptr;
+    }
+
+    // Set up the OpenAI Whisper endpoint and request
+    QUrl url("https://api.openai.com/v1/audio/transcriptions");
+    QNetworkRequest request(url);
+
+    // Add authorization header using bearer token
+    QString bearerToken = "Bearer " + apiKey;
+    request.setRawHeader("Authorization", bearerToken.toUtf8());
+
+    // Create multipart form data for the POST request
+    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+
+    // Add the audio to the multipart body, as FLAC when it could be encoded
+    QHttpPart filePart;
+    if (!flac.isEmpty())
+    {
+        QString fileName = QFileInfo(audioPath).completeBaseName() + ".flac";
+        filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                           QVariant("form-data; name=\"file\"; filename=\"" + fileName + "\""));
+        filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/flac"));
+        filePart.setBody(flac);
+    }
+    else
+    {
+        QFile *file = new QFile(audioPath);
+        if (!file->open(QIODevice::ReadOnly))
+        {
+            qWarning() << "Failed to open file for Whisper API:" << audioPath;
+            delete file;
+            delete multiPart;
+            return nullptr;
+        }
+        filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                           QVariant("form-data; name=\"file\"; filename=\"" + QFileInfo(audioPath).fileName() + "\""));
+        filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/wav"));
+        filePart.setBodyDevice(file);
+        file->setParent(multiPart); // Ensure file is cleaned up with multipart
+    }
+    multiPart->append(filePart);
+
+    // Specify the model name ("whisper-1")
+    QHttpPart modelPart;
+    modelPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"model\""));
+    modelPart.setBody("whisper-1");
+    multiPart->append(modelPart);
+
+    // Request segment timestamps so chunked transcripts can be merged in order
+    QHttpPart formatPart;
+    formatPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"response_format\""));
+    formatPart.setBody("verbose_json");
+    multiPart->append(formatPart);
+
+    // Send the POST request
+    QNetworkReply *reply = networkManager->post(request, multiPart);
+    multiPart->setParent(reply); // Cleanup when reply is finished
+    return new NetworkTranscriptionRequest(reply, &WhisperBackend::parseResponse);
+}
+
+/**
+ * @name parseResponse
+ * @brief Extracts the transcript from a Whisper verbose_json response
+ * @param[in] response: Raw JSON response
+ * @param[out] text: Receives the text of the whole audio
+ * @param[out] segments: Receives the timed segments
+ * @return True if the response is valid
+ * @author Callum Thompson
+ */
+bool WhisperBackend::parseResponse(const QByteArray &response, QString &text, QList<TranscriptSegment> &segments)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(response);
+    if (!doc.isObject())
+    {
+        return false;
+    }
+
+    // Whisper returns a flat "text" field alongside the segments
+    QJsonObject object = doc.object();
+    text = object.value("text").toString();
+    for (const QJsonValue &value : object.value("segments").toArray())
+    {
+        QJsonObject segment = value.toObject();
+        QString segmentText = segment.value("text").toString().trimmed();
+        if (!segmentText.isEmpty())
+        {
+            segments.append({segment.value("start").toDouble(), segmentText});
+        }
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file whisperbackend.h
+ * @brief Declaration of WhisperBackend class
+ *
+ * @author Callum Thompson (cthom226@uwo.ca)
+ * @date Apr. 11, 2025
+ */
+
+#ifndef WHISPERBACKEND_H
+#define WHISPERBACKEND_H
+
+#include "networkmanager.h"
+#include "transcriptionbackend.h"
+
+/**
+ * @class WhisperBackend
+ * @brief Transcribes with the OpenAI Whisper API
+ * @details Accepts recordings of any length up to the 25 MB upload limit
+ * and reports segment timestamps.
+ * @author Callum Thompson
+ */
+class WhisperBackend : public TranscriptionBackend
+{
+public:
+    explicit WhisperBackend(NetworkManager *networkManager);
+
+    void setApiKey(const QString &key);
+
+    QString name() const override;
+    QString configuration() const override;
+    BackendCapabilities capabilities() const override;
+    bool isAvailable() const override;
+    double expectedLatencySecs(double audioSecs) const override;
+    TranscriptionRequest *start(const QString &audioPath, const QByteArray &flac) override;
+
+private:
+    NetworkManager *networkManager;
+    QString apiKey;
+
+    static bool parseResponse(const QByteArray &response, QString &text, QList<TranscriptSegment> &segments);
+};
+
+#endif // WHISPERBACKEND_H